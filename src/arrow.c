@@ -0,0 +1,989 @@
+/*** arrow.c -- arrow ipc file printer
+ *
+ * Copyright (C) 2026 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of uterus.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+/* Writes the Arrow IPC file format (aka Feather V2), i.e.
+ *   ARROW1\0\0 <schema> <record batch>... <dictionary> <footer> ARROW1
+ * with one row per price/quantity pair:
+ *   ts     timestamp[ms, UTC]
+ *   sym    dictionary<int32, utf8>
+ *   ttf    uint16
+ *   price  float64, or int64 in units of 10^-scale
+ *   qty    float64, or int64 in units of 10^-scale
+ * Snapshots and bid/ask packs become a bid row and an ask row,
+ * candles are not exported.
+ * The metadata is flatbuffers, we build those by hand, front to back. */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "utefile.h"
+#include "ute-print.h"
+#include "boobs.h"
+#include "nifty.h"
+
+/* so we know about ticks, candles and snapshots */
+#include "sl1t.h"
+#include "ssnp.h"
+
+#undef DEFINE_GORY_STUFF
+#include "m30.h"
+#include "m62.h"
+
+#define BATCH_INC	(65536U)
+
+/* arrow's enums, from Schema.fbs and Message.fbs */
+#define ARROW_V5		(4)
+#define ARROW_TYPE_INT		(2)
+#define ARROW_TYPE_FLOAT	(3)
+#define ARROW_TYPE_UTF8		(5)
+#define ARROW_TYPE_TIMESTAMP	(10)
+#define ARROW_PREC_DOUBLE	(2)
+#define ARROW_UNIT_MSEC		(1)
+#define ARROW_HDR_SCHEMA	(1)
+#define ARROW_HDR_DICTIONARY	(2)
+#define ARROW_HDR_RECBATCH	(3)
+
+static char arrow_magic[8U] = "ARROW1\0";
+static uint8_t zeroes[8U];
+
+
+/* flatbuffers */
+struct fb_s {
+	uint8_t *b;
+	size_t n;
+	size_t z;
+};
+
+static size_t
+fb_grow(struct fb_s *fb, size_t len)
+{
+/* reserve LEN zeroed bytes at the end of FB, return their offset */
+	size_t res = fb->n;
+
+	if (UNLIKELY(fb->n + len > fb->z)) {
+		size_t nu = fb->z ?: 256U;
+
+		while (nu < fb->n + len) {
+			nu *= 2U;
+		}
+		fb->b = realloc(fb->b, nu);
+		fb->z = nu;
+	}
+	memset(fb->b + fb->n, 0, len);
+	fb->n += len;
+	return res;
+}
+
+static inline void
+fb_algn(struct fb_s *fb, size_t a)
+{
+	(void)fb_grow(fb, (a - fb->n % a) % a);
+	return;
+}
+
+static inline void
+fb_set(struct fb_s *fb, size_t at, const void *v, size_t z)
+{
+	memcpy(fb->b + at, v, z);
+	return;
+}
+
+/* flatbuffers are little-endian, whatever the host */
+static inline void
+fb_u16(struct fb_s *fb, size_t at, uint16_t v)
+{
+	v = htole16(v);
+	memcpy(fb->b + at, &v, sizeof(v));
+	return;
+}
+
+static inline void
+fb_u32(struct fb_s *fb, size_t at, uint32_t v)
+{
+	v = htole32(v);
+	memcpy(fb->b + at, &v, sizeof(v));
+	return;
+}
+
+static inline void
+fb_u64(struct fb_s *fb, size_t at, uint64_t v)
+{
+	v = htole64(v);
+	memcpy(fb->b + at, &v, sizeof(v));
+	return;
+}
+
+static void
+fb_ref(struct fb_s *fb, size_t at, size_t to)
+{
+/* have the uoffset at AT point to TO */
+	fb_u32(fb, at, (uint32_t)(to - at));
+	return;
+}
+
+static size_t
+fb_tab(struct fb_s *fb, size_t at, size_t nf, const uint8_t fsz[], size_t fo[])
+{
+/* write a table with NF fields of sizes FSZ (0 for absent fields),
+ * the offset of field i goes into FO[i], the uoffset at AT is made
+ * to point to the table, the table's offset is returned */
+	uint16_t vt[2U + nf];
+	size_t vto;
+	size_t res;
+	uint16_t sz = sizeof(int32_t);
+
+	/* lay out the fields, tables are 8-aligned so natural alignment
+	 * relative to the table start is good enough */
+	for (size_t i = 0; i < nf; i++) {
+		if (fsz[i]) {
+			sz += (uint16_t)((fsz[i] - sz % fsz[i]) % fsz[i]);
+			vt[2U + i] = sz;
+			sz += fsz[i];
+		} else {
+			vt[2U + i] = 0U;
+		}
+	}
+	vt[0U] = (uint16_t)sizeof(vt);
+	vt[1U] = sz;
+
+	fb_algn(fb, sizeof(*vt));
+	vto = fb_grow(fb, sizeof(vt));
+	for (size_t i = 0; i < countof(vt); i++) {
+		fb_u16(fb, vto + i * sizeof(*vt), vt[i]);
+	}
+	fb_algn(fb, 8U);
+	res = fb_grow(fb, sz);
+	/* soffset to the vtable */
+	fb_u32(fb, res, (uint32_t)(res - vto));
+	for (size_t i = 0; i < nf; i++) {
+		fo[i] = res + vt[2U + i];
+	}
+	fb_ref(fb, at, res);
+	return res;
+}
+
+static size_t
+fb_vec(struct fb_s *fb, size_t at, size_t nel, size_t elsz)
+{
+/* write a vector of NEL elements of size ELSZ, referenced from AT,
+ * return the offset of its first element */
+	const size_t a = elsz > 4U ? elsz : 4U;
+	size_t res;
+
+	/* we want the elements aligned, the length sits right before them */
+	(void)fb_grow(fb, (a - (fb->n + 4U) % a) % a);
+	res = fb_grow(fb, 4U + nel * elsz);
+	fb_ref(fb, at, res);
+	fb_u32(fb, res, (uint32_t)nel);
+	return res + 4U;
+}
+
+static void
+fb_str(struct fb_s *fb, size_t at, const char *s)
+{
+	const size_t len = strlen(s);
+	size_t o;
+
+	o = fb_vec(fb, at, len, 1U);
+	fb_set(fb, o, s, len);
+	/* and the \nul, not counted */
+	(void)fb_grow(fb, 1U);
+	return;
+}
+
+
+/* our context */
+typedef struct actx_s *actx_t;
+
+struct blk_s {
+	int64_t off;
+	int32_t mlen;
+	int32_t:32;
+	int64_t blen;
+};
+
+struct actx_s {
+	int fd;
+	/* bytes written so far */
+	size_t off;
+	/* scratch flatbuffer */
+	struct fb_s fb[1U];
+
+	/* the current batch */
+	size_t nbatch;
+	size_t n;
+	int64_t *ts;
+	int32_t *sym;
+	uint16_t *ttf;
+	union {
+		double d;
+		int64_t i;
+	} *px, *qx;
+	uint8_t *pv, *qv;
+
+	/* record batches so far, for the footer */
+	struct blk_s *rbs;
+	size_t nrbs;
+	size_t zrbs;
+	struct blk_s dict;
+
+	/* the dictionary, names and their utf8 offsets */
+	char *dat;
+	size_t ndat;
+	size_t zdat;
+	int32_t *dof;
+	size_t ndic;
+	size_t zdic;
+	/* file symbol index to dictionary index, per ute context */
+	utectx_t u;
+	int32_t *i2d;
+	size_t ni2d;
+
+	/* >= 0 if prices and quantities are scaled integers */
+	int scale;
+};
+
+static int
+wr_iov(actx_t ctx, struct iovec *iov, int niov)
+{
+	size_t tot = 0U;
+	ssize_t nwr;
+
+	for (int i = 0; i < niov; i++) {
+		tot += iov[i].iov_len;
+	}
+	while (tot > 0U) {
+		if ((nwr = writev(ctx->fd, iov, niov)) <= 0) {
+			return -1;
+		}
+		ctx->off += nwr;
+		tot -= nwr;
+		/* skip over what's gone out */
+		for (; niov > 0 && (size_t)nwr >= iov->iov_len; iov++, niov--) {
+			nwr -= iov->iov_len;
+		}
+		if (niov > 0) {
+			iov->iov_base = (char*)iov->iov_base + nwr;
+			iov->iov_len -= nwr;
+		}
+	}
+	return 0;
+}
+
+static int
+wr_msg(actx_t ctx, struct blk_s *b, struct iovec *body, int nbody)
+{
+/* write the flatbuffer in ctx->fb as encapsulated message,
+ * followed by NBODY body buffers, each padded to 8 bytes */
+	const size_t fbn = ctx->fb->n;
+	struct iovec iov[2U * nbody + 3U];
+	/* metadata length includes the padding to 8 bytes */
+	const size_t mlen = fbn + (8U - fbn % 8U) % 8U;
+	uint32_t pre[2U] = {0xffffffffU, htole32((uint32_t)mlen)};
+	size_t blen = 0U;
+	int niov = 0;
+
+	iov[niov++] = (struct iovec){pre, sizeof(pre)};
+	iov[niov++] = (struct iovec){ctx->fb->b, fbn};
+	iov[niov++] = (struct iovec){zeroes, mlen - fbn};
+	for (int i = 0; i < nbody; i++) {
+		const size_t pad = (8U - body[i].iov_len % 8U) % 8U;
+
+		iov[niov++] = body[i];
+		iov[niov++] = (struct iovec){zeroes, pad};
+		blen += body[i].iov_len + pad;
+	}
+	if (b != NULL) {
+		*b = (struct blk_s){
+			.off = (int64_t)ctx->off,
+			.mlen = (int32_t)(sizeof(pre) + mlen),
+			.blen = (int64_t)blen,
+		};
+	}
+	return wr_iov(ctx, iov, niov);
+}
+
+static size_t
+fb_msg(struct fb_s *fb, uint8_t hdr, size_t blen, size_t *hat)
+{
+/* start a fresh flatbuffer with a Message table,
+ * put the offset of the header field into HAT */
+	static const uint8_t fsz[] = {2U, 1U, 4U, 8U};
+	size_t fo[countof(fsz)];
+	size_t res;
+
+	fb->n = 0U;
+	/* root uoffset */
+	(void)fb_grow(fb, 4U);
+	res = fb_tab(fb, 0U, countof(fsz), fsz, fo);
+	fb_u16(fb, fo[0U], ARROW_V5);
+	fb->b[fo[1U]] = hdr;
+	fb_u64(fb, fo[3U], blen);
+	*hat = fo[2U];
+	return res;
+}
+
+static void
+fb_int(struct fb_s *fb, size_t at, int32_t width, bool signedp)
+{
+	static const uint8_t fsz[] = {4U, 1U};
+	size_t fo[countof(fsz)];
+
+	(void)fb_tab(fb, at, countof(fsz), fsz, fo);
+	fb_u32(fb, fo[0U], (uint32_t)width);
+	fb->b[fo[1U]] = (uint8_t)signedp;
+	return;
+}
+
+static void
+fb_field(
+	actx_t ctx, size_t at, const char *name,
+	uint8_t type, int32_t width, bool signedp, bool dictp)
+{
+/* write a Field of TYPE, WIDTH and SIGNEDP are for ints */
+	/* name, nullable, type type, type, dictionary, children */
+	const uint8_t fsz[] = {4U, 1U, 1U, 4U, dictp ? 4U : 0U, 4U};
+	static const uint8_t nofsz[] = {0U};
+	struct fb_s *fb = ctx->fb;
+	size_t fo[countof(fsz)];
+	size_t sub[2U];
+
+	(void)fb_tab(fb, at, countof(fsz), fsz, fo);
+	fb->b[fo[1U]] = 1U/*nullable*/;
+	fb->b[fo[2U]] = type;
+	fb_str(fb, fo[0U], name);
+
+	switch (type) {
+	case ARROW_TYPE_INT:
+		fb_int(fb, fo[3U], width, signedp);
+		break;
+	case ARROW_TYPE_FLOAT: {
+		static const uint8_t tsz[] = {2U};
+
+		(void)fb_tab(fb, fo[3U], countof(tsz), tsz, sub);
+		fb_u16(fb, sub[0U], ARROW_PREC_DOUBLE);
+		break;
+	}
+	case ARROW_TYPE_TIMESTAMP: {
+		static const uint8_t tsz[] = {2U, 4U};
+
+		(void)fb_tab(fb, fo[3U], countof(tsz), tsz, sub);
+		fb_u16(fb, sub[0U], ARROW_UNIT_MSEC);
+		fb_str(fb, sub[1U], "UTC");
+		break;
+	}
+	case ARROW_TYPE_UTF8:
+	default:
+		(void)fb_tab(fb, fo[3U], 0U, nofsz, sub);
+		break;
+	}
+
+	if (dictp) {
+		/* DictionaryEncoding, id 0 and int32 indices */
+		static const uint8_t dsz[] = {8U, 4U};
+
+		(void)fb_tab(fb, fo[4U], countof(dsz), dsz, sub);
+		fb_int(fb, sub[1U], 32, true);
+	}
+	/* no children, but arrow wants the vector regardless */
+	(void)fb_vec(fb, fo[5U], 0U, 4U);
+	return;
+}
+
+static void
+fb_schema(actx_t ctx, size_t at)
+{
+	/* endianness, fields, custom metadata,
+	 * the body is in host order, little is the default */
+#if defined WORDS_BIGENDIAN
+	static const uint8_t fsz[] = {2U, 4U, 4U};
+#else  /* !WORDS_BIGENDIAN */
+	static const uint8_t fsz[] = {0U, 4U, 4U};
+#endif	/* WORDS_BIGENDIAN */
+	struct fb_s *fb = ctx->fb;
+	const uint8_t vty = ctx->scale < 0 ? ARROW_TYPE_FLOAT : ARROW_TYPE_INT;
+	size_t fo[countof(fsz)];
+	size_t fv;
+
+	(void)fb_tab(fb, at, countof(fsz) - (ctx->scale < 0), fsz, fo);
+#if defined WORDS_BIGENDIAN
+	fb_u16(fb, fo[0U], 1U/*Big*/);
+#endif	/* WORDS_BIGENDIAN */
+	fv = fb_vec(fb, fo[1U], 5U, 4U);
+	fb_field(ctx, fv + 0U, "ts", ARROW_TYPE_TIMESTAMP, 0, false, false);
+	fb_field(ctx, fv + 4U, "sym", ARROW_TYPE_UTF8, 0, false, true);
+	fb_field(ctx, fv + 8U, "ttf", ARROW_TYPE_INT, 16, false, false);
+	fb_field(ctx, fv + 12U, "price", vty, 64, true, false);
+	fb_field(ctx, fv + 16U, "qty", vty, 64, true, false);
+
+	if (ctx->scale >= 0) {
+		/* tell them about the scale, as KeyValue */
+		static const uint8_t kvsz[] = {4U, 4U};
+		char sc[4U];
+		size_t kv[countof(kvsz)];
+
+		fv = fb_vec(fb, fo[2U], 1U, 4U);
+		(void)fb_tab(fb, fv, countof(kvsz), kvsz, kv);
+		snprintf(sc, sizeof(sc), "%d", ctx->scale);
+		with (size_t vo = kv[1U]) {
+			fb_str(fb, kv[0U], "scale");
+			fb_str(fb, vo, sc);
+		}
+	}
+	return;
+}
+
+static size_t
+fb_recbatch(
+	struct fb_s *fb, size_t at, size_t len,
+	const int64_t nodes[][2U], size_t nnodes,
+	const int64_t bufs[][2U], size_t nbufs)
+{
+	static const uint8_t fsz[] = {8U, 4U, 4U};
+	size_t fo[countof(fsz)];
+	size_t res;
+	size_t bo;
+
+	res = fb_tab(fb, at, countof(fsz), fsz, fo);
+	fb_u64(fb, fo[0U], len);
+	bo = fo[2U];
+	/* FieldNode and Buffer structs, two longs each */
+	with (size_t o = fb_vec(fb, fo[1U], nnodes, sizeof(*nodes))) {
+		for (size_t i = 0; i < nnodes; i++, o += sizeof(*nodes)) {
+			fb_u64(fb, o, nodes[i][0U]);
+			fb_u64(fb, o + 8U, nodes[i][1U]);
+		}
+	}
+	with (size_t o = fb_vec(fb, bo, nbufs, sizeof(*bufs))) {
+		for (size_t i = 0; i < nbufs; i++, o += sizeof(*bufs)) {
+			fb_u64(fb, o, bufs[i][0U]);
+			fb_u64(fb, o + 8U, bufs[i][1U]);
+		}
+	}
+	return res;
+}
+
+static void
+bufs_off(int64_t bufs[][2U], const struct iovec *iov, size_t niov)
+{
+	int64_t off = 0;
+
+	for (size_t i = 0; i < niov; i++) {
+		bufs[i][0U] = off;
+		bufs[i][1U] = (int64_t)iov[i].iov_len;
+		off += (int64_t)((iov[i].iov_len + 7U) & ~7U);
+	}
+	return;
+}
+
+
+static int
+wr_schema(actx_t ctx)
+{
+	size_t hat;
+
+	(void)fb_msg(ctx->fb, ARROW_HDR_SCHEMA, 0U, &hat);
+	fb_schema(ctx, hat);
+	return wr_msg(ctx, NULL, NULL, 0);
+}
+
+static size_t
+nulls(uint8_t *restrict v, size_t n)
+{
+/* count the nulls in validity bitmap V of N rows */
+	size_t res = 0U;
+
+	for (size_t i = 0; i < n; i++) {
+		res += !(v[i / 8U] >> (i % 8U) & 1U);
+	}
+	return res;
+}
+
+static int
+wr_batch(actx_t ctx)
+{
+	const size_t n = ctx->n;
+	const size_t nb = (n + 7U) / 8U;
+	const int64_t np = (int64_t)nulls(ctx->pv, n);
+	const int64_t nq = (int64_t)nulls(ctx->qv, n);
+	struct iovec body[] = {
+		{NULL, 0U}, {ctx->ts, n * sizeof(*ctx->ts)},
+		{NULL, 0U}, {ctx->sym, n * sizeof(*ctx->sym)},
+		{NULL, 0U}, {ctx->ttf, n * sizeof(*ctx->ttf)},
+		{ctx->pv, np ? nb : 0U}, {ctx->px, n * sizeof(*ctx->px)},
+		{ctx->qv, nq ? nb : 0U}, {ctx->qx, n * sizeof(*ctx->qx)},
+	};
+	const int64_t nodes[][2U] = {
+		{(int64_t)n, 0}, {(int64_t)n, 0}, {(int64_t)n, 0},
+		{(int64_t)n, np}, {(int64_t)n, nq},
+	};
+	int64_t bufs[countof(body)][2U];
+	size_t hat;
+	int rc;
+
+	if (UNLIKELY(n == 0U)) {
+		return 0;
+	}
+	if (ctx->nrbs >= ctx->zrbs) {
+		ctx->zrbs = ctx->zrbs * 2U ?: 16U;
+		ctx->rbs = realloc(ctx->rbs, ctx->zrbs * sizeof(*ctx->rbs));
+	}
+	bufs_off(bufs, body, countof(body));
+	(void)fb_msg(ctx->fb, ARROW_HDR_RECBATCH,
+		     bufs[countof(body) - 1U][0U] +
+		     ((body[countof(body) - 1U].iov_len + 7U) & ~7U), &hat);
+	(void)fb_recbatch(ctx->fb, hat, n, nodes, countof(nodes),
+			  bufs, countof(bufs));
+	rc = wr_msg(ctx, ctx->rbs + ctx->nrbs++, body, countof(body));
+
+	/* start afresh */
+	memset(ctx->pv, 0, nb);
+	memset(ctx->qv, 0, nb);
+	ctx->n = 0U;
+	return rc;
+}
+
+static int
+wr_dict(actx_t ctx)
+{
+/* the symbol dictionary, a batch with one utf8 column */
+	static const uint8_t fsz[] = {8U, 4U, 1U};
+	struct iovec body[] = {
+		{NULL, 0U},
+		/* a lone 0 offset if there's no symbols */
+		{ctx->ndic ? (void*)ctx->dof : zeroes,
+		 (ctx->ndic + 1U) * sizeof(*ctx->dof)},
+		{ctx->dat, ctx->ndat},
+	};
+	const int64_t nodes[][2U] = {{(int64_t)ctx->ndic, 0}};
+	int64_t bufs[countof(body)][2U];
+	size_t fo[countof(fsz)];
+	size_t hat;
+
+	bufs_off(bufs, body, countof(body));
+	(void)fb_msg(ctx->fb, ARROW_HDR_DICTIONARY,
+		     bufs[2U][0U] + ((ctx->ndat + 7U) & ~7U), &hat);
+	/* DictionaryBatch, id 0, not a delta */
+	(void)fb_tab(ctx->fb, hat, countof(fsz) - 1U, fsz, fo);
+	(void)fb_recbatch(ctx->fb, fo[1U], ctx->ndic, nodes, countof(nodes),
+			  bufs, countof(bufs));
+	return wr_msg(ctx, &ctx->dict, body, countof(body));
+}
+
+static void
+fb_blks(struct fb_s *fb, size_t at, const struct blk_s *b, size_t nb)
+{
+/* vector of Block structs */
+	size_t o = fb_vec(fb, at, nb, sizeof(*b));
+
+	for (size_t i = 0; i < nb; i++, o += sizeof(*b)) {
+		fb_u64(fb, o + offsetof(struct blk_s, off), b[i].off);
+		fb_u32(fb, o + offsetof(struct blk_s, mlen), b[i].mlen);
+		fb_u64(fb, o + offsetof(struct blk_s, blen), b[i].blen);
+	}
+	return;
+}
+
+static int
+wr_footer(actx_t ctx)
+{
+	static const uint8_t fsz[] = {2U, 4U, 4U, 4U};
+	struct fb_s *fb = ctx->fb;
+	uint32_t eos[2U] = {0xffffffffU, 0U};
+	size_t fo[countof(fsz)];
+	struct iovec iov[4U];
+	int32_t flen;
+
+	fb->n = 0U;
+	(void)fb_grow(fb, 4U);
+	(void)fb_tab(fb, 0U, countof(fsz), fsz, fo);
+	fb_u16(fb, fo[0U], ARROW_V5);
+	fb_schema(ctx, fo[1U]);
+	fb_blks(fb, fo[2U], &ctx->dict, 1U);
+	fb_blks(fb, fo[3U], ctx->rbs, ctx->nrbs);
+	flen = (int32_t)htole32((uint32_t)fb->n);
+	iov[0U] = (struct iovec){eos, sizeof(eos)};
+	iov[1U] = (struct iovec){fb->b, fb->n};
+	iov[2U] = (struct iovec){&flen, sizeof(flen)};
+	iov[3U] = (struct iovec){arrow_magic, 6U};
+	return wr_iov(ctx, iov, countof(iov));
+}
+
+
+/* symbols */
+static int32_t
+dict_add(actx_t ctx, const char *s)
+{
+	const size_t len = strlen(s);
+
+	/* check if we know him already */
+	for (size_t i = 0; i < ctx->ndic; i++) {
+		const size_t il = ctx->dof[i + 1U] - ctx->dof[i];
+
+		if (il == len && !memcmp(ctx->dat + ctx->dof[i], s, len)) {
+			return (int32_t)i;
+		}
+	}
+	if (ctx->ndic + 2U > ctx->zdic) {
+		ctx->zdic = ctx->zdic * 2U ?: 64U;
+		ctx->dof = realloc(ctx->dof, ctx->zdic * sizeof(*ctx->dof));
+	}
+	if (ctx->ndat + len > ctx->zdat) {
+		ctx->zdat = ctx->zdat * 2U + len;
+		ctx->dat = realloc(ctx->dat, ctx->zdat);
+	}
+	memcpy(ctx->dat + ctx->ndat, s, len);
+	ctx->dof[ctx->ndic] = (int32_t)ctx->ndat;
+	ctx->ndat += len;
+	ctx->dof[++ctx->ndic] = (int32_t)ctx->ndat;
+	return (int32_t)(ctx->ndic - 1U);
+}
+
+static int32_t
+dict_idx(actx_t ctx, utectx_t u, unsigned int idx)
+{
+/* dictionary index of symbol IDX in U */
+	if (UNLIKELY(u != ctx->u)) {
+		/* new file, new symbol table */
+		ctx->u = u;
+		for (size_t i = 0; i < ctx->ni2d; i++) {
+			ctx->i2d[i] = -1;
+		}
+	}
+	if (UNLIKELY(idx >= ctx->ni2d)) {
+		const size_t nu = (idx / 64U + 1U) * 64U;
+
+		ctx->i2d = realloc(ctx->i2d, nu * sizeof(*ctx->i2d));
+		for (size_t i = ctx->ni2d; i < nu; i++) {
+			ctx->i2d[i] = -1;
+		}
+		ctx->ni2d = nu;
+	}
+	if (UNLIKELY(ctx->i2d[idx] < 0)) {
+		const char *s = u != NULL ? ute_idx2sym(u, idx) : NULL;
+		char b[16U];
+
+		if (s == NULL) {
+			/* no name, go for the index then */
+			snprintf(b, sizeof(b), "%u", idx);
+			s = b;
+		}
+		ctx->i2d[idx] = dict_add(ctx, s);
+	}
+	return ctx->i2d[idx];
+}
+
+
+/* values */
+static const int64_t pow10s[] = {
+	1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL,
+	10000000LL, 100000000LL, 1000000000LL, 10000000000LL,
+	100000000000LL, 1000000000000LL,
+};
+
+static inline int64_t
+scale_mant(int64_t mant, unsigned int expo, int scale)
+{
+/* MANT * 10^(4 * EXPO - 8) in units of 10^-SCALE */
+	const int e = 4 * (int)expo - 8 + scale;
+
+	if (e >= 0) {
+		return mant * pow10s[e];
+	}
+	return mant / pow10s[-e];
+}
+
+static void
+bang(actx_t ctx, int64_t ts, int32_t sym, uint16_t ttf)
+{
+	const size_t i = ctx->n;
+
+	ctx->ts[i] = ts;
+	ctx->sym[i] = sym;
+	ctx->ttf[i] = ttf;
+	/* nulls get 0 values */
+	ctx->px[i].i = 0;
+	ctx->qx[i].i = 0;
+	return;
+}
+
+static void
+bang_m30(actx_t ctx, bool qtyp, uint32_t v)
+{
+	const m30_t m = {.u = v};
+	const size_t i = ctx->n;
+
+	if (ctx->scale < 0) {
+		(qtyp ? ctx->qx : ctx->px)[i].d = ffff_m30_d(m);
+	} else {
+		(qtyp ? ctx->qx : ctx->px)[i].i =
+			scale_mant(m.mant, m.expo, ctx->scale);
+	}
+	(qtyp ? ctx->qv : ctx->pv)[i / 8U] |= (uint8_t)(1U << (i % 8U));
+	return;
+}
+
+static void
+bang_m62(actx_t ctx, bool qtyp, uint64_t v)
+{
+	const m62_t m = {.u = v};
+	const size_t i = ctx->n;
+
+	if (ctx->scale < 0) {
+		(qtyp ? ctx->qx : ctx->px)[i].d = ffff_m62_d(m);
+	} else {
+		(qtyp ? ctx->qx : ctx->px)[i].i =
+			scale_mant(M62_MANT(m), M62_EXPO(m), ctx->scale);
+	}
+	(qtyp ? ctx->qv : ctx->pv)[i / 8U] |= (uint8_t)(1U << (i % 8U));
+	return;
+}
+
+static int
+next_row(actx_t ctx)
+{
+	if (UNLIKELY(++ctx->n >= ctx->nbatch)) {
+		return wr_batch(ctx);
+	}
+	return 0;
+}
+
+
+/* public printer */
+static struct actx_s __gactx[1];
+
+#include "arrow.yucc"
+
+int
+init_main(pr_ctx_t pctx, int argc, char *argv[])
+{
+	yuck_t argi[1U];
+	actx_t ctx = __gactx;
+	size_t nb;
+	int res = 0;
+
+	if (yuck_parse(argi, argc, argv)) {
+		res = -1;
+		goto out;
+	}
+	/* hand back the files, without our options */
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		argv[1U + i] = argi->args[i];
+	}
+	if (argi->nargs + 1U < (size_t)argc) {
+		argv[1U + argi->nargs] = NULL;
+	}
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->fd = pctx->outfd;
+	ctx->nbatch = BATCH_INC;
+	ctx->scale = -1;
+	if (argi->batch_arg) {
+		ctx->nbatch = strtoul(argi->batch_arg, NULL, 10) ?: BATCH_INC;
+	}
+	if (argi->scale_arg) {
+		long int sc = strtol(argi->scale_arg, NULL, 10);
+
+		ctx->scale = sc < 0 ? 0 : sc > 8 ? 8 : (int)sc;
+	}
+	/* no point in batches bigger than the input */
+	if (pctx->nticks && 2U * pctx->nticks < ctx->nbatch) {
+		ctx->nbatch = 2U * pctx->nticks;
+	}
+
+	nb = ctx->nbatch;
+	ctx->ts = malloc(nb * sizeof(*ctx->ts));
+	ctx->sym = malloc(nb * sizeof(*ctx->sym));
+	ctx->ttf = malloc(nb * sizeof(*ctx->ttf));
+	ctx->px = malloc(nb * sizeof(*ctx->px));
+	ctx->qx = malloc(nb * sizeof(*ctx->qx));
+	ctx->pv = calloc((nb + 7U) / 8U, sizeof(*ctx->pv));
+	ctx->qv = calloc((nb + 7U) / 8U, sizeof(*ctx->qv));
+	if (ctx->ts == NULL || ctx->sym == NULL || ctx->ttf == NULL ||
+	    ctx->px == NULL || ctx->qx == NULL ||
+	    ctx->pv == NULL || ctx->qv == NULL) {
+		fputs("cannot allocate arrow batch\n", stderr);
+		res = -1;
+		goto out;
+	}
+
+	/* magic and schema right away */
+	with (struct iovec iov = {arrow_magic, sizeof(arrow_magic)}) {
+		ctx->off = 0U;
+		if (wr_iov(ctx, &iov, 1) < 0 || wr_schema(ctx) < 0) {
+			fputs("cannot write arrow file\n", stderr);
+			res = -1;
+		}
+	}
+
+out:
+	yuck_free(argi);
+	return res;
+}
+
+void
+fini(pr_ctx_t UNUSED(pctx))
+{
+	actx_t ctx = __gactx;
+
+	if (UNLIKELY(ctx->ts == NULL)) {
+		return;
+	}
+	if (wr_batch(ctx) < 0 || wr_dict(ctx) < 0 || wr_footer(ctx) < 0) {
+		fputs("cannot write arrow file\n", stderr);
+	}
+
+	free(ctx->ts);
+	free(ctx->sym);
+	free(ctx->ttf);
+	free(ctx->px);
+	free(ctx->qx);
+	free(ctx->pv);
+	free(ctx->qv);
+	free(ctx->rbs);
+	free(ctx->dat);
+	free(ctx->dof);
+	free(ctx->i2d);
+	free(ctx->fb->b);
+	memset(ctx, 0, sizeof(*ctx));
+	return;
+}
+
+int
+pr(pr_ctx_t pctx, scom_t st)
+{
+	actx_t ctx = __gactx;
+	const int64_t ts = (int64_t)scom_thdr_sec(st) * 1000 +
+		scom_thdr_msec(st);
+	const uint16_t ttf = scom_thdr_ttf(st);
+	int32_t sym;
+
+	switch (ttf) {
+	case SL1T_TTF_BID:
+	case SL1T_TTF_ASK:
+	case SL1T_TTF_TRA:
+	case SL1T_TTF_FIX:
+	case SL1T_TTF_STL:
+	case SL1T_TTF_AUC:
+	case SL1T_TTF_G32:
+	case SL2T_TTF_BID:
+	case SL2T_TTF_ASK:
+	case SL1T_TTF_VOL:
+	case SL1T_TTF_VPR:
+	case SL1T_TTF_VWP:
+	case SL1T_TTF_OI:
+	case SL1T_TTF_G64:
+	case SBAP_FLAVOUR:
+	case SSNP_FLAVOUR:
+		break;
+	default:
+		/* candles and whatnot, not for us */
+		return 0;
+	}
+
+	sym = dict_idx(ctx, pctx->uctx, pr_tblidx(pctx, st));
+	switch (ttf) {
+		const_sl1t_t l1t;
+		const_ssnp_t snp;
+
+	case SL1T_TTF_BID:
+	case SL1T_TTF_ASK:
+	case SL1T_TTF_TRA:
+	case SL1T_TTF_FIX:
+	case SL1T_TTF_STL:
+	case SL1T_TTF_AUC:
+	case SL1T_TTF_G32:
+	case SL2T_TTF_BID:
+	case SL2T_TTF_ASK:
+		l1t = (const void*)st;
+		bang(ctx, ts, sym, ttf);
+		bang_m30(ctx, false, l1t->v[0U]);
+		bang_m30(ctx, true, l1t->v[1U]);
+		break;
+
+	case SL1T_TTF_VWP:
+		/* that one's a price */
+		l1t = (const void*)st;
+		bang(ctx, ts, sym, ttf);
+		bang_m62(ctx, false, l1t->w[0U]);
+		break;
+	case SL1T_TTF_VOL:
+	case SL1T_TTF_VPR:
+	case SL1T_TTF_OI:
+	case SL1T_TTF_G64:
+		l1t = (const void*)st;
+		bang(ctx, ts, sym, ttf);
+		bang_m62(ctx, true, l1t->w[0U]);
+		break;
+
+	case SBAP_FLAVOUR:
+		/* bid and ask prices, one row each */
+		l1t = (const void*)st;
+		bang(ctx, ts, sym, SL1T_TTF_BID);
+		bang_m30(ctx, false, l1t->v[0U]);
+		if (next_row(ctx) < 0) {
+			return -1;
+		}
+		bang(ctx, ts, sym, SL1T_TTF_ASK);
+		bang_m30(ctx, false, l1t->v[1U]);
+		break;
+
+	case SSNP_FLAVOUR:
+		/* bid and ask, with quantities */
+		snp = (const void*)st;
+		bang(ctx, ts, sym, SL1T_TTF_BID);
+		bang_m30(ctx, false, snp->bp);
+		bang_m30(ctx, true, snp->bq);
+		if (next_row(ctx) < 0) {
+			return -1;
+		}
+		bang(ctx, ts, sym, SL1T_TTF_ASK);
+		bang_m30(ctx, false, snp->ap);
+		bang_m30(ctx, true, snp->aq);
+		break;
+	}
+	return next_row(ctx);
+}
+
+/* arrow.c ends here */
@@ -0,0 +1,194 @@
+/*** cmd-mrg.c -- merging runs of per-symbol ticks
+ *
+ * Copyright (C) 2026 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of uterus.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "utefile.h"
+#include "nifty.h"
+
+/* runs are sorted ute files, as written by jobs that took a share of
+ * the input each, and they're k-way merged back into one file */
+struct mrg_s {
+	utectx_t hdl;
+	/* run to target symbol index, 0 if not yet looked up */
+	unsigned int *omap;
+	size_t nsyms;
+	/* current tick and its sort key */
+	scom_t t;
+	uint64_t key;
+};
+
+/* fill OMAP, the map from SRC's symbol indices to TGT's */
+typedef void(*mrg_map_f)(unsigned int *omap, utectx_t tgt, utectx_t src);
+
+static unsigned int
+mrg_idx(utectx_t tgt, struct mrg_s *m)
+{
+/* the index of M's current tick in TGT, symbols not in the map yet
+ * are introduced to TGT in order of appearance */
+	unsigned int idx = ute_tblidx(m->hdl, m->t);
+	const char *sym;
+
+	if (UNLIKELY(idx > m->nsyms)) {
+		return 0U;
+	} else if (LIKELY(m->omap[idx])) {
+		return m->omap[idx];
+	} else if (UNLIKELY((sym = ute_idx2sym(m->hdl, idx)) == NULL || !*sym)) {
+		/* hole in M's slut */
+		return 0U;
+	}
+	return m->omap[idx] = ute_sym2idx(tgt, sym);
+}
+
+static bool
+mrg_next(struct mrg_s *m, bool timep)
+{
+/* advance M to its next tick, return false if there's none
+ * with TIMEP the key is the time stamp alone, otherwise it's the key
+ * as ute_add_tick_idx() will put it on the disk */
+	union scom_thdr_u h;
+	unsigned int idx;
+
+	if ((m->t = ute_iter(m->hdl)) == NULL) {
+		return false;
+	} else if (timep) {
+		m->key = (uint64_t)scom_thdr_sec(m->t) << 10U |
+			scom_thdr_msec(m->t);
+		return true;
+	} else if (UNLIKELY((idx = ute_tblidx(m->hdl, m->t)) > m->nsyms)) {
+		idx = 0U;
+	}
+	idx = m->omap[idx];
+	h.u = (scom_thdr_widx_p(m->t) ? scom_widx_tick(m->t) : m->t)->u;
+	h.idx = idx;
+	if (UNLIKELY(idx > 0xffffU)) {
+		h.ttf = SCOM_FLAG_WIDX;
+	}
+	m->key = h.u;
+	return true;
+}
+
+static inline bool
+mrg_lt(const struct mrg_s *m, size_t i, size_t j)
+{
+/* order by key, ties go to the earlier run */
+	return m[i].key < m[j].key || m[i].key == m[j].key && i < j;
+}
+
+static void
+mrg_sift(const struct mrg_s *m, size_t *heap, size_t nh, size_t i)
+{
+	for (size_t c; (c = 2U * i + 1U) < nh; i = c) {
+		if (c + 1U < nh && mrg_lt(m, heap[c + 1U], heap[c])) {
+			c++;
+		}
+		if (!mrg_lt(m, heap[c], heap[i])) {
+			break;
+		}
+		with (size_t tmp = heap[i]) {
+			heap[i] = heap[c];
+			heap[c] = tmp;
+		}
+	}
+	return;
+}
+
+static int
+mrg_runs(utectx_t tgt, char *const *fns, size_t nfns, mrg_map_f mapf)
+{
+/* k-way merge the sorted ute files FNS into TGT, ties go to the earlier run
+ * MAPF fills each run's index map up front and ticks are ordered by their
+ * key in TGT, without MAPF the runs' symbols must be pairwise disjoint,
+ * they're introduced to TGT in order of appearance and ticks are ordered
+ * by time stamp, just as a serial run would have it */
+	const bool timep = mapf == NULL;
+	struct mrg_s *m;
+	size_t *heap;
+	size_t nh = 0U;
+	int rc = 0;
+
+	if (UNLIKELY((m = calloc(nfns, sizeof(*m))) == NULL)) {
+		return -1;
+	} else if (UNLIKELY((heap = calloc(nfns, sizeof(*heap))) == NULL)) {
+		free(m);
+		return -1;
+	}
+	for (size_t j = 0U; j < nfns; j++) {
+		if ((m[j].hdl = ute_open(fns[j], UO_RDONLY)) == NULL) {
+			error("cannot open intermediate file `%s'", fns[j]);
+			rc = -1;
+			continue;
+		}
+		m[j].nsyms = ute_nsyms(m[j].hdl);
+		m[j].omap = calloc(m[j].nsyms + 1U, sizeof(*m[j].omap));
+		if (UNLIKELY(m[j].omap == NULL)) {
+			rc = -1;
+			continue;
+		} else if (mapf != NULL) {
+			mapf(m[j].omap, tgt, m[j].hdl);
+		}
+		if (mrg_next(m + j, timep)) {
+			heap[nh++] = j;
+		}
+	}
+	for (size_t i = nh / 2U; i-- > 0U;) {
+		mrg_sift(m, heap, nh, i);
+	}
+
+	/* ticks leave in sorted order so TGT won't need resorting */
+	while (nh > 0U) {
+		struct mrg_s *top = m + heap[0U];
+
+		ute_add_tick_idx(tgt, top->t, mrg_idx(tgt, top));
+		if (!mrg_next(top, timep)) {
+			heap[0U] = heap[--nh];
+		}
+		mrg_sift(m, heap, nh, 0U);
+	}
+
+	for (size_t j = 0U; j < nfns; j++) {
+		if (m[j].hdl != NULL) {
+			ute_close(m[j].hdl);
+		}
+		free(m[j].omap);
+	}
+	free(heap);
+	free(m);
+	return rc;
+}
+
+/* cmd-mrg.c ends here */
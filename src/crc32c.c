@@ -0,0 +1,167 @@
+/*** crc32c.c -- castagnoli crc32
+ *
+ * Copyright (C) 2026 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of uterus.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdbool.h>
+#include <string.h>
+#include "crc32c.h"
+#include "nifty.h"
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+# define HAVE_SSE42_CRC
+# include <nmmintrin.h>
+#endif	/* __GNUC__ && x86 */
+
+/* reflected castagnoli polynomial */
+#define POLY	(0x82f63b78U)
+
+/* slicing-by-8 tables for the portable version */
+static uint32_t tbl[8U][256U];
+static bool tblp;
+
+
+static void
+init_tbl(void)
+{
+	for (unsigned int i = 0U; i < 256U; i++) {
+		uint32_t c = i;
+
+		for (unsigned int k = 0U; k < 8U; k++) {
+			c = c & 1U ? (c >> 1U) ^ POLY : c >> 1U;
+		}
+		tbl[0U][i] = c;
+	}
+	for (unsigned int i = 0U; i < 256U; i++) {
+		uint32_t c = tbl[0U][i];
+
+		for (unsigned int k = 1U; k < 8U; k++) {
+			c = tbl[0U][c & 0xffU] ^ (c >> 8U);
+			tbl[k][i] = c;
+		}
+	}
+	tblp = true;
+	return;
+}
+
+static uint32_t
+crc32c_sw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	if (UNLIKELY(!tblp)) {
+		init_tbl();
+	}
+	/* bytewise until P is aligned */
+	for (; len && (uintptr_t)p % 8U; len--) {
+		crc = tbl[0U][(crc ^ *p++) & 0xffU] ^ (crc >> 8U);
+	}
+	for (; len >= 8U; len -= 8U, p += 8U) {
+		uint32_t lo;
+		uint32_t hi;
+
+		memcpy(&lo, p, sizeof(lo));
+		memcpy(&hi, p + 4U, sizeof(hi));
+#if defined WORDS_BIGENDIAN
+		lo = __builtin_bswap32(lo);
+		hi = __builtin_bswap32(hi);
+#endif	/* WORDS_BIGENDIAN */
+		lo ^= crc;
+		crc = tbl[7U][lo & 0xffU] ^
+			tbl[6U][(lo >> 8U) & 0xffU] ^
+			tbl[5U][(lo >> 16U) & 0xffU] ^
+			tbl[4U][lo >> 24U] ^
+			tbl[3U][hi & 0xffU] ^
+			tbl[2U][(hi >> 8U) & 0xffU] ^
+			tbl[1U][(hi >> 16U) & 0xffU] ^
+			tbl[0U][hi >> 24U];
+	}
+	for (; len; len--) {
+		crc = tbl[0U][(crc ^ *p++) & 0xffU] ^ (crc >> 8U);
+	}
+	return crc;
+}
+
+#if defined HAVE_SSE42_CRC
+static __attribute__((target("sse4.2"))) uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	for (; len && (uintptr_t)p % 8U; len--) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+# if defined __x86_64__
+	with (uint64_t c = crc) {
+		for (; len >= 8U; len -= 8U, p += 8U) {
+			uint64_t x;
+
+			memcpy(&x, p, sizeof(x));
+			c = _mm_crc32_u64(c, x);
+		}
+		crc = (uint32_t)c;
+	}
+# endif	/* __x86_64__ */
+	for (; len >= 4U; len -= 4U, p += 4U) {
+		uint32_t x;
+
+		memcpy(&x, p, sizeof(x));
+		crc = _mm_crc32_u32(crc, x);
+	}
+	for (; len; len--) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+	return crc;
+}
+#endif	/* HAVE_SSE42_CRC */
+
+
+uint32_t
+crc32c(uint32_t crc, const void *buf, size_t len)
+{
+#if defined HAVE_SSE42_CRC
+	static int hwp = -1;
+
+	if (UNLIKELY(hwp < 0)) {
+		__builtin_cpu_init();
+		hwp = __builtin_cpu_supports("sse4.2");
+	}
+	if (LIKELY(hwp)) {
+		return ~crc32c_hw(~crc, buf, len);
+	}
+#endif	/* HAVE_SSE42_CRC */
+	return ~crc32c_sw(~crc, buf, len);
+}
+
+/* crc32c.c ends here */
@@ -51,6 +51,10 @@
 #include <stdbool.h>
 #include <time.h>
 #include <string.h>
+#include <errno.h>
+#if defined HAVE_LZMA_H
+# include <lzma.h>
+#endif	/* HAVE_LZMA_H */
 
 #include "boobs.h"
 #include "scommon.h"
@@ -135,62 +139,138 @@ __m30_get_dukas(uint32_t val)
 static struct sl1t_s t[2];
 static struct scdl_s c[1];
 
-static bool
-rd1(int f, struct dc_s *b)
+/* input handling, files are small enough to be had in one go */
+#define SLURP_PAD	(2U * sizeof(struct dcc_s))
+
+static char*
+slurp(int fd, size_t *z)
 {
-	if (UNLIKELY(read(f, b, sizeof(*b)) <= 0)) {
-		return false;
-	}
-	b->ts = be64toh(b->ts);
-	b->ap.i = be64toh(b->ap.i);
-	b->bp.i = be64toh(b->bp.i);
-	b->aq.i = be64toh(b->aq.i);
-	b->bq.i = be64toh(b->bq.i);
-	return true;
+/* read all of FD, the result is followed by SLURP_PAD zero bytes
+ * so probes may look past short inputs */
+	size_t bsz = 65536U;
+	size_t tot = 0U;
+	char *buf = NULL;
+
+	do {
+		char *tmp;
+
+		if (UNLIKELY((tmp = realloc(buf, bsz + SLURP_PAD)) == NULL)) {
+			free(buf);
+			return NULL;
+		}
+		buf = tmp;
+		for (ssize_t nrd;
+		     tot < bsz && (nrd = read(fd, buf + tot, bsz - tot)) > 0;
+		     tot += nrd);
+	} while (tot >= bsz && (bsz *= 2U));
+	memset(buf + tot, 0, SLURP_PAD);
+	*z = tot;
+	return buf;
 }
 
-static bool
-rd1bi5(int f, struct dqbi5_s *b)
+#if defined HAVE_LZMA_H
+static char*
+unlzma(char *buf, size_t *z)
 {
-	if (UNLIKELY(read(f, b, sizeof(*b)) <= 0)) {
-		return false;
-	}
-	b->ts = be32toh(b->ts);
-	b->ap = be32toh(b->ap);
-	b->bp = be32toh(b->bp);
-	b->aq.i = be32toh(b->aq.i);
-	b->bq.i = be32toh(b->bq.i);
-	return true;
+/* BUF of size *Z is what xz --format=lzma would produce (and what
+ * dukascopy serves as .bi5), return the decoded data, padded like the
+ * result of slurp(), and free BUF, or return NULL and leave BUF alone */
+	lzma_stream strm = LZMA_STREAM_INIT;
+	uint64_t usz;
+	size_t rsz;
+	char *res;
+	lzma_ret rc;
+
+	/* the header has the uncompressed size, or -1 if it's unknown */
+	memcpy(&usz, buf + 5U, sizeof(usz));
+	usz = le64toh(usz);
+	if (usz < 256U * 1024U * 1024U) {
+		rsz = usz ?: 1U;
+	} else {
+		rsz = 8U * *z;
+	}
+	if (lzma_alone_decoder(&strm, UINT64_MAX) != LZMA_OK) {
+		return NULL;
+	} else if ((res = malloc(rsz + SLURP_PAD)) == NULL) {
+		goto out;
+	}
+	strm.next_in = (const uint8_t*)buf;
+	strm.avail_in = *z;
+	strm.next_out = (uint8_t*)res;
+	strm.avail_out = rsz;
+	do {
+		char *tmp;
+
+		if (LIKELY(strm.avail_out > 0U)) {
+			continue;
+		} else if (UNLIKELY((tmp = realloc(res, 2U * rsz + SLURP_PAD)) == NULL)) {
+			rc = LZMA_MEM_ERROR;
+			break;
+		}
+		/* out of room, double it */
+		res = tmp;
+		strm.next_out = (uint8_t*)res + rsz;
+		strm.avail_out = rsz;
+		rsz *= 2U;
+	} while ((rc = lzma_code(&strm, LZMA_FINISH)) == LZMA_OK ||
+		 rc == LZMA_BUF_ERROR && strm.avail_out == 0U);
+	if (rc != LZMA_STREAM_END) {
+		free(res);
+		res = NULL;
+		goto out;
+	}
+	*z = strm.total_out;
+	memset(res + *z, 0, SLURP_PAD);
+	free(buf);
+out:
+	lzma_end(&strm);
+	return res;
+}
+#endif	/* HAVE_LZMA_H */
+
+static char*
+rdin(int fd, size_t *z)
+{
+/* read FD, decompressing it if need be */
+	char *buf;
+
+	if (UNLIKELY((buf = slurp(fd, z)) == NULL)) {
+		return NULL;
+	}
+#if defined HAVE_LZMA_H
+	/* raw records start with a big-endian stamp whose top byte is
+	 * always naught, lzma's lc/lp/pb properties byte is below 225 */
+	if (*z > 13U && buf[0U] != '\0' && (unsigned char)buf[0U] < 225U) {
+		char *res;
+
+		if (UNLIKELY((res = unlzma(buf, z)) == NULL)) {
+			errno = 0;
+			error("cannot decompress input");
+			free(buf);
+		}
+		buf = res;
+	}
+#endif	/* HAVE_LZMA_H */
+	return buf;
 }
 
-static bool
-rd1c(int f, struct dcc_s *b)
+static void
+be32toh_n(uint32_t *restrict w, size_t n)
 {
-	if (UNLIKELY(read(f, b, sizeof(*b)) <= 0)) {
-		return false;
-	}
-	b->ts = be64toh(b->ts);
-	b->o.i = be64toh(b->o.i);
-	b->c.i = be64toh(b->c.i);
-	b->l.i = be64toh(b->l.i);
-	b->h.i = be64toh(b->h.i);
-	b->v.i = be64toh(b->v.i);
-	return true;
+/* byte-swap N words in one loop, for the compiler to vectorise */
+	for (size_t i = 0U; i < n; i++) {
+		w[i] = be32toh(w[i]);
+	}
+	return;
 }
 
-static bool
-rd1cbi5(int f, struct dcbi5_s *b)
+static void
+be64toh_n(uint64_t *restrict w, size_t n)
 {
-	if (UNLIKELY(read(f, b, sizeof(*b)) <= 0)) {
-		return false;
-	}
-	b->ts = be32toh(b->ts);
-	b->o = be32toh(b->o);
-	b->c = be32toh(b->c);
-	b->l = be32toh(b->l);
-	b->h = be32toh(b->h);
-	b->v.i = be32toh(b->v.i);
-	return true;
+	for (size_t i = 0U; i < n; i++) {
+		w[i] = be64toh(w[i]);
+	}
+	return;
 }
 
 #define DUKAS_VMUL	(1.0e6)
@@ -352,194 +432,112 @@ prepare(mux_ctx_t ctx)
 }
 
 static void
-proc_l1bi5(mux_ctx_t ctx)
+proc_l1bi5(mux_ctx_t ctx, char *buf, size_t z)
 {
-	union {
-		struct dc_s bin[1];
-		struct dqbi5_s bi5[2];
-	} buf[1];
-	ssize_t nrd;
-	int fd = ctx->infd;
-
-	/* read a probe */
-	if (UNLIKELY((nrd = read(fd, buf->bi5, sizeof(buf->bi5))) <= 0)) {
+	const struct dqbi5_s *bi5 = (const void*)buf;
+
+	/* check the probe */
+	if (UNLIKELY(z < sizeof(*bi5))) {
 		return;
-	} else if (UNLIKELY(nrd == sizeof(*buf->bi5))) {
-		/* only one record then, just go for bi5 format,
-		 * make use of the tick compressor and dupe the record
-		 * then just proceed normally */
-		memcpy(buf->bi5 + 1, buf->bi5 + 0, sizeof(*buf->bi5));
-	} else if (UNLIKELY((size_t)nrd < sizeof(buf->bi5))) {
+	} else if (UNLIKELY(z < 2U * sizeof(*bi5) && z != sizeof(*bi5))) {
 		/* oooh incomplete innit? */
 		return;
 	}
 	/* the only thing we can make assumptions about is the timestamp
-	 * we check the two stamps in bi5 and compare their distance */
-	{
-		uint32_t ts0 = be32toh(buf->bi5[0].ts);
-		uint32_t ts1 = be32toh(buf->bi5[1].ts);
-
-		if (ts1 - ts0 > 60/*min*/ * 60/*sec*/ * 1000/*msec*/) {
-			/* definitely old_fmt */
-			goto old_fmt;
+	 * we check the two stamps in bi5 and compare their distance,
+	 * a single record is bi5 */
+	if (z > sizeof(*bi5) &&
+	    be32toh(bi5[1U].ts) - be32toh(bi5[0U].ts) >
+	    60/*min*/ * 60/*sec*/ * 1000/*msec*/) {
+		/* definitely old_fmt */
+		struct dc_s *bin = (void*)buf;
+		const size_t n = z / sizeof(*bin);
+
+		be64toh_n((void*)buf, n * sizeof(*bin) / sizeof(uint64_t));
+		for (size_t i = 0U; i < n; i++) {
+			write_tick(ctx, bin + i);
 		}
-
-		/* quickly polish the probe */
-		buf->bi5[0].ts = ts0;
-		buf->bi5[0].ap = be32toh(buf->bi5[0].ap);
-		buf->bi5[0].bp = be32toh(buf->bi5[0].bp);
-		buf->bi5[0].aq.i = be32toh(buf->bi5[0].aq.i);
-		buf->bi5[0].bq.i = be32toh(buf->bi5[0].bq.i);
-
-		buf->bi5[1].ts = ts1;
-		buf->bi5[1].ap = be32toh(buf->bi5[1].ap);
-		buf->bi5[1].bp = be32toh(buf->bi5[1].bp);
-		buf->bi5[1].aq.i = be32toh(buf->bi5[1].aq.i);
-		buf->bi5[1].bq.i = be32toh(buf->bi5[1].bq.i);
-	}
-	/* re-use the probe data */
-	write_tick_bi5(ctx, buf->bi5 + 0);
-	/* main loop */
-	do {
-		write_tick_bi5(ctx, buf->bi5 + 1);
-	} while (rd1bi5(fd, buf->bi5 + 1));
-	return;
-old_fmt:
-	/* polish the probe */
-	buf->bin->ts = be64toh(buf->bin->ts);
-	buf->bin->ap.i = be64toh(buf->bin->ap.i);
-	buf->bin->bp.i = be64toh(buf->bin->bp.i);
-	buf->bin->aq.i = be64toh(buf->bin->aq.i);
-	buf->bin->bq.i = be64toh(buf->bin->bq.i);
-	/* main loop */
-	do {
-		write_tick(ctx, buf->bin);
-	} while (rd1(fd, buf->bin));
+		return;
+	}
+	with (const size_t n = z / sizeof(*bi5)) {
+		be32toh_n((void*)buf, n * sizeof(*bi5) / sizeof(uint32_t));
+		if (UNLIKELY(n == 1U)) {
+			/* only one record, just go for bi5 format,
+			 * make use of the tick compressor and dupe the record */
+			write_tick_bi5(ctx, (struct dqbi5_s*)buf);
+		}
+		for (size_t i = 0U; i < n; i++) {
+			write_tick_bi5(ctx, (struct dqbi5_s*)buf + i);
+		}
+	}
 	return;
 }
 
 static void
-proc_cdbi5(mux_ctx_t ctx)
+proc_cdbi5(mux_ctx_t ctx, char *buf, size_t z)
 {
-	union {
-		struct dcc_s bin[2];
-		struct dcbi5_s bi5[2];
-	} buf[1];
+	const struct dcbi5_s *bi5 = (const void*)buf;
 	unsigned int cdl_len;
 
-	/* rinse */
-	memset(&buf, 0, sizeof(buf));
-
-	/* read a probe */
-	if (UNLIKELY(read(ctx->infd, buf->bi5, sizeof(buf->bi5)) <= 0)) {
+	if (UNLIKELY(z == 0U)) {
 		return;
 	}
-
 	/* again we can only make assumptions about the timestamps
-	 * check the two stamps in bi5 and compare their distance */
-	{
-		uint32_t ts0 = be32toh(buf->bi5[0].ts);
-		uint32_t ts1 = be32toh(buf->bi5[1].ts);
-
-		if ((cdl_len = ts1 - ts0) > 60/*min*/ * 60/*sec*/) {
-			/* definitely old_fmt */
-			goto old_fmt;
+	 * check the two stamps in bi5 and compare their distance,
+	 * BUF is padded with naughts so a short file reads as zero stamps */
+	if ((cdl_len = be32toh(bi5[1U].ts) - be32toh(bi5[0U].ts)) >
+	    60/*min*/ * 60/*sec*/) {
+		/* definitely old_fmt */
+		struct dcc_s *bin = (void*)buf;
+		const size_t n = z / sizeof(*bin);
+
+		be64toh_n((void*)buf, n * sizeof(*bin) / sizeof(uint64_t));
+		if (UNLIKELY(n == 0U)) {
+			return;
+		} else if (n < 2U) {
+			/* assume a day candle and exit */
+			write_cdl(ctx, bin, 86400U);
+			return;
+		}
+		/* otherwise compute the candle length, we know dukascopy
+		 * will not give us overlapping candles, so just diff the
+		 * time stamps */
+		cdl_len = (bin[1U].ts - bin[0U].ts) / 1000;
+		for (size_t i = 0U; i < n; i++) {
+			write_cdl(ctx, bin + i, cdl_len);
 		}
-
-		/* quickly polish the probe */
-		buf->bi5[0].ts = ts0;
-		buf->bi5[0].o = be32toh(buf->bi5[0].o);
-		buf->bi5[0].c = be32toh(buf->bi5[0].c);
-		buf->bi5[0].l = be32toh(buf->bi5[0].l);
-		buf->bi5[0].h = be32toh(buf->bi5[0].h);
-		buf->bi5[0].v.i = be32toh(buf->bi5[0].v.i);
-
-		buf->bi5[1].ts = ts1;
-		buf->bi5[1].o = be32toh(buf->bi5[1].o);
-		buf->bi5[1].c = be32toh(buf->bi5[1].c);
-		buf->bi5[1].l = be32toh(buf->bi5[1].l);
-		buf->bi5[1].h = be32toh(buf->bi5[1].h);
-		buf->bi5[1].v.i = be32toh(buf->bi5[1].v.i);
-	}
-	/* re-use the probe data */
-	write_cdl_bi5(ctx, buf->bi5 + 0, cdl_len);
-	/* main loop */
-	do {
-		write_cdl_bi5(ctx, buf->bi5 + 1, cdl_len);
-	} while (rd1cbi5(ctx->infd, buf->bi5 + 1));
-	return;
-
-old_fmt:
-	/* polish the probe */
-	buf->bin->ts = be64toh(buf->bin->ts);
-	buf->bin->o.i = be64toh(buf->bin->o.i);
-	buf->bin->c.i = be64toh(buf->bin->c.i);
-	buf->bin->l.i = be64toh(buf->bin->l.i);
-	buf->bin->h.i = be64toh(buf->bin->h.i);
-	buf->bin->v.i = be64toh(buf->bin->v.i);
-	if (!rd1c(ctx->infd, buf->bin + 1)) {
-		/* assume a day candle and exit */
-		write_cdl(ctx, buf->bin, 86400U);
 		return;
 	}
-	/* otherwise compute the candle length, we know dukascopy will
-	 * not give us overlapping candles, so just diff the time stamps */
-	cdl_len = (buf->bin[1].ts - buf->bin->ts) / 1000;
-	/* and emit the original candle from the probe data */
-	write_cdl(ctx, buf->bin, cdl_len);
-	/* main loop */
-	do {
-		write_cdl(ctx, buf->bin + 1, cdl_len);
-	} while (rd1c(ctx->infd, buf->bin + 1));
+	with (const size_t n = z / sizeof(*bi5)) {
+		be32toh_n((void*)buf, n * sizeof(*bi5) / sizeof(uint32_t));
+		for (size_t i = 0U; i < n; i++) {
+			write_cdl_bi5(ctx, (struct dcbi5_s*)buf + i, cdl_len);
+		}
+	}
 	return;
 }
 
 static void
-dump_l1bi5(mux_ctx_t ctx)
+dump_l1bi5(mux_ctx_t ctx, char *buf, size_t z)
 {
-	union {
-		struct dc_s bin[1];
-		struct dqbi5_s bi5[2];
-	} buf[1];
+	const struct dqbi5_s *bi5 = (const void*)buf;
 
-	/* rinse, rinse, rinse */
-	memset(buf, 0, sizeof(*buf));
-
-	/* read a probe */
-	if (UNLIKELY(read(ctx->infd, buf->bi5, sizeof(buf->bi5)) <= 0)) {
+	if (UNLIKELY(z == 0U)) {
 		return;
 	}
 	/* the only thing we can make assumptions about is the timestamp
 	 * we check the two stamps in bi5 and compare their distance */
-	{
-		uint32_t ts0 = be32toh(buf->bi5[0].ts);
-		uint32_t ts1 = be32toh(buf->bi5[1].ts);
-
-		if (ts1 - ts0 > 60/*min*/ * 60/*sec*/ * 1000/*msec*/) {
-			/* definitely old_fmt */
-			goto old_fmt;
+	if (be32toh(bi5[1U].ts) - be32toh(bi5[0U].ts) >
+	    60/*min*/ * 60/*sec*/ * 1000/*msec*/) {
+		/* definitely old_fmt */
+		return;
+	}
+	with (const size_t n = z / sizeof(*bi5)) {
+		be32toh_n((void*)buf, n * sizeof(*bi5) / sizeof(uint32_t));
+		for (size_t i = 0U; i < n; i++) {
+			dump_tick_bi5(ctx, (struct dqbi5_s*)buf + i);
 		}
-
-		/* quickly polish the probe */
-		buf->bi5[0].ts = ts0;
-		buf->bi5[0].ap = be32toh(buf->bi5[0].ap);
-		buf->bi5[0].bp = be32toh(buf->bi5[0].bp);
-		buf->bi5[0].aq.i = be32toh(buf->bi5[0].aq.i);
-		buf->bi5[0].bq.i = be32toh(buf->bi5[0].bq.i);
-
-		buf->bi5[1].ts = ts1;
-		buf->bi5[1].ap = be32toh(buf->bi5[1].ap);
-		buf->bi5[1].bp = be32toh(buf->bi5[1].bp);
-		buf->bi5[1].aq.i = be32toh(buf->bi5[1].aq.i);
-		buf->bi5[1].bq.i = be32toh(buf->bi5[1].bq.i);
-	}
-	/* re-use the probe data */
-	dump_tick_bi5(ctx, buf->bi5 + 0);
-	/* main loop */
-	do {
-		dump_tick_bi5(ctx, buf->bi5 + 1);
-	} while (rd1bi5(ctx->infd, buf->bi5 + 1));
-old_fmt:
+	}
 	return;
 }
 
@@ -593,17 +591,24 @@ guess(mux_ctx_t ctx, const char *fn)
 void
 mux(mux_ctx_t ctx)
 {
+	char *buf;
+	size_t z;
+
+	if (UNLIKELY((buf = rdin(ctx->infd, &z)) == NULL)) {
+		return;
+	}
 	prepare(ctx);
 	switch (ctx->opts->tt) {
 	case SL1T_TTF_BID:
 	case SL1T_TTF_ASK:
 		scdl_set_ttf(c, ctx->opts->tt);
-		proc_cdbi5(ctx);
+		proc_cdbi5(ctx, buf, z);
 		break;
 	default:
-		proc_l1bi5(ctx);
+		proc_l1bi5(ctx, buf, z);
 		break;
 	}
+	free(buf);
 	return;
 }
 
@@ -667,7 +672,13 @@ mux_main(mux_ctx_t ctx, int argc, char *argv[])
 		}
 		/* ... and now mux it */
 		if (argi->human_readable_flag) {
-			dump_l1bi5(ctx);
+			char *buf;
+			size_t z;
+
+			if ((buf = rdin(fd, &z)) != NULL) {
+				dump_l1bi5(ctx, buf, z);
+				free(buf);
+			}
 		} else {
 			mux(ctx);
 		}
@@ -105,6 +105,9 @@ moar_ticks_p(mux_ctx_t ctx)
 
 static zif_t z_cet = NULL;
 
+/* lines don't depend on each other, ute-mux may cut our inputs */
+const int mux_linewise = 1;
+
 static int
 parse_rcv_stmp(fxst_msg_t tgt, const char **cursor)
 {
@@ -157,8 +160,11 @@ parse_line(mux_ctx_t ctx, fxst_msg_t msg)
 	char *line;
 	size_t llen;
 	const char *cursor;
+	const uint32_t *fo;
+	size_t nfo;
 
 	llen = prchunk_getline(ctx->rdr, &line);
+	nfo = prchunk_getfo(ctx->rdr, &fo);
 
 	/* we parse the line in 3 steps, receive time stamp, symbol, values */
 	cursor = line;
@@ -168,15 +174,17 @@ parse_line(mux_ctx_t ctx, fxst_msg_t msg)
 	}
 	/* parse the rest */
 	llen -= cursor - line;
+	/* need the tabs after the symbol and the date too */
+	if (UNLIKELY(nfo < 3U)) {
+		goto bugger;
+	}
 
 	/* go parse the symbol */
 	{
-		char *eosym;
+		/* the stamp's tab was the first one */
+		char *eosym = line + fo[1U];
 
-		if ((eosym = strchr(cursor, '\t')) == NULL) {
-			goto bugger;
-		}
-		/* else finalise it */
+		/* finalise it */
 		*eosym = '\0';
 		/* look 'im up */
 		msg->snp->hdr->idx = ute_sym2idx(ctx->wrr, cursor);
@@ -187,12 +195,9 @@ parse_line(mux_ctx_t ctx, fxst_msg_t msg)
 	}
 	/* parse the time stamp */
 	{
-		char *eodt;
+		char *eodt = line + fo[2U];
 
-		if ((eodt = strchr(cursor, '\t')) == NULL) {
-			goto bugger;
-		}
-		/* else finalise it */
+		/* finalise it */
 		*eodt = '\0';
 		/* parse the stamp (and convert to UTC) */
 		msg->snp->hdr->sec = parse_ymdhmstz(cursor, z_cet, ' ');
@@ -278,6 +283,7 @@ mux(mux_ctx_t ctx)
 
 	/* init reader, we use prchunk here */
 	ctx->rdr = init_prchunk(ctx->infd);
+	prchunk_set_delim(ctx->rdr, '\t');
 	/* intitialise the CET zone */
 	z_cet = zif_open(cet);
 
@@ -42,6 +42,8 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 
 /* hdf5 glue */
 #include <hdf5.h>
@@ -81,12 +83,36 @@ struct mctx_s {
 	hid_t spc;
 	hid_t mem;
 	hid_t plist;
+	hid_t dapl;
 	hid_t fty;
 	hid_t mty;
-	cache_t cch;
 
+	/* rows per chunk, rows per cache, deflate level or -1 */
+	size_t nchunk;
+	size_t ncache;
+	int deflate;
+
+	/* printer side, a cache per series */
+	cache_t cch;
 	size_t nidxs;
 	utectx_t u;
+
+	/* writer side, a set of datasets per series */
+	struct h5ser_s *ser;
+	size_t nser;
+	/* scratch space for the writer's flushes */
+	void *scr;
+
+	/* jobs to do, read at JR, written at JW, and caches done with */
+	pthread_t wrr;
+	pthread_mutex_t mtx;
+	pthread_cond_t job_cnd;
+	pthread_cond_t room_cnd;
+	struct job_s *jobs;
+	size_t jr;
+	size_t jw;
+	atom_t *fre;
+	size_t nfre;
 };
 
 struct atom_s {
@@ -164,15 +190,32 @@ __resize(void *p, size_t nol, size_t nnu, size_t blsz)
 }
 
 
+/* rows per chunk and rows cached per series, unless told otherwise */
 #define CHUNK_INC	(1024)
+/* number of full caches handed to the writer but not yet written */
+#define NJOBS		(16U)
 
+/* the printer side of a series, its cache and dataset group name */
 struct cache_s {
 	size_t nbang;
+	atom_t vals;
+	char *nam;
+};
+
+/* the writer side of a series, its groups and datasets */
+struct h5ser_s {
 	hid_t grp;
 	hid_t tsgrp;
 	hid_t dat[4];
 	hid_t tss[4];
-	struct atom_s vals[CHUNK_INC];
+};
+
+/* a full (or final) cache on its way to the writer */
+struct job_s {
+	unsigned int idx;
+	const char *nam;
+	size_t nbang;
+	atom_t vals;
 };
 
 static const char ute_dsnam[] = "/default";
@@ -198,7 +241,7 @@ make_dat(mctx_t ctx, const hid_t grp, const char *nam)
 	const hid_t ds_ty = ctx->fty;
 	const hid_t ln_crea = H5P_DEFAULT;
 	const hid_t ds_crea = ctx->plist;
-	const hid_t ds_acc = H5P_DEFAULT;
+	const hid_t ds_acc = ctx->dapl;
 
 	return H5Dcreate(grp, nam, ds_ty, spc, ln_crea, ds_crea, ds_acc);
 }
@@ -210,71 +253,102 @@ make_tss(mctx_t ctx, const hid_t grp, const char *nam)
 	const hid_t ds_ty = H5T_UNIX_D64LE;
 	const hid_t ln_crea = H5P_DEFAULT;
 	const hid_t ds_crea = ctx->plist;
-	const hid_t ds_acc = H5P_DEFAULT;
+	const hid_t ds_acc = ctx->dapl;
 
 	return H5Dcreate(grp, nam, ds_ty, spc, ln_crea, ds_crea, ds_acc);
 }
 
-static hid_t
-get_grp(mctx_t ctx, unsigned int idx)
+static struct h5ser_s*
+get_ser(mctx_t ctx, const struct job_s *j)
 {
-	if (ctx->cch[idx].grp == 0) {
-		const char *dnam;
-		if (LIKELY(idx > 0U)) {
-			dnam = ute_idx2sym(ctx->u, idx);
-		} else {
-			dnam = ute_dsnam;
-		}
+	const unsigned int idx = j->idx;
+
+	/* check for resize */
+	if (idx >= ctx->nser) {
+		const size_t ol = ctx->nser;
+		const size_t nu = idx + 1U;
+		ctx->ser = __resize(ctx->ser, ol, nu, sizeof(*ctx->ser));
+		ctx->nser = nu;
+	}
+	if (ctx->ser[idx].grp == 0) {
 		/* singleton */
-		ctx->cch[idx].grp = make_grp(ctx, dnam);
+		ctx->ser[idx].grp = make_grp(ctx, j->nam);
 	}
-	return ctx->cch[idx].grp;
+	return ctx->ser + idx;
 }
 
 static hid_t
-get_tsgrp(mctx_t ctx, unsigned int idx)
+get_tsgrp(mctx_t ctx, const struct job_s *j)
 {
-	hid_t grp = get_grp(ctx, idx);
+	struct h5ser_s *s = get_ser(ctx, j);
 
-	if (ctx->cch[idx].tsgrp == 0) {
+	if (s->tsgrp == 0) {
 		const char dnam[] = "ts";
 
 		/* singleton */
-		ctx->cch[idx].tsgrp = H5Gcreate1(grp, dnam, 4U);
+		s->tsgrp = H5Gcreate1(s->grp, dnam, 4U);
 	}
-	return ctx->cch[idx].tsgrp;
+	return s->tsgrp;
 }
 
 static hid_t
-get_dat(mctx_t ctx, unsigned int idx, uint16_t ttf)
+get_dat(mctx_t ctx, const struct job_s *j, uint16_t ttf)
 {
-	hid_t grp = get_grp(ctx, idx);
+	struct h5ser_s *s = get_ser(ctx, j);
 	size_t i = ttf & 0x3;
 
-	if (ctx->cch[idx].dat[i] == 0) {
+	if (s->dat[i] == 0) {
 		static const char *nams[] = {
 			"snap", "bid", "ask", "trade"
 		};
 		/* singleton */
-		ctx->cch[idx].dat[i] = make_dat(ctx, grp, nams[i]);
+		s->dat[i] = make_dat(ctx, s->grp, nams[i]);
 	}
-	return ctx->cch[idx].dat[i];
+	return s->dat[i];
 }
 
 static hid_t
-get_tss(mctx_t ctx, unsigned int idx, uint16_t ttf)
+get_tss(mctx_t ctx, const struct job_s *j, uint16_t ttf)
 {
-	hid_t grp = get_tsgrp(ctx, idx);
+	hid_t grp = get_tsgrp(ctx, j);
+	struct h5ser_s *s = ctx->ser + j->idx;
 	size_t i = ttf & 0x3;
 
-	if (ctx->cch[idx].tss[i] == 0) {
+	if (s->tss[i] == 0) {
 		static const char *nams[] = {
 			"snap", "bid", "ask", "trade"
 		};
 		/* singleton */
-		ctx->cch[idx].tss[i] = make_tss(ctx, grp, nams[i]);
+		s->tss[i] = make_tss(ctx, grp, nams[i]);
+	}
+	return s->tss[i];
+}
+
+static void
+make_plist(mctx_t ctx, size_t rank, const hsize_t chunk[static rank])
+{
+/* dataset creation and access properties, as per the options */
+	size_t chsz = H5Tget_size(ctx->fty);
+
+	ctx->plist = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(ctx->plist, rank, chunk);
+	if (ctx->deflate >= 0) {
+		H5Pset_shuffle(ctx->plist);
+		H5Pset_deflate(ctx->plist, ctx->deflate);
 	}
-	return ctx->cch[idx].tss[i];
+
+	/* keep a couple of chunks per dataset in the chunk cache, so
+	 * appends to a partial chunk don't go back to the disk */
+	for (size_t i = 0U; i < rank; i++) {
+		chsz *= chunk[i];
+	}
+	ctx->dapl = H5Pcreate(H5P_DATASET_ACCESS);
+	if (2U * chsz > 1024U * 1024U) {
+		H5Pset_chunk_cache(
+			ctx->dapl, H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+			2U * chsz, H5D_CHUNK_CACHE_W0_DEFAULT);
+	}
+	return;
 }
 
 
@@ -316,16 +390,16 @@ hdf5_open_comp(mctx_t ctx, const char *fn)
 	/* generate the data space */
 	ctx->spc = H5Screate_simple(countof(dims), dims, maxdims);
 
-	/* create a plist */
-	dims[countof(dims) - 1] = CHUNK_INC;
-	ctx->plist = H5Pcreate(H5P_DATASET_CREATE);
-	H5Pset_chunk(ctx->plist, countof(dims), dims);
-	/* just one more for slabbing later on */
-	ctx->mem = H5Screate_simple(countof(dims), dims, dims);
-
 	/* generate the types we're one about */
 	ctx->fty = make_fil_type();
 	ctx->mty = make_mem_type();
+
+	/* create a plist */
+	dims[countof(dims) - 1] = ctx->nchunk;
+	make_plist(ctx, countof(dims), dims);
+	/* just one more for slabbing later on */
+	dims[countof(dims) - 1] = ctx->ncache;
+	ctx->mem = H5Screate_simple(countof(dims), dims, dims);
 	return;
 }
 
@@ -334,6 +408,7 @@ hdf5_close_comp(mctx_t ctx)
 {
 	(void)H5Tclose(ctx->fty);
 	(void)H5Tclose(ctx->mty);
+	(void)H5Pclose(ctx->dapl);
 	(void)H5Pclose(ctx->plist);
 	(void)H5Sclose(ctx->mem);
 	(void)H5Sclose(ctx->spc);
@@ -342,11 +417,11 @@ hdf5_close_comp(mctx_t ctx)
 }
 
 static void
-cache_flush_comp(mctx_t ctx, size_t idx, size_t ttf, const cache_t cch)
+cache_flush_comp(mctx_t ctx, size_t ttf, const struct job_s *j)
 {
-	const hid_t dat = get_dat(ctx, idx, ttf);
+	const hid_t dat = get_dat(ctx, j, ttf);
 	const hid_t mem = ctx->mem;
-	const hsize_t nbang = cch->nbang;
+	const hsize_t nbang = j->nbang;
 	hsize_t ol_dims[] = {0, 0, 0};
 	hsize_t nu_dims[] = {0, 0, 0};
 	hsize_t sta[] = {0, 0, 0};
@@ -356,6 +431,7 @@ cache_flush_comp(mctx_t ctx, size_t idx, size_t ttf, const cache_t cch)
 	/* get current dimensions */
 	spc = H5Dget_space(dat);
 	H5Sget_simple_extent_dims(spc, ol_dims, NULL);
+	H5Sclose(spc);
 
 	/* nbang more rows, make sure we're at least as wide as we say */
 	nu_dims[0] = ol_dims[0];
@@ -373,7 +449,8 @@ cache_flush_comp(mctx_t ctx, size_t idx, size_t ttf, const cache_t cch)
 	H5Sselect_hyperslab(spc, H5S_SELECT_SET, sta, NULL, cnt, NULL);
 
 	/* final flush */
-	H5Dwrite(dat, ctx->mty, mem, spc, H5P_DEFAULT, cch->vals);
+	H5Dwrite(dat, ctx->mty, mem, spc, H5P_DEFAULT, j->vals);
+	H5Sclose(spc);
 	return;
 }
 
@@ -397,22 +474,23 @@ hdf5_open_plain(mctx_t ctx, const char *fn)
 	/* generate the data space */
 	ctx->spc = H5Screate_simple(countof(dims), dims, maxdims);
 
+	ctx->fty = H5T_IEEE_F64LE;
+	ctx->mty = H5T_NATIVE_DOUBLE;
+
 	/* create a plist */
 	dims[0] = maxdims[0];
-	dims[1] = CHUNK_INC;
-	ctx->plist = H5Pcreate(H5P_DATASET_CREATE);
-	H5Pset_chunk(ctx->plist, countof(dims), dims);
+	dims[1] = ctx->nchunk;
+	make_plist(ctx, countof(dims), dims);
 	/* just one more for slabbing later on */
+	dims[1] = ctx->ncache;
 	ctx->mem = H5Screate_simple(countof(dims), dims, dims);
-
-	ctx->fty = H5T_IEEE_F64LE;
-	ctx->mty = H5T_NATIVE_DOUBLE;
 	return;
 }
 
 static void
 hdf5_close_plain(mctx_t ctx)
 {
+	(void)H5Pclose(ctx->dapl);
 	(void)H5Pclose(ctx->plist);
 	(void)H5Sclose(ctx->mem);
 	(void)H5Sclose(ctx->spc);
@@ -430,14 +508,45 @@ ttf_dimen(uint16_t ttf)
 	return 4U;
 }
 
+static size_t
+cache_count(const struct job_s *j, size_t ttf)
+{
+/* number of rows of tick type TTF in J */
+	size_t res = 0U;
+
+	for (size_t i = 0; i < j->nbang; i++) {
+		res += (j->vals[i].ttf & 0x3) == ttf;
+	}
+	return res;
+}
+
+static void
+grow_dat(const hid_t dat, size_t nfld, size_t nbang, hsize_t ol_dims[static 2])
+{
+/* make room for NBANG more rows (of NFLD fields) in DAT,
+ * put the dimensions before that into OL_DIMS */
+	hsize_t nu_dims[2];
+	hid_t spc;
+
+	spc = H5Dget_space(dat);
+	H5Sget_simple_extent_dims(spc, ol_dims, NULL);
+	H5Sclose(spc);
+
+	/* never shrink, that would throw away what's there */
+	nu_dims[0] = ol_dims[0] > nfld ? ol_dims[0] : nfld;
+	nu_dims[1] = ol_dims[1] + nbang;
+	H5Dset_extent(dat, nu_dims);
+	return;
+}
+
 static void
 cache_flush_4(
-	const hid_t dat, const hid_t mem,
-	size_t bangd, size_t flav, const cache_t cch, size_t ttf)
+	mctx_t ctx, const hid_t dat,
+	size_t bangd, size_t flav, const struct job_s *j, size_t ttf)
 {
 	const hid_t mty = H5T_NATIVE_DOUBLE;
-	double vals[CHUNK_INC];
-	hsize_t nu_dims[] = {0, 0};
+	const hid_t mem = ctx->mem;
+	double *vals = ctx->scr;
 	hsize_t mix[] = {0, 0};
 	hsize_t sta[] = {flav, bangd};
 	hsize_t cnt[] = {1, -1};
@@ -445,19 +554,16 @@ cache_flush_4(
 	size_t nbang = 0;
 
 	/* copy them values */
-	for (size_t i = 0; i < cch->nbang; i++) {
-		if ((cch->vals[i].ttf & 0x3) == ttf) {
-			vals[nbang++] = cch->vals[i].d[flav];
+	for (size_t i = 0; i < j->nbang; i++) {
+		if ((j->vals[i].ttf & 0x3) == ttf) {
+			vals[nbang++] = j->vals[i].d[flav];
 		}
 	}
 	if (UNLIKELY(nbang == 0U)) {
 		return;
 	}
 
-	/* nbang more rows, make sure we're at least as wide as we say */
-	nu_dims[0] = ttf_dimen(ttf);
-	nu_dims[1] = bangd + nbang;
-	H5Dset_extent(dat, nu_dims);
+	/* the caller has made room already */
 	spc = H5Dget_space(dat);
 
 	/* select a hyperslab (for open) in the mem space */
@@ -470,17 +576,18 @@ cache_flush_4(
 
 	/* final flush */
 	H5Dwrite(dat, mty, mem, spc, H5P_DEFAULT, vals);
+	H5Sclose(spc);
 	return;
 }
 
 static void
 cache_flush_ts(
-	const hid_t dat, const hid_t mem,
-	size_t bangd, const cache_t cch, size_t ttf)
+	mctx_t ctx, const hid_t dat,
+	size_t bangd, const struct job_s *j, size_t ttf)
 {
 	const hid_t mty = H5T_UNIX_D64LE;
-	int64_t vals[CHUNK_INC];
-	hsize_t nu_dims[] = {0, 0};
+	const hid_t mem = ctx->mem;
+	int64_t *vals = ctx->scr;
 	hsize_t mix[] = {0, 0};
 	hsize_t sta[] = {0, bangd};
 	hsize_t cnt[] = {1, -1};
@@ -488,19 +595,16 @@ cache_flush_ts(
 	size_t nbang = 0;
 
 	/* copy them values */
-	for (size_t i = 0; i < cch->nbang; i++) {
-		if ((cch->vals[i].ttf & 0x3) == ttf) {
-			vals[nbang++] = cch->vals[i].ts;
+	for (size_t i = 0; i < j->nbang; i++) {
+		if ((j->vals[i].ttf & 0x3) == ttf) {
+			vals[nbang++] = j->vals[i].ts;
 		}
 	}
 	if (UNLIKELY(nbang == 0U)) {
 		return;
 	}
 
-	/* nbang more rows, make sure we're at least as wide as we say */
-	nu_dims[0] = 1;
-	nu_dims[1] = bangd + nbang;
-	H5Dset_extent(dat, nu_dims);
+	/* the caller has made room already */
 	spc = H5Dget_space(dat);
 
 	/* select a hyperslab (for open) in the mem space */
@@ -513,37 +617,36 @@ cache_flush_ts(
 
 	/* final flush */
 	H5Dwrite(dat, mty, mem, spc, H5P_DEFAULT, vals);
+	H5Sclose(spc);
 	return;
 }
 
 static void
-cache_flush_plain(mctx_t ctx, size_t idx, size_t ttf, const cache_t cch)
+cache_flush_plain(mctx_t ctx, size_t ttf, const struct job_s *j)
 {
-	const hid_t dat = get_dat(ctx, idx, ttf);
-	const hid_t tss = get_tss(ctx, idx, ttf);
+	const hid_t dat = get_dat(ctx, j, ttf);
+	const hid_t tss = get_tss(ctx, j, ttf);
+	const size_t nbang = cache_count(j, ttf);
 	hsize_t ol_dims[] = {0, 0};
-	hid_t spc;
 
-	/* get current dimensions */
-	spc = H5Dget_space(dat);
-	H5Sget_simple_extent_dims(spc, ol_dims, NULL);
+	/* nbang more rows, all at once */
+	grow_dat(dat, ttf_dimen(ttf), nbang, ol_dims);
 
 	/* now flush them one by one */
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 0/*open*/, cch, ttf);
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 1/*high*/, cch, ttf);
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 2/*low*/, cch, ttf);
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 3/*close*/, cch, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 0/*open*/, j, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 1/*high*/, j, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 2/*low*/, j, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 3/*close*/, j, ttf);
 	if (ttf_dimen(ttf) > 4U) {
-		cache_flush_4(dat, ctx->mem, ol_dims[1], 4/*vol*/, cch, ttf);
-		cache_flush_4(dat, ctx->mem, ol_dims[1], 5/*wap*/, cch, ttf);
+		cache_flush_4(ctx, dat, ol_dims[1], 4/*vol*/, j, ttf);
+		cache_flush_4(ctx, dat, ol_dims[1], 5/*wap*/, j, ttf);
 	}
 
 	/* same for timestamps */
-	spc = H5Dget_space(tss);
-	H5Sget_simple_extent_dims(spc, ol_dims, NULL);
+	grow_dat(tss, 1U, nbang, ol_dims);
 
 	/* flush */
-	cache_flush_ts(tss, ctx->mem, ol_dims[1], cch, ttf);
+	cache_flush_ts(ctx, tss, ol_dims[1], j, ttf);
 	return;
 }
 
@@ -566,12 +669,13 @@ u_to_mlabdt(uint32_t x)
 
 static void
 cache_flush_2ts(
-	const hid_t dat, const hid_t mem,
-	size_t bangd, const cache_t cch, size_t ttf)
+	mctx_t ctx, const hid_t dat,
+	size_t bangd, const struct job_s *j, size_t ttf)
 {
 	const hid_t mty = H5T_NATIVE_DOUBLE;
-	double vals[2 * CHUNK_INC];
-	hsize_t nu_dims[] = {0, 0};
+	const hid_t mem = ctx->mem;
+	const size_t ncache = ctx->ncache;
+	double *vals = ctx->scr;
 	hsize_t mix[] = {0, 0};
 	hsize_t sta[] = {ttf_dimen(ttf), bangd};
 	hsize_t cnt[] = {2, -1};
@@ -579,24 +683,17 @@ cache_flush_2ts(
 	size_t nbang = 0;
 
 	/* copy them values */
-	for (size_t i = 0; i < cch->nbang; i++) {
-		if ((cch->vals[i].ttf & 0x3) == ttf) {
-			vals[CHUNK_INC + nbang] = u_to_mlabdt(cch->vals[i].ts);
-			vals[nbang++] = u_to_mlabdt(cch->vals[i].sta);
+	for (size_t i = 0; i < j->nbang; i++) {
+		if ((j->vals[i].ttf & 0x3) == ttf) {
+			vals[ncache + nbang] = u_to_mlabdt(j->vals[i].ts);
+			vals[nbang++] = u_to_mlabdt(j->vals[i].sta);
 		}
 	}
 	if (UNLIKELY(nbang == 0U)) {
 		return;
 	}
-	/* make the array contiguous again */
-	for (size_t i = 0; i < nbang; i++) {
-		vals[nbang + i] = vals[CHUNK_INC + i];
-	}
-
-	/* nbang more rows, make sure we're at least as wide as we say */
-	nu_dims[0] = sta[0] + 2;
-	nu_dims[1] = bangd + nbang;
-	H5Dset_extent(dat, nu_dims);
+	/* the second row sits at NCACHE in the mem space, leave it there */
+	/* the caller has made room already */
 	spc = H5Dget_space(dat);
 
 	/* select a hyperslab (for open) in the mem space */
@@ -610,32 +707,32 @@ cache_flush_2ts(
 
 	/* final flush */
 	H5Dwrite(dat, mty, mem, spc, H5P_DEFAULT, vals);
+	H5Sclose(spc);
 	return;
 }
 
 static void
-cache_flush_mlab(mctx_t ctx, size_t idx, size_t ttf, const cache_t cch)
+cache_flush_mlab(mctx_t ctx, size_t ttf, const struct job_s *j)
 {
-	const hid_t dat = get_dat(ctx, idx, ttf);
+	const hid_t dat = get_dat(ctx, j, ttf);
+	const size_t nbang = cache_count(j, ttf);
 	hsize_t ol_dims[] = {0, 0};
-	hid_t spc;
 
-	/* get current dimensions */
-	spc = H5Dget_space(dat);
-	H5Sget_simple_extent_dims(spc, ol_dims, NULL);
+	/* nbang more rows, along with the time stamps, all at once */
+	grow_dat(dat, ttf_dimen(ttf) + 2U, nbang, ol_dims);
 
 	/* now flush them one by one */
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 0/*open*/, cch, ttf);
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 1/*high*/, cch, ttf);
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 2/*low*/, cch, ttf);
-	cache_flush_4(dat, ctx->mem, ol_dims[1], 3/*close*/, cch, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 0/*open*/, j, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 1/*high*/, j, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 2/*low*/, j, ttf);
+	cache_flush_4(ctx, dat, ol_dims[1], 3/*close*/, j, ttf);
 	if (ttf_dimen(ttf) > 4U) {
-		cache_flush_4(dat, ctx->mem, ol_dims[1], 4/*vol*/, cch, ttf);
-		cache_flush_4(dat, ctx->mem, ol_dims[1], 5/*wap*/, cch, ttf);
+		cache_flush_4(ctx, dat, ol_dims[1], 4/*vol*/, j, ttf);
+		cache_flush_4(ctx, dat, ol_dims[1], 5/*wap*/, j, ttf);
 	}
 
 	/* flush */
-	cache_flush_2ts(dat, ctx->mem, ol_dims[1], cch, ttf);
+	cache_flush_2ts(ctx, dat, ol_dims[1], j, ttf);
 	return;
 }
 
@@ -646,31 +743,124 @@ static const struct h5cb_s h5_mlab_cb = {
 };
 
 
-/* cache fiddling and interaction with the h5 funs */
+/* the writer, the only one to talk to hdf5 once things are set up,
+ * it works off full caches in the order they've been handed over */
 static const struct h5cb_s *h5cb;
 
 static void
-cache_init(mctx_t ctx)
-{
-	ctx->cch = NULL;
-	ctx->nidxs = 0UL;
-	return;
-}
-
-static void
-cache_sift(mctx_t ctx, size_t idx, const cache_t cch)
+cache_sift(mctx_t ctx, const struct job_s *j)
 {
 /* sift throught the cache and call the flush function on ttfs in question */
 	unsigned int flags = 0;
-	const size_t nbang = cch->nbang;
+	const size_t nbang = j->nbang;
 
 	for (size_t i = 0; i < nbang; i++) {
-		flags |= 1U << (cch->vals[i].ttf & 0x3);
+		flags |= 1U << (j->vals[i].ttf & 0x3);
 	}
 	for (size_t ttf = 0; ttf < 4; ttf++) {
 		if (flags & (1 << ttf)) {
-			h5cb->cch_flush_f(ctx, idx, ttf, cch);
+			h5cb->cch_flush_f(ctx, ttf, j);
+		}
+	}
+	return;
+}
+
+static void*
+wrr_thr(void *clo)
+{
+	mctx_t ctx = clo;
+
+	for (;;) {
+		struct job_s j;
+
+		pthread_mutex_lock(&ctx->mtx);
+		while (ctx->jr == ctx->jw) {
+			pthread_cond_wait(&ctx->job_cnd, &ctx->mtx);
+		}
+		j = ctx->jobs[ctx->jr % NJOBS];
+		pthread_mutex_unlock(&ctx->mtx);
+
+		if (UNLIKELY(j.vals == NULL)) {
+			/* that's the end */
+			break;
 		}
+		cache_sift(ctx, &j);
+
+		/* job's done, hand back the cache */
+		pthread_mutex_lock(&ctx->mtx);
+		ctx->jr++;
+		if (ctx->nfre < NJOBS) {
+			ctx->fre[ctx->nfre++] = j.vals;
+		} else {
+			free(j.vals);
+		}
+		pthread_cond_signal(&ctx->room_cnd);
+		pthread_mutex_unlock(&ctx->mtx);
+	}
+	return NULL;
+}
+
+static void
+wrr_push(mctx_t ctx, struct job_s j)
+{
+	pthread_mutex_lock(&ctx->mtx);
+	while (ctx->jw - ctx->jr >= NJOBS) {
+		pthread_cond_wait(&ctx->room_cnd, &ctx->mtx);
+	}
+	ctx->jobs[ctx->jw++ % NJOBS] = j;
+	pthread_cond_signal(&ctx->job_cnd);
+	pthread_mutex_unlock(&ctx->mtx);
+	return;
+}
+
+
+/* cache fiddling, on the printer side */
+static int
+cache_init(mctx_t ctx)
+{
+	ctx->cch = NULL;
+	ctx->nidxs = 0UL;
+	ctx->ser = NULL;
+	ctx->nser = 0UL;
+	ctx->jr = ctx->jw = 0U;
+	ctx->nfre = 0U;
+	ctx->jobs = calloc(NJOBS, sizeof(*ctx->jobs));
+	ctx->fre = calloc(NJOBS, sizeof(*ctx->fre));
+	/* scratch space for the writer, 2 values per cached row */
+	ctx->scr = malloc(2U * ctx->ncache * sizeof(double));
+	if (ctx->jobs == NULL || ctx->fre == NULL || ctx->scr == NULL) {
+		goto nope;
+	}
+	pthread_mutex_init(&ctx->mtx, NULL);
+	pthread_cond_init(&ctx->job_cnd, NULL);
+	pthread_cond_init(&ctx->room_cnd, NULL);
+	if (pthread_create(&ctx->wrr, NULL, wrr_thr, ctx) != 0) {
+		pthread_cond_destroy(&ctx->room_cnd);
+		pthread_cond_destroy(&ctx->job_cnd);
+		pthread_mutex_destroy(&ctx->mtx);
+		goto nope;
+	}
+	return 0;
+nope:
+	free(ctx->jobs);
+	free(ctx->fre);
+	free(ctx->scr);
+	ctx->jobs = NULL;
+	return -1;
+}
+
+static void
+cache_ship(mctx_t ctx, unsigned int idx, const cache_t cch)
+{
+/* hand the cache of series IDX to the writer, get a fresh one */
+	wrr_push(ctx, (struct job_s){idx, cch->nam, cch->nbang, cch->vals});
+
+	/* recycle a cache the writer is done with, if any */
+	pthread_mutex_lock(&ctx->mtx);
+	cch->vals = ctx->nfre ? ctx->fre[--ctx->nfre] : NULL;
+	pthread_mutex_unlock(&ctx->mtx);
+	if (cch->vals == NULL) {
+		cch->vals = malloc(ctx->ncache * sizeof(*cch->vals));
 	}
 	/* reset the nbang and off we are */
 	cch->nbang = 0UL;
@@ -680,31 +870,59 @@ cache_sift(mctx_t ctx, size_t idx, const cache_t cch)
 static void
 cache_fini(mctx_t ctx)
 {
-	for (size_t i = 0; i <= ctx->nidxs; i++) {
+	for (size_t i = 0; ctx->cch != NULL && i <= ctx->nidxs; i++) {
 		if (ctx->cch[i].nbang) {
 			UDEBUG("draining %zu: %zu\n", i, ctx->cch[i].nbang);
-			cache_sift(ctx, i, ctx->cch + i);
+			wrr_push(ctx, (struct job_s){
+					 i, ctx->cch[i].nam,
+					 ctx->cch[i].nbang, ctx->cch[i].vals});
+			ctx->cch[i].vals = NULL;
 		}
+	}
+	/* no more jobs, wait for the writer to finish off */
+	wrr_push(ctx, (struct job_s){0U});
+	pthread_join(ctx->wrr, NULL);
+	pthread_cond_destroy(&ctx->room_cnd);
+	pthread_cond_destroy(&ctx->job_cnd);
+	pthread_mutex_destroy(&ctx->mtx);
+
+	for (size_t i = 0; i < ctx->nser; i++) {
 		/* close them datasets */
 		for (size_t ttf = 0; ttf < 4; ttf++) {
-			if (ctx->cch[i].dat[ttf]) {
-				(void)H5Dclose(ctx->cch[i].dat[ttf]);
+			if (ctx->ser[i].dat[ttf]) {
+				(void)H5Dclose(ctx->ser[i].dat[ttf]);
 			}
-			if (ctx->cch[i].tss[ttf]) {
-				(void)H5Dclose(ctx->cch[i].tss[ttf]);
+			if (ctx->ser[i].tss[ttf]) {
+				(void)H5Dclose(ctx->ser[i].tss[ttf]);
 			}
 		}
 		/* close the groups */
-		if (ctx->cch[i].grp) {
-			(void)H5Gclose(ctx->cch[i].grp);
-			ctx->cch[i].grp = 0;
+		if (ctx->ser[i].grp) {
+			(void)H5Gclose(ctx->ser[i].grp);
+		}
+		if (ctx->ser[i].tsgrp) {
+			(void)H5Gclose(ctx->ser[i].tsgrp);
 		}
-		if (ctx->cch[i].tsgrp) {
-			(void)H5Gclose(ctx->cch[i].tsgrp);
-			ctx->cch[i].tsgrp = 0;
+	}
+	__resize(ctx->ser, ctx->nser, 0U, sizeof(*ctx->ser));
+
+	for (size_t i = 0; ctx->cch != NULL && i <= ctx->nidxs; i++) {
+		if (ctx->cch[i].vals != NULL) {
+			free(ctx->cch[i].vals);
+		}
+		if (ctx->cch[i].nam != NULL) {
+			free(ctx->cch[i].nam);
 		}
 	}
-	__resize(ctx->cch, ctx->nidxs + 1U, 0U, sizeof(*ctx->cch));
+	if (ctx->cch != NULL) {
+		__resize(ctx->cch, ctx->nidxs + 1U, 0U, sizeof(*ctx->cch));
+	}
+	while (ctx->nfre > 0U) {
+		free(ctx->fre[--ctx->nfre]);
+	}
+	free(ctx->jobs);
+	free(ctx->fre);
+	free(ctx->scr);
 	return;
 }
 
@@ -712,14 +930,21 @@ static cache_t
 get_cch(mctx_t ctx, unsigned int idx)
 {
 	/* check for resize */
-	if (idx > ctx->nidxs) {
-		const size_t ol = ctx->nidxs + 1;
+	if (idx > ctx->nidxs || ctx->cch == NULL) {
+		const size_t ol = ctx->cch != NULL ? ctx->nidxs + 1 : 0U;
 		const size_t nu = idx + 1;
 		ctx->cch = __resize(ctx->cch, ol, nu, sizeof(*ctx->cch));
 		ctx->nidxs = idx;
+	}
+	if (UNLIKELY(ctx->cch[idx].nam == NULL)) {
+		/* the writer gets to see the name only,
+		 * the ute file might be long gone by then */
+		const char *sym;
 
-		/* for the side effect */
-		(void)get_grp(ctx, idx);
+		if (idx == 0U || (sym = ute_idx2sym(ctx->u, idx)) == NULL) {
+			sym = ute_dsnam;
+		}
+		ctx->cch[idx].nam = strdup(sym);
 	}
 	return ctx->cch + idx;
 }
@@ -728,19 +953,22 @@ static void
 bang_idx(mctx_t ctx, unsigned int idx, struct atom_s val)
 {
 	const cache_t cch = get_cch(ctx, idx);
-	const size_t nbang = cch->nbang;
-	atom_t vals = cch->vals;
 
-	vals[nbang] = val;
+	if (UNLIKELY(cch->vals == NULL &&
+		     (cch->vals = malloc(
+			      ctx->ncache * sizeof(*cch->vals))) == NULL)) {
+		return;
+	}
+	cch->vals[cch->nbang] = val;
 
 	/* check if we need to flush the whole shebang */
-	if (++cch->nbang < countof(cch->vals)) {
+	if (++cch->nbang < ctx->ncache) {
 		/* yay, we're safe */
 		return;
 	}
 
 	/* oh oh oh */
-	cache_sift(ctx, idx, ctx->cch + idx);
+	cache_ship(ctx, idx, cch);
 	return;
 }
 
@@ -762,6 +990,13 @@ init_main(pr_ctx_t pctx, int argc, char *argv[])
 		res = -1;
 		goto out;
 	}
+	/* hand back the files, without our options */
+	for (size_t i = 0U; i < argi->nargs; i++) {
+		argv[1U + i] = argi->args[i];
+	}
+	if (argi->nargs + 1U < (size_t)argc) {
+		argv[1U + argi->nargs] = NULL;
+	}
 
 	if (argi->matlab_flag) {
 		h5cb = &h5_mlab_cb;
@@ -772,6 +1007,22 @@ init_main(pr_ctx_t pctx, int argc, char *argv[])
 		h5cb = &h5_plain_cb;
 	}
 
+	/* chunking, filters and caching */
+	__gmctx->nchunk = CHUNK_INC;
+	__gmctx->ncache = CHUNK_INC;
+	__gmctx->deflate = -1;
+	if (argi->chunk_arg) {
+		__gmctx->nchunk = strtoul(argi->chunk_arg, NULL, 10) ?: CHUNK_INC;
+	}
+	if (argi->cache_arg) {
+		__gmctx->ncache = strtoul(argi->cache_arg, NULL, 10) ?: CHUNK_INC;
+	}
+	if (argi->deflate_arg) {
+		long int lvl = strtol(argi->deflate_arg, NULL, 10);
+
+		__gmctx->deflate = lvl < 0 ? 0 : lvl > 9 ? 9 : (int)lvl;
+	}
+
 	/* set up our context */
 	if ((my_fn = !mmapablep(pctx->outfd))) {
 		/* great we need a new file descriptor now
@@ -797,8 +1048,12 @@ init_main(pr_ctx_t pctx, int argc, char *argv[])
 
 	/* let hdf deal with this */
 	h5cb->open_f(__gmctx, fn);
-	/* also get the cache ready */
-	cache_init(__gmctx);
+	/* also get the cache and the writer ready */
+	if (cache_init(__gmctx) < 0) {
+		fputs("cannot set up hdf5 writer\n", stderr);
+		h5cb->close_f(__gmctx);
+		res = -1;
+	}
 
 	if (my_fn) {
 		free(fn);
@@ -812,7 +1067,7 @@ out:
 void
 fini(pr_ctx_t UNUSED(pctx))
 {
-	if (UNLIKELY(__gmctx->cch == NULL)) {
+	if (UNLIKELY(__gmctx->jobs == NULL)) {
 		return;
 	}
 	cache_fini(__gmctx);
@@ -826,7 +1081,7 @@ pr(pr_ctx_t pctx, scom_t st)
 	static int tick_warn = 0;
 	uint32_t sec = scom_thdr_sec(st);
 	uint16_t ttf = scom_thdr_ttf(st);
-	unsigned int idx = scom_thdr_tblidx(st);
+	unsigned int idx = pr_tblidx(pctx, st);
 
 	/* bang new ute context */
 	__gmctx->u = pctx->uctx;
@@ -37,8 +37,11 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#define DEFINE_GORY_STUFF
 #include "m30.h"
 #include "m30-rela.h"
+#include "swar.h"
+#include "prfmt.h"
 
 static const uint64_t __attribute__((unused)) ffff_m30_i_ubounds[] = {
 	/*00->*/5, /*01->*/53687,
@@ -198,12 +201,58 @@ __30_0_get_s(const char *mant, const char *f, size_t m)
 	return res;
 }
 
-m30_t
-ffff_m30_get_s(const char **nptr)
+static uint32_t
+__30_1_get_w(uint64_t iv, const char *f, size_t m)
+{
+/* like __30_1_get_s() but with the integral part IV already read */
+	const size_t k = m < 4U ? m : 4U;
+	uint32_t res = (uint32_t)iv;
+
+	res = res * (uint32_t)swar_p10[k] + (uint32_t)swar_getn(f, k);
+	res *= (uint32_t)swar_p10[4U - k];
+	if (m > 4U && f[4U] >= '5') {
+		res++;
+	}
+	return res;
+}
+
+static uint32_t
+__30_0_get_w(const char *mant, const char *f, size_t m)
+{
+/* like __30_0_get_s() but 8 digits at a time */
+	const size_t k = m < 8U ? m : 8U;
+	uint32_t res = mant[0] - '0';
+
+	res = res * (uint32_t)swar_p10[k] + (uint32_t)swar_getn(f, k);
+	res *= (uint32_t)swar_p10[8U - k];
+	if (m > 8U && f[8U] >= '5') {
+		res++;
+	}
+	return res;
+}
+
+static inline const char*
+__30_scan(const char *p, uint64_t *v, bool swarp)
 {
+/* find the end of the digits at P, if SWARP also their value */
+	const char *const q = p;
+
+	/* branches predict better than any mask trickery here */
+	for (; *p >= '0' && *p <= '9'; p++);
+	if (swarp) {
+		*v = swar_getn(q, p - q);
+	}
+	return p;
+}
+
+static inline __attribute__((always_inline)) m30_t
+__m30_get_s(const char **nptr, bool swarp)
+{
+/* the parser proper, SWARP selects the word-wise digit kernels */
 	/* spray some pointers */
 	const char *mant, *mend, *frac;
 	const char *p;
+	uint64_t iv = 0U;
 	bool neg = false;
 	m30_t r30;
 
@@ -229,7 +278,7 @@ ffff_m30_get_s(const char **nptr)
 	}
 
 	/* find the decimal point */
-	for (p = mant; *p >= '0' && *p <= '9'; p++);
+	p = __30_scan(mant, &iv, swarp);
 	if (*p == '.') {
 		frac = (mend = p) + 1;
 		for (++p; *p >= '0' && *p <= '9'; p++);
@@ -245,16 +294,24 @@ ffff_m30_get_s(const char **nptr)
 	 * so frac - mant is the number of integral digits */
 	if ((p - frac) >= 4 && (mend - mant) <= 1 && (mant[0] < '5')) {
 		r30.expo = 0;
-		r30.mant = __30_0_get_s(mant, frac, p - frac);
+		r30.mant = swarp
+			? __30_0_get_w(mant, frac, p - frac)
+			: __30_0_get_s(mant, frac, p - frac);
 	} else if ((mend - mant) < 5 || (mend - mant) == 5 && mant[0] < '5') {
 		r30.expo = 1;
-		r30.mant = __30_1_get_s(mant, mend - mant, frac, p - frac);
+		r30.mant = swarp
+			? __30_1_get_w(iv, frac, p - frac)
+			: __30_1_get_s(mant, mend - mant, frac, p - frac);
 	} else if (UNLIKELY((mend - mant) >= 8)) {
 		r30.expo = 3;
-		r30.mant = __30_23_get_s(mant, mend - mant - 4);
+		r30.mant = swarp
+			? (uint32_t)swar_getn(mant, mend - mant - 4)
+			: __30_23_get_s(mant, mend - mant - 4);
 	} else {
 		r30.expo = 2;
-		r30.mant = __30_23_get_s(mant, mend - mant);
+		r30.mant = swarp
+			? (uint32_t)iv
+			: __30_23_get_s(mant, mend - mant);
 	}
 
 	if (UNLIKELY(neg)) {
@@ -263,11 +320,12 @@ ffff_m30_get_s(const char **nptr)
 	return r30;
 }
 
-m30_t
-ffff_m30_23_get_s(const char **nptr)
+static inline __attribute__((always_inline)) m30_t
+__m30_23_get_s(const char **nptr, bool swarp)
 {
 	/* spray some pointers */
 	const char *mant, *mend;
+	uint64_t iv = 0U;
 	bool neg = false;
 	m30_t r30;
 
@@ -283,7 +341,7 @@ ffff_m30_23_get_s(const char **nptr)
 	}
 
 	/* find the end of the number */
-	for (mend = mant; *mend >= '0' && *mend <= '9'; mend++);
+	mend = __30_scan(mant, &iv, swarp);
 	*nptr = mend;
 
 	/* do some estimates, the situation is
@@ -292,7 +350,9 @@ ffff_m30_23_get_s(const char **nptr)
 	 *   mant mend
 	 *   so mend - mant is the number of integral digits */
 	r30.expo = 2;
-	r30.mant = __30_23_get_s(mant, mend - mant);
+	r30.mant = swarp
+		? (uint32_t)iv
+		: __30_23_get_s(mant, mend - mant);
 
 	if (UNLIKELY(neg)) {
 		r30.mant = -r30.mant;
@@ -300,6 +360,30 @@ ffff_m30_23_get_s(const char **nptr)
 	return r30;
 }
 
+m30_t
+ffff_m30_get_s(const char **nptr)
+{
+	return __m30_get_s(nptr, true);
+}
+
+m30_t
+ffff_m30_23_get_s(const char **nptr)
+{
+	return __m30_23_get_s(nptr, true);
+}
+
+m30_t
+__ffff_m30_get_s_sc(const char **nptr)
+{
+	return __m30_get_s(nptr, false);
+}
+
+m30_t
+__ffff_m30_23_get_s_sc(const char **nptr)
+{
+	return __m30_23_get_s(nptr, false);
+}
+
 
 /* number serialising */
 /**
@@ -311,65 +395,46 @@ __m30_nfrac_digits(m30_t m)
 	return (int8_t)(8 - 4 * m.expo);
 }
 
-#if !defined STRREV
-# define STRREV
-static void
-strrev(char *restrict tgt, char *restrict src)
-{
-	char tmp;
-	while (src > tgt) {
-		tmp = *src, *src-- = *tgt, *tgt++ = tmp;
-	}
-	return;
-}
-#endif	/* !STRREV */
-
 size_t
 ffff_m30_s(char *restrict buf, m30_t m)
 {
-	char *tmp = buf;
-	bool sign;
-	register int8_t nfrac;
+	/* digits go backwards into TMP, then to BUF in one go */
+	char tmp[24U];
+	char *const ep = tmp + sizeof(tmp);
+	char *p = ep;
+	uint64_t u;
+	int8_t nfrac;
+	size_t n;
 
 	/* special values first */
 	if (UNLIKELY(m.u == FFFF_M30_MKT)) {
-		*tmp++ = 'm';
-		*tmp++ = 'k';
-		*tmp++ = 't';
-		*tmp = '\0';
+		memcpy(buf, "mkt", 4U);
 		return 3;
+	} else if (m.mant == 0) {
+		/* mant = 0 means all is 0 */
+		buf[0U] = '0';
+		buf[1U] = '\0';
+		return 1;
 	}
 
 	/* otherwise */
 	nfrac = __m30_nfrac_digits(m);
-	if ((sign = (m.mant < 0))) {
-		m.mant = -m.mant;
-	}
-	if (m.mant == 0) {
-		/* mant = 0 means all is 0 */
-		*tmp++ = '0';
-		*tmp = '\0';
-		return 1;
-	}
+	u = m.mant < 0 ? -(int64_t)m.mant : m.mant;
 	if (nfrac > 0) {
-		for (register int8_t i = 0; i < nfrac; i++) {
-			*tmp++ = (char)('0' + m.mant % 10), m.mant /= 10;
-		}
-		*tmp++ = '.';
+		p = prfmt_frac_rev(p, &u, nfrac);
+		*--p = '.';
 	} else {
-		for (register int8_t i = nfrac; i < 0; i++) {
-			*tmp++ = '0';
+		for (int8_t i = nfrac; i < 0; i++) {
+			*--p = '0';
 		}
 	}
-	do {
-		*tmp++ = (char)('0' + m.mant % 10);
-	} while (m.mant /= 10);
-	if (sign) {
-		*tmp++ = '-';
+	p = prfmt_udec_rev(p, u);
+	if (m.mant < 0) {
+		*--p = '-';
 	}
-	*tmp = '\0';
-	strrev(buf, tmp - 1);
-	return (size_t)(tmp - buf);
+	memcpy(buf, p, n = ep - p);
+	buf[n] = '\0';
+	return n;
 }
 
 /* m30.c ends here */
@@ -126,6 +126,13 @@ extern m30_t ffff_m30_get_s(const char **s);
  * Like ffff_m30_get_s() but for numbers with expo 2 or 3. */
 extern m30_t ffff_m30_23_get_s(const char **s);
 
+#if defined DEFINE_GORY_STUFF
+/**
+ * Digit-by-digit versions of the above, for cross-checking only. */
+extern m30_t __ffff_m30_get_s_sc(const char **s);
+extern m30_t __ffff_m30_23_get_s_sc(const char **s);
+#endif	/* DEFINE_GORY_STUFF */
+
 /**
  * Write m30_t object M into buffer BUF. */
 extern size_t ffff_m30_s(char *restrict buf, m30_t m);
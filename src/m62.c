@@ -37,8 +37,11 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#define DEFINE_GORY_STUFF
 #include "m62.h"
 #include "m62-rela.h"
+#include "swar.h"
+#include "prfmt.h"
 
 static const uint64_t __attribute__((unused)) ffff_m62_i_ubounds_l10[] = {
 	/*00->*/11, /*01->*/15, /*10->*/19, /*11->*/23,
@@ -179,12 +182,58 @@ __62_0_get_s(const char *mant, size_t n, const char *f, size_t m)
 	return res;
 }
 
-m62_t
-ffff_m62_get_s(const char **nptr)
+static uint64_t
+__62_1_get_w(uint64_t iv, const char *f, size_t m)
+{
+/* like __62_1_get_s() but with the integral part IV already read */
+	const size_t k = m < 4U ? m : 4U;
+	uint64_t res = iv;
+
+	res = res * swar_p10[k] + swar_getn(f, k);
+	res *= swar_p10[4U - k];
+	if (m > 4U && f[4U] >= '5') {
+		res++;
+	}
+	return res;
+}
+
+static uint64_t
+__62_0_get_w(uint64_t iv, const char *f, size_t m)
+{
+/* like __62_0_get_s() but with the integral part IV already read */
+	const size_t k = m < 8U ? m : 8U;
+	uint64_t res = iv;
+
+	res = res * swar_p10[k] + swar_getn(f, k);
+	res *= swar_p10[8U - k];
+	if (m > 8U && f[8U] >= '5') {
+		res++;
+	}
+	return res;
+}
+
+static inline const char*
+__62_scan(const char *p, uint64_t *v, bool swarp)
+{
+/* find the end of the digits at P, if SWARP also their value */
+	const char *const q = p;
+
+	/* branches predict better than any mask trickery here */
+	for (; *p >= '0' && *p <= '9'; p++);
+	if (swarp) {
+		*v = swar_getn(q, p - q);
+	}
+	return p;
+}
+
+static inline __attribute__((always_inline)) m62_t
+__m62_get_s(const char **nptr, bool swarp)
 {
+/* the parser proper, SWARP selects the word-wise digit kernels */
 	/* spray some pointers */
 	const char *mant, *mend, *frac;
 	const char *p;
+	uint64_t iv = 0U;
 	bool neg = false;
 	m62_t r62;
 
@@ -202,7 +251,7 @@ ffff_m62_get_s(const char **nptr)
 	}
 
 	/* find the decimal point */
-	for (p = mant; *p >= '0' && *p <= '9'; p++);
+	p = __62_scan(mant, &iv, swarp);
 	if (*p == '.') {
 		frac = (mend = p) + 1;
 		for (++p; *p >= '0' && *p <= '9'; p++);
@@ -220,23 +269,43 @@ ffff_m62_get_s(const char **nptr)
 	    (uint64_t)(mend - mant) <= ffff_m62_i_ubounds_l10[0]) {
 		M62_SET_EXPO(r62, 0);
 		M62_SET_MANT(
-			r62, __62_0_get_s(mant, (mend - mant), frac, p - frac));
+			r62, swarp
+			? __62_0_get_w(iv, frac, p - frac)
+			: __62_0_get_s(mant, (mend - mant), frac, p - frac));
 	} else if ((p - frac) > 0 ||
 		   (uint64_t)(mend - mant) <= ffff_m62_i_ubounds_l10[1]) {
 		M62_SET_EXPO(r62, 1);
 		M62_SET_MANT(
-			r62, __62_1_get_s(mant, mend - mant, frac, p - frac));
+			r62, swarp
+			? __62_1_get_w(iv, frac, p - frac)
+			: __62_1_get_s(mant, mend - mant, frac, p - frac));
 	} else if ((uint64_t)(mend - mant) >= ffff_m62_i_ubounds_l10[2]) {
 		M62_SET_EXPO(r62, 3);
-		M62_SET_MANT(r62, __62_23_get_s(mant, mend - mant - 4));
+		M62_SET_MANT(r62, swarp
+			     ? swar_getn(mant, mend - mant - 4)
+			     : __62_23_get_s(mant, mend - mant - 4));
 	} else {
 		M62_SET_EXPO(r62, 2);
-		M62_SET_MANT(r62, __62_23_get_s(mant, mend - mant));
+		M62_SET_MANT(r62, swarp
+			     ? iv
+			     : __62_23_get_s(mant, mend - mant));
 	}
 	M62_SET_MANT(r62, !neg ? M62_MANT(r62) : -M62_MANT(r62));
 	return r62;
 }
 
+m62_t
+ffff_m62_get_s(const char **nptr)
+{
+	return __m62_get_s(nptr, true);
+}
+
+m62_t
+__ffff_m62_get_s_sc(const char **nptr)
+{
+	return __m62_get_s(nptr, false);
+}
+
 
 /**
  * Return the number of fractional digits, i.e. the ones right of point. */
@@ -247,49 +316,33 @@ __m62_nfrac_digits(m62_t m)
 	return (int8_t)(8 - 4 * M62_EXPO(m));
 }
 
-#if !defined STRREV
-# define STRREV
-static void
-strrev(char *restrict tgt, char *restrict src)
-{
-	char tmp;
-	while (src > tgt) {
-		tmp = *src, *src-- = *tgt, *tgt++ = tmp;
-	}
-	return;
-}
-#endif	/* !STRREV */
-
 size_t
 ffff_m62_s(char *restrict buf, m62_t m)
 {
-	char *tmp = buf;
-	bool sign;
+	/* digits go backwards into TMP, then to BUF in one go */
+	char tmp[32U];
+	char *const ep = tmp + sizeof(tmp);
+	char *p = ep;
+	const int64_t mant = M62_MANT(m);
 	int8_t nfrac = __m62_nfrac_digits(m);
+	uint64_t u = mant < 0 ? -(uint64_t)mant : (uint64_t)mant;
+	size_t n;
 
-	if ((sign = (M62_MANT(m) < 0))) {
-		M62_SET_MANT(m, -M62_MANT(m));
-	}
 	if (nfrac > 0) {
-		for (register int8_t i = 0; i < nfrac; i++) {
-			*tmp++ = (char)('0' + M62_MANT(m) % 10);
-			M62_MANT_DIVSET_10(m);
-		}
-		*tmp++ = '.';
+		p = prfmt_frac_rev(p, &u, nfrac);
+		*--p = '.';
 	} else {
-		for (register int8_t i = nfrac; i < 0; i++) {
-			*tmp++ = '0';
+		for (int8_t i = nfrac; i < 0; i++) {
+			*--p = '0';
 		}
 	}
-	do {
-		*tmp++ = (char)('0' + M62_MANT(m) % 10);
-	} while (M62_MANT_DIVSET_10(m));
-	if (sign) {
-		*tmp++ = '-';
+	p = prfmt_udec_rev(p, u);
+	if (mant < 0) {
+		*--p = '-';
 	}
-	*tmp = '\0';
-	strrev(buf, tmp - 1);
-	return (size_t)(tmp - buf);
+	memcpy(buf, p, n = ep - p);
+	buf[n] = '\0';
+	return n;
 }
 
 
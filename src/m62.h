@@ -172,6 +172,12 @@ ffff_m62_get_d(double d);
  * Read number at string *S as m62_t and update *S to the end of the number. */
 extern m62_t ffff_m62_get_s(const char **s);
 
+#if defined DEFINE_GORY_STUFF
+/**
+ * Digit-by-digit version of the above, for cross-checking only. */
+extern m62_t __ffff_m62_get_s_sc(const char **s);
+#endif	/* DEFINE_GORY_STUFF */
+
 /**
  * Like `strtol()'. */
 extern long int ffff_strtol(const char *p, const char **endp, int b);
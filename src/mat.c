@@ -413,9 +413,10 @@ init(pr_ctx_t pctx)
 
 	/* start out with an array */
 	frag_hdr = get_mat_arr_hdr(__gmctx);
-	/* get ourselves 256 rows */
+	/* get ourselves a row per tick, there's at most that many,
+	 * or 256 rows if we don't know and grow from there */
 	{
-		const size_t ini_nr = 256U;
+		const size_t ini_nr = pctx->nticks ?: 256U;
 		const size_t ini_nc = STATIC_VALS + vals_per_idx * nidxs;
 		frag_dat = get_mat_arr_dat(__gmctx, frag_hdr, ini_nr, ini_nc);
 	}
@@ -426,11 +427,8 @@ void
 fini(pr_ctx_t UNUSED(pctx))
 {
 	size_t nc = frag_hdr->dim.cols;
-	size_t nr = frag_hdr->dim.rows;
 
-	/* reshape to smaller size */
-	reshape((void*)frag_dat->data, nc, nr, nrows);
-	/* update matarr */
+	/* update matarr, this reshapes to the smaller size */
 	put_mat_arr_dat(__gmctx, frag_hdr, frag_dat, nrows, nc);
 	put_mat_arr_hdr(__gmctx, frag_hdr);
 
@@ -460,12 +458,12 @@ bang5idx(
 }
 
 int
-pr(pr_ctx_t UNUSED(pctx), scom_t st)
+pr(pr_ctx_t pctx, scom_t st)
 {
 	uint32_t sec = scom_thdr_sec(st);
 	uint16_t msec = scom_thdr_msec(st);
 	uint16_t ttf = scom_thdr_ttf(st);
-	unsigned int idx = scom_thdr_tblidx(st);
+	unsigned int idx = pr_tblidx(pctx, st);
 	/* for the time stamp check */
 	static uint32_t ol_sec = 0U;
 	static uint16_t ol_msec = 0U;
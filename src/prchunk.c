@@ -35,6 +35,9 @@
  *
  ***/
 
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
 #define PRCHUNK_C
 #include <stddef.h>
 #include <stdlib.h>
@@ -43,17 +46,52 @@
 #include <fcntl.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
 #if defined HAVE_SYS_TYPES_H
 /* for ssize_t */
 # include <sys/types.h>
 #endif	/* HAVE_SYS_TYPES_H */
 #include <sys/mman.h>
+#include <errno.h>
+#if defined HAVE_PTHREAD_H
+# include <pthread.h>
+#endif	/* HAVE_PTHREAD_H */
+#if defined HAVE_ZLIB_H
+# include <zlib.h>
+#endif	/* HAVE_ZLIB_H */
+#if defined HAVE_LZMA_H
+# include <lzma.h>
+#endif	/* HAVE_LZMA_H */
+#if defined HAVE_ZSTD_H
+# include <zstd.h>
+#endif	/* HAVE_ZSTD_H */
 #include "nifty.h"
 #include "mem.h"
 #include "prchunk.h"
 
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+# define HAVE_SIMD_STIDX
+# include <immintrin.h>
+#endif	/* __GNUC__ && x86 */
+
 #define MAX_NLINES	(16384)
 #define MAX_LLEN	(1024)
+#define MAP_LEN		(MAX_NLINES * MAX_LLEN)
+/* read size, much larger than a chunk's worth of lines is pointless */
+#define CHUNK_SIZE	(1024U * 1024U)
+/* number of bytes the structural indexer looks at in one go */
+#define STIDX_BLK	(65536U)
+
+#if defined HAVE_PTHREAD_H && \
+	(defined HAVE_ZLIB_H || defined HAVE_LZMA_H || defined HAVE_ZSTD_H)
+# define HAVE_PRZIP
+#endif	/* HAVE_PTHREAD_H && (zlib || lzma || zstd) */
+/* enough leading bytes to tell compressed input by */
+#define PRZIP_MAGIC_LEN	(6U)
+/* number of decoded blocks (of CHUNK_SIZE bytes) in flight */
+#define NZBLK		(4U)
+/* read size for compressed input */
+#define ZIN_SIZE	(65536U)
 
 #if defined __INTEL_COMPILER
 # pragma warning(disable: 981)
@@ -65,7 +103,11 @@ typedef uint16_t off16_t;
 struct prch_ctx_s {
 	/* file descriptor */
 	int fd;
-	/* buffer */
+	/* storage */
+	char *mem;
+	/* usable size of MEM in bytes */
+	size_t mz;
+	/* beginning of the current chunk, somewhere in MEM */
 	char *buf;
 	/* number of lines in the buffer */
 	uint32_t lno;
@@ -80,6 +122,19 @@ struct prch_ctx_s {
 	off32_t lno_cur;
 	/* delimiter offsets */
 	off16_t *soff;
+
+	/* field delimiter to index along with the line ends, or 0 */
+	char dlm;
+	/* structural index of the block at hand */
+	uint32_t *sidx;
+	/* field delimiter offsets, relative to the beginning of their line */
+	uint32_t *fo;
+	size_t foz;
+	/* index into FO of the first delimiter of each line */
+	uint32_t lfo[MAX_NLINES + 1U];
+
+	/* decoder of compressed input, or NULL */
+	struct przip_s *z;
 };
 
 static struct prch_ctx_s __ctx[1] = {{0}};
@@ -125,6 +180,587 @@ get_llen(prch_ctx_t ctx, uint32_t lno)
 }
 
 
+/* structural indexers, they store the offsets of all line ends and
+ * delimiters DLM in [S, S + N) into IDX and return how many there were */
+static size_t
+stidx_sw(uint32_t *restrict idx, const char *s, size_t n, char dlm)
+{
+	size_t k = 0U;
+
+	for (size_t i = 0U; i < n; i++) {
+		idx[k] = i;
+		k += s[i] == '\n' || s[i] == dlm;
+	}
+	return k;
+}
+
+#if defined HAVE_SIMD_STIDX
+static __attribute__((target("sse2"))) size_t
+stidx_sse2(uint32_t *restrict idx, const char *s, size_t n, char dlm)
+{
+	const __m128i nl = _mm_set1_epi8('\n');
+	const __m128i dl = _mm_set1_epi8(dlm);
+	size_t k = 0U;
+	size_t i;
+
+	for (i = 0U; i + 16U <= n; i += 16U) {
+		__m128i x = _mm_loadu_si128((const void*)(s + i));
+		unsigned int m = _mm_movemask_epi8(
+			_mm_or_si128(_mm_cmpeq_epi8(x, nl),
+				     _mm_cmpeq_epi8(x, dl)));
+
+		for (; m; m &= m - 1U) {
+			idx[k++] = i + __builtin_ctz(m);
+		}
+	}
+	for (size_t j = stidx_sw(idx + k, s + i, n - i, dlm); j--;) {
+		idx[k++] += i;
+	}
+	return k;
+}
+
+static __attribute__((target("avx2"))) size_t
+stidx_avx2(uint32_t *restrict idx, const char *s, size_t n, char dlm)
+{
+	const __m256i nl = _mm256_set1_epi8('\n');
+	const __m256i dl = _mm256_set1_epi8(dlm);
+	size_t k = 0U;
+	size_t i;
+
+	for (i = 0U; i + 32U <= n; i += 32U) {
+		__m256i x = _mm256_loadu_si256((const void*)(s + i));
+		unsigned int m = _mm256_movemask_epi8(
+			_mm256_or_si256(_mm256_cmpeq_epi8(x, nl),
+					_mm256_cmpeq_epi8(x, dl)));
+
+		for (; m; m &= m - 1U) {
+			idx[k++] = i + __builtin_ctz(m);
+		}
+	}
+	for (size_t j = stidx_sw(idx + k, s + i, n - i, dlm); j--;) {
+		idx[k++] += i;
+	}
+	return k;
+}
+#endif	/* HAVE_SIMD_STIDX */
+
+static size_t
+stidx(uint32_t *restrict idx, const char *s, size_t n, char dlm)
+{
+#if defined HAVE_SIMD_STIDX
+	static size_t(*f)(uint32_t *restrict, const char*, size_t, char);
+
+	if (UNLIKELY(f == NULL)) {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			f = stidx_avx2;
+		} else if (__builtin_cpu_supports("sse2")) {
+			f = stidx_sse2;
+		} else {
+			f = stidx_sw;
+		}
+	}
+	return f(idx, s, n, dlm);
+#else  /* !HAVE_SIMD_STIDX */
+	return stidx_sw(idx, s, n, dlm);
+#endif	/* HAVE_SIMD_STIDX */
+}
+
+static int
+push_fo(prch_ctx_t ctx, size_t nfo, uint32_t fo)
+{
+	if (UNLIKELY(nfo >= ctx->foz)) {
+		size_t nu = ctx->foz ? 2U * ctx->foz : 4U * MAX_NLINES;
+		uint32_t *tmp;
+
+		if ((tmp = realloc(ctx->fo, nu * sizeof(*tmp))) == NULL) {
+			return -1;
+		}
+		ctx->fo = tmp;
+		ctx->foz = nu;
+	}
+	ctx->fo[nfo] = fo;
+	return 0;
+}
+
+static void
+end_line(prch_ctx_t ctx, char *p, const char *bol, size_t nfo)
+{
+	set_loff(ctx, ctx->lno, p - ctx->buf);
+	if (UNLIKELY(p > bol && p[-1] == '\r')) {
+		/* oh god, when is this nightmare gonna end */
+		p[-1] = PRCHUNK_EOL;
+		set_lftermd(ctx, ctx->lno);
+	}
+	*p = PRCHUNK_EOL;
+	ctx->lfo[++ctx->lno] = nfo;
+	return;
+}
+
+static char*
+index_lines(prch_ctx_t ctx, char *off, char *bno, bool eofp)
+{
+/* find the line ends and delimiters in [OFF, BNO) in one pass,
+ * return the beginning of the first line that hasn't been dealt with */
+	size_t nfo = ctx->lfo[ctx->lno];
+
+	for (char *scn = off; scn < bno;) {
+		size_t n = bno - scn < STIDX_BLK ? bno - scn : STIDX_BLK;
+		size_t ni = stidx(ctx->sidx, scn, n, ctx->dlm);
+
+		for (size_t i = 0U; i < ni; i++) {
+			char *p = scn + ctx->sidx[i];
+
+			if (*p != '\n') {
+				if (UNLIKELY(push_fo(ctx, nfo, p - off) < 0)) {
+					return NULL;
+				}
+				nfo++;
+				continue;
+			}
+			end_line(ctx, p, off, nfo);
+			off = p + 1;
+			if (UNLIKELY(ctx->lno >= MAX_NLINES)) {
+				return off;
+			}
+		}
+		scn += n;
+	}
+	if (UNLIKELY(eofp && off < bno)) {
+		/* fucking idiots didnt conclude with a \n */
+		fputs("ID:10T error\n", stderr);
+		end_line(ctx, bno, off, nfo);
+		off = bno + 1;
+	}
+	return off;
+}
+
+/* compressed input, decoded on a separate thread into a ring of NZBLK
+ * blocks which prchunk_fill() then reads from instead of the descriptor */
+typedef enum {
+	PRZIP_NONE,
+	PRZIP_GZ,
+	PRZIP_XZ,
+	PRZIP_ZST,
+} przip_fmt_t;
+
+static przip_fmt_t
+przip_fmt(const char *buf, size_t bsz)
+{
+	static const unsigned char gz[] = {0x1fU, 0x8bU};
+	static const unsigned char xz[] = {0xfdU, '7', 'z', 'X', 'Z', 0x00U};
+	static const unsigned char zst[] = {0x28U, 0xb5U, 0x2fU, 0xfdU};
+
+	if (bsz >= sizeof(gz) && !memcmp(buf, gz, sizeof(gz))) {
+		return PRZIP_GZ;
+	} else if (bsz >= sizeof(xz) && !memcmp(buf, xz, sizeof(xz))) {
+		return PRZIP_XZ;
+	} else if (bsz >= sizeof(zst) && !memcmp(buf, zst, sizeof(zst))) {
+		return PRZIP_ZST;
+	}
+	return PRZIP_NONE;
+}
+
+#if defined HAVE_PRZIP
+struct przip_s {
+	/* compressed input and its format */
+	int fd;
+	przip_fmt_t fmt;
+	/* set when FD is exhausted and when the codec says so */
+	bool ieofp;
+	bool endp;
+	union {
+#if defined HAVE_ZLIB_H
+		z_stream gz;
+#endif	/* HAVE_ZLIB_H */
+#if defined HAVE_LZMA_H
+		lzma_stream xz;
+#endif	/* HAVE_LZMA_H */
+#if defined HAVE_ZSTD_H
+		struct {
+			ZSTD_DCtx *zst;
+			ZSTD_inBuffer zin;
+		};
+#endif	/* HAVE_ZSTD_H */
+	};
+
+	pthread_t thr;
+	bool thrp;
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+	/* decoded blocks, written at W, read at R (at offset ROFF) */
+	char *blk[NZBLK];
+	size_t blen[NZBLK];
+	unsigned int r, w, nfull;
+	size_t roff;
+	/* decoder's done, decoder failed, reader's gone */
+	bool eofp;
+	bool errp;
+	bool quitp;
+
+	char ibuf[ZIN_SIZE];
+};
+
+static ssize_t
+zfill(struct przip_s *z)
+{
+/* refill Z's input buffer */
+	ssize_t nrd;
+
+	while ((nrd = read(z->fd, z->ibuf, sizeof(z->ibuf))) < 0 &&
+	       errno == EINTR);
+	if (nrd == 0) {
+		z->ieofp = true;
+	}
+	return nrd;
+}
+
+#if defined HAVE_ZLIB_H
+static ssize_t
+zdec_gz(struct przip_s *z, char *tgt, size_t tsz)
+{
+	z_stream *s = &z->gz;
+
+	s->next_out = (void*)tgt;
+	s->avail_out = tsz;
+	while (s->avail_out > 0U) {
+		if (s->avail_in == 0U && !z->ieofp) {
+			ssize_t nrd;
+
+			if ((nrd = zfill(z)) < 0) {
+				return -1;
+			}
+			s->next_in = (void*)z->ibuf;
+			s->avail_in = nrd;
+		}
+		if (s->avail_in == 0U) {
+			/* truncated unless we're between members */
+			if (!z->endp) {
+				return -1;
+			}
+			break;
+		}
+		switch (inflate(s, Z_NO_FLUSH)) {
+		case Z_STREAM_END:
+			/* there might be more members */
+			inflateReset(s);
+			z->endp = true;
+			continue;
+		case Z_OK:
+			z->endp = false;
+			continue;
+		case Z_DATA_ERROR:
+			if (!z->endp) {
+				return -1;
+			}
+			/* trailing garbage, ignored just like gzip(1) */
+			s->avail_in = 0U;
+			z->ieofp = true;
+			break;
+		default:
+			return -1;
+		}
+		break;
+	}
+	return tsz - s->avail_out;
+}
+#endif	/* HAVE_ZLIB_H */
+
+#if defined HAVE_LZMA_H
+static ssize_t
+zdec_xz(struct przip_s *z, char *tgt, size_t tsz)
+{
+	lzma_stream *s = &z->xz;
+
+	if (z->endp) {
+		return 0;
+	}
+	s->next_out = (void*)tgt;
+	s->avail_out = tsz;
+	while (s->avail_out > 0U) {
+		if (s->avail_in == 0U && !z->ieofp) {
+			ssize_t nrd;
+
+			if ((nrd = zfill(z)) < 0) {
+				return -1;
+			}
+			s->next_in = (const void*)z->ibuf;
+			s->avail_in = nrd;
+		}
+		switch (lzma_code(s, z->ieofp ? LZMA_FINISH : LZMA_RUN)) {
+		case LZMA_OK:
+			continue;
+		case LZMA_STREAM_END:
+			z->endp = true;
+			break;
+		default:
+			return -1;
+		}
+		break;
+	}
+	return tsz - s->avail_out;
+}
+#endif	/* HAVE_LZMA_H */
+
+#if defined HAVE_ZSTD_H
+static ssize_t
+zdec_zst(struct przip_s *z, char *tgt, size_t tsz)
+{
+	ZSTD_outBuffer out = {tgt, tsz, 0U};
+
+	while (out.pos < out.size) {
+		const size_t opos = out.pos;
+		size_t rc;
+
+		if (z->zin.pos >= z->zin.size && !z->ieofp) {
+			ssize_t nrd;
+
+			if ((nrd = zfill(z)) < 0) {
+				return -1;
+			}
+			z->zin = (ZSTD_inBuffer){z->ibuf, nrd, 0U};
+		}
+		rc = ZSTD_decompressStream(z->zst, &out, &z->zin);
+		if (ZSTD_isError(rc)) {
+			return -1;
+		} else if (z->ieofp && out.pos == opos) {
+			/* no more input, no more output, frame better be done */
+			if (rc) {
+				return -1;
+			}
+			break;
+		}
+	}
+	return out.pos;
+}
+#endif	/* HAVE_ZSTD_H */
+
+static ssize_t
+zdec(struct przip_s *z, char *tgt, size_t tsz)
+{
+/* decode at most TSZ bytes into TGT, return 0 at the end, -1 on error */
+	switch (z->fmt) {
+#if defined HAVE_ZLIB_H
+	case PRZIP_GZ:
+		return zdec_gz(z, tgt, tsz);
+#endif	/* HAVE_ZLIB_H */
+#if defined HAVE_LZMA_H
+	case PRZIP_XZ:
+		return zdec_xz(z, tgt, tsz);
+#endif	/* HAVE_LZMA_H */
+#if defined HAVE_ZSTD_H
+	case PRZIP_ZST:
+		return zdec_zst(z, tgt, tsz);
+#endif	/* HAVE_ZSTD_H */
+	default:
+		break;
+	}
+	return -1;
+}
+
+static void*
+zthr(void *clo)
+{
+/* the decoder, fills free blocks until there's no more input */
+	struct przip_s *z = clo;
+	ssize_t n;
+
+	do {
+		unsigned int w;
+		bool quitp;
+
+		pthread_mutex_lock(&z->mtx);
+		while (z->nfull >= NZBLK && !z->quitp) {
+			pthread_cond_wait(&z->cnd, &z->mtx);
+		}
+		w = z->w;
+		quitp = z->quitp;
+		pthread_mutex_unlock(&z->mtx);
+		if (UNLIKELY(quitp)) {
+			break;
+		}
+
+		/* the block at W is ours until we hand it out */
+		n = zdec(z, z->blk[w], CHUNK_SIZE);
+
+		pthread_mutex_lock(&z->mtx);
+		if (n > 0) {
+			z->blen[w] = n;
+			z->w = (w + 1U) % NZBLK;
+			z->nfull++;
+		} else {
+			z->eofp = true;
+			z->errp = n < 0;
+		}
+		pthread_cond_signal(&z->cnd);
+		pthread_mutex_unlock(&z->mtx);
+	} while (n > 0);
+	return NULL;
+}
+
+static ssize_t
+zread(struct przip_s *z, char *buf, size_t bsz)
+{
+/* like read(2) but off the decoded blocks */
+	size_t res = 0U;
+
+	pthread_mutex_lock(&z->mtx);
+	while (res < bsz) {
+		size_t n;
+
+		while (!z->nfull && !z->eofp) {
+			pthread_cond_wait(&z->cnd, &z->mtx);
+		}
+		if (!z->nfull) {
+			break;
+		}
+		/* don't hold the lock while copying, the decoder won't
+		 * touch blocks it has handed out */
+		pthread_mutex_unlock(&z->mtx);
+		n = z->blen[z->r] - z->roff;
+		if (n > bsz - res) {
+			n = bsz - res;
+		}
+		memcpy(buf + res, z->blk[z->r] + z->roff, n);
+		res += n;
+		z->roff += n;
+		pthread_mutex_lock(&z->mtx);
+		if (z->roff >= z->blen[z->r]) {
+			/* block's done, give it back */
+			z->r = (z->r + 1U) % NZBLK;
+			z->roff = 0U;
+			z->nfull--;
+			pthread_cond_signal(&z->cnd);
+		}
+	}
+	if (!res && z->errp) {
+		fputs("prchunk: cannot decode compressed input\n", stderr);
+		z->errp = false;
+		res = -1;
+	}
+	pthread_mutex_unlock(&z->mtx);
+	return res;
+}
+
+static void
+free_przip(struct przip_s *z)
+{
+	if (z->thrp) {
+		pthread_mutex_lock(&z->mtx);
+		z->quitp = true;
+		pthread_cond_signal(&z->cnd);
+		pthread_mutex_unlock(&z->mtx);
+		pthread_join(z->thr, NULL);
+	}
+	switch (z->fmt) {
+#if defined HAVE_ZLIB_H
+	case PRZIP_GZ:
+		inflateEnd(&z->gz);
+		break;
+#endif	/* HAVE_ZLIB_H */
+#if defined HAVE_LZMA_H
+	case PRZIP_XZ:
+		lzma_end(&z->xz);
+		break;
+#endif	/* HAVE_LZMA_H */
+#if defined HAVE_ZSTD_H
+	case PRZIP_ZST:
+		ZSTD_freeDCtx(z->zst);
+		break;
+#endif	/* HAVE_ZSTD_H */
+	default:
+		break;
+	}
+	pthread_cond_destroy(&z->cnd);
+	pthread_mutex_destroy(&z->mtx);
+	if (z->blk[0U] != NULL) {
+		munmap(z->blk[0U], NZBLK * CHUNK_SIZE);
+	}
+	free(z);
+	return;
+}
+
+static struct przip_s*
+make_przip(int fd, przip_fmt_t fmt, const char *pre, size_t npre)
+{
+/* set up a decoder for FD, whose first NPRE bytes have been read into PRE
+ * already, and start it */
+	struct przip_s *z;
+	char *blk;
+	bool okp = false;
+
+	if ((z = calloc(1, sizeof(*z))) == NULL) {
+		return NULL;
+	}
+	z->fd = fd;
+	z->fmt = fmt;
+	pthread_mutex_init(&z->mtx, NULL);
+	pthread_cond_init(&z->cnd, NULL);
+	blk = mmap(NULL, NZBLK * CHUNK_SIZE, PROT_MEM, MAP_MEM, -1, 0);
+	if (blk == MAP_FAILED) {
+		goto nope;
+	}
+	for (size_t i = 0U; i < NZBLK; i++) {
+		z->blk[i] = blk + i * CHUNK_SIZE;
+	}
+	/* the codec starts out with what's been read already */
+	memcpy(z->ibuf, pre, npre);
+	switch (fmt) {
+#if defined HAVE_ZLIB_H
+	case PRZIP_GZ:
+		/* 32 on top of the window bits for gzip headers */
+		if ((okp = inflateInit2(&z->gz, 15 + 32) == Z_OK)) {
+			z->gz.next_in = (void*)z->ibuf;
+			z->gz.avail_in = npre;
+		}
+		break;
+#endif	/* HAVE_ZLIB_H */
+#if defined HAVE_LZMA_H
+	case PRZIP_XZ:
+		z->xz = (lzma_stream)LZMA_STREAM_INIT;
+		if ((okp = lzma_stream_decoder(
+			     &z->xz, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK)) {
+			z->xz.next_in = (const void*)z->ibuf;
+			z->xz.avail_in = npre;
+		}
+		break;
+#endif	/* HAVE_LZMA_H */
+#if defined HAVE_ZSTD_H
+	case PRZIP_ZST:
+		if ((okp = (z->zst = ZSTD_createDCtx()) != NULL)) {
+			z->zin = (ZSTD_inBuffer){z->ibuf, npre, 0U};
+		}
+		break;
+#endif	/* HAVE_ZSTD_H */
+	default:
+		break;
+	}
+	if (!okp) {
+		z->fmt = PRZIP_NONE;
+		goto nope;
+	} else if (pthread_create(&z->thr, NULL, zthr, z) != 0) {
+		goto nope;
+	}
+	z->thrp = true;
+	return z;
+nope:
+	free_przip(z);
+	return NULL;
+}
+#endif	/* HAVE_PRZIP */
+
+static inline ssize_t
+rd(prch_ctx_t ctx, char *buf, size_t bsz)
+{
+#if defined HAVE_PRZIP
+	if (ctx->z != NULL) {
+		return zread(ctx->z, buf, bsz);
+	}
+#endif	/* HAVE_PRZIP */
+	return read(ctx->fd, buf, bsz);
+}
+
+
 /* internal operations */
 FDEFU int
 prchunk_fill(prch_ctx_t ctx)
@@ -132,41 +768,64 @@ prchunk_fill(prch_ctx_t ctx)
 /* this is a coroutine consisting of a line counter yielding the number of
  * lines read so far and a reader yielding a buffer fill and the number of
  * bytes read */
-#define CHUNK_SIZE	(4096)
 #define YIELD(x)	goto yield##x
 	int res = 0;
-	char *off = ctx->buf + 0;
-	char *bno = ctx->buf + ctx->bno;
+	char *off;
+	char *bno;
 	ssize_t nrd;
 
 	/* initial work, reset the line counters et al */
 	ctx->lno = 0;
-	/* we just memcpy() the left over stuff to the front and restart
-	 * from there, someone left us a note in __ctx with the left
-	 * over offset */
-	/* normally we'd use memmove() but we know there's little chance
-	 * for overlapping regions */
+	ctx->lfo[0U] = 0U;
+	/* the left over stuff becomes the beginning of the next chunk,
+	 * someone left us a note in __ctx with the left over offset */
 	if (UNLIKELY(ctx->bno == 0)) {
 		/* do nothing */
 		;
 	} else if (LIKELY(ctx->bno > ctx->off)) {
-		size_t rsz = ctx->bno - ctx->off;
-		/* move the top RSZ bytes to the beginning */
-		memcpy(ctx->buf, ctx->buf + ctx->off, rsz);
-		ctx->bno = rsz;
-		bno = ctx->buf + rsz;
+		ctx->buf += ctx->off;
+		ctx->bno -= ctx->off;
 	} else if (UNLIKELY(ctx->bno == ctx->off)) {
 		/* what are the odds? just reset the counters */
+		ctx->buf += ctx->off;
 		ctx->bno = 0;
-		bno = ctx->buf;
 	} else {
 		/* the user didn't see the end of the file */
 		return -1;
 	}
 
+	if (ctx->mem + ctx->mz - (ctx->buf + ctx->bno) < CHUNK_SIZE) {
+		/* out of room, move the leftovers to the front */
+		memmove(ctx->mem, ctx->buf, ctx->bno);
+		ctx->buf = ctx->mem;
+	}
+	off = ctx->buf;
+	bno = ctx->buf + ctx->bno;
+	if (off < bno) {
+		/* chew on the leftovers before reading more */
+		nrd = 1;
+		YIELD(2);
+	}
+
 yield1:
-	/* read CHUNK_SIZE bytes */
-	bno += (nrd = read(ctx->fd, bno, CHUNK_SIZE));
+	if (UNLIKELY(bno >= ctx->mem + ctx->mz)) {
+		/* buffer's full, hand out what we've got */
+		if (LIKELY(ctx->lno)) {
+			YIELD(3);
+		}
+		/* line too long, cut it */
+		nrd = 0;
+	} else {
+		/* read at most CHUNK_SIZE bytes */
+		size_t room = ctx->mem + ctx->mz - bno;
+
+		if (room > CHUNK_SIZE) {
+			room = CHUNK_SIZE;
+		}
+		if ((nrd = rd(ctx, bno, room)) > 0) {
+			bno += nrd;
+		}
+	}
 	/* if we came from yield2 then off == __ctx->bno, and if we
 	 * read 0 or less bytes then off >= __ctx->bno + nrd, so we
 	 * can simply use that compact expression if the buffer has no
@@ -175,16 +834,28 @@ yield1:
 	 * has been called, then off would be 0 and __ctx->bno would be
 	 * the buffer filled so far, if no more bytes could be read then
 	 * we'd proceed processing them (off < __ctx->bno + nrd */
-	if (UNLIKELY(nrd <= 0 && off == ctx->buf)) {
+	if (UNLIKELY(nrd <= 0 && off == bno)) {
 		/* special case, we worked our arses off and nothing's
 		 * in the pipe line so just fuck off here */
+		if (ctx->lno) {
+			YIELD(3);
+		}
 		return -1;
-	} else if (LIKELY(off < bno || off == ctx->buf)) {
+	} else if (LIKELY(off < bno)) {
 		YIELD(2);
 	}
 	/* proceed to exit */
 	YIELD(3);
 yield2:
+	if (ctx->dlm) {
+		/* line ends and fields in one go */
+		if (UNLIKELY((off = index_lines(ctx, off, bno, nrd <= 0)) == NULL)) {
+			return -1;
+		} else if (ctx->lno >= MAX_NLINES) {
+			YIELD(3);
+		}
+		YIELD(1);
+	}
 	while (off < bno) {
 		size_t rsz = bno - off;
 		char *p = memchr(off, '\n', rsz);
@@ -198,7 +869,7 @@ yield2:
 		}
 		/* massage our status structures */
 		set_loff(ctx, ctx->lno, p - ctx->buf);
-		if (UNLIKELY(p[-1] == '\r')) {
+		if (UNLIKELY(p > off && p[-1] == '\r')) {
 			/* oh god, when is this nightmare gonna end */
 			p[-1] = PRCHUNK_EOL;
 			set_lftermd(ctx, ctx->lno);
@@ -218,7 +889,6 @@ yield3:
 	ctx->off = off - ctx->buf;
 	ctx->bno = bno - ctx->buf;
 #undef YIELD
-#undef CHUNK_SIZE
 	return res;
 }
 
@@ -227,33 +897,106 @@ yield3:
 FDEFU prch_ctx_t
 init_prchunk(int fd)
 {
-#define MAP_LEN		(MAX_NLINES * MAX_LLEN)
-	__ctx->buf = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
-	if (__ctx->buf == MAP_FAILED) {
+	__ctx->mem = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
+	if (__ctx->mem == MAP_FAILED) {
+		__ctx->mem = NULL;
 		return NULL;
 	}
+	/* leave a byte for the terminator of an overlong line */
+	__ctx->mz = MAP_LEN - 1U;
+	__ctx->buf = __ctx->mem;
+	__ctx->lno = __ctx->lno_cur = 0U;
+	__ctx->bno = __ctx->off = 0U;
 
 	/* bit of space for the rechunker */
 	__ctx->soff = mmap(NULL, MAP_LEN, PROT_MEM, MAP_MEM, -1, 0);
 	if (__ctx->soff == MAP_FAILED) {
+		free_prchunk(__ctx);
 		return NULL;
 	}
+	/* and for the structural indexer */
+	__ctx->sidx = malloc(STIDX_BLK * sizeof(*__ctx->sidx));
+	if (__ctx->sidx == NULL) {
+		free_prchunk(__ctx);
+		return NULL;
+	}
+	__ctx->dlm = '\0';
 
 	__ctx->fd = fd;
+	__ctx->z = NULL;
 #if defined POSIX_FADV_SEQUENTIAL
 	/* give advice about our read pattern */
 	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 #endif	/* POSIX_FADV_SEQUENTIAL */
+
+	/* sniff the input, whatever we read stays in the buffer as
+	 * the beginning of the first chunk unless it's compressed */
+	while (__ctx->bno < PRZIP_MAGIC_LEN) {
+		ssize_t nrd = read(fd, __ctx->mem + __ctx->bno,
+				   PRZIP_MAGIC_LEN - __ctx->bno);
+
+		if (nrd > 0) {
+			__ctx->bno += nrd;
+		} else if (nrd == 0 || errno != EINTR) {
+			break;
+		}
+	}
+	with (przip_fmt_t fmt = przip_fmt(__ctx->mem, __ctx->bno)) {
+		if (LIKELY(fmt == PRZIP_NONE)) {
+			break;
+		}
+#if defined HAVE_PRZIP
+		__ctx->z = make_przip(fd, fmt, __ctx->mem, __ctx->bno);
+		if (__ctx->z != NULL) {
+			__ctx->bno = 0U;
+			break;
+		}
+#endif	/* HAVE_PRZIP */
+		/* leave it to the muxer to make sense of it */
+		fputs("prchunk: cannot decode compressed input\n", stderr);
+	}
 	return __ctx;
 }
 
 FDEFU void
 free_prchunk(prch_ctx_t ctx)
 {
-	if (LIKELY(ctx->buf != NULL)) {
-		munmap(ctx->buf, MAP_LEN);
-		ctx->buf = NULL;
+	if (LIKELY(ctx->mem != NULL)) {
+		munmap(ctx->mem, MAP_LEN);
+		ctx->mem = ctx->buf = NULL;
+	}
+	if (LIKELY(ctx->soff != NULL && ctx->soff != MAP_FAILED)) {
+		munmap(ctx->soff, MAP_LEN);
+	}
+	ctx->soff = NULL;
+	if (ctx->sidx != NULL) {
+		free(ctx->sidx);
+		ctx->sidx = NULL;
 	}
+	if (ctx->fo != NULL) {
+		free(ctx->fo);
+		ctx->fo = NULL;
+		ctx->foz = 0U;
+	}
+#if defined HAVE_PRZIP
+	if (ctx->z != NULL) {
+		free_przip(ctx->z);
+		ctx->z = NULL;
+	}
+#endif	/* HAVE_PRZIP */
+	return;
+}
+
+FDEFU int
+prchunk_zipp(const char *buf, size_t bsz)
+{
+	return przip_fmt(buf, bsz) != PRZIP_NONE;
+}
+
+FDEFU void
+prchunk_set_delim(prch_ctx_t ctx, char delim)
+{
+	ctx->dlm = delim;
 	return;
 }
 
@@ -286,6 +1029,29 @@ prchunk_getline(prch_ctx_t ctx, char **p)
 	return prchunk_getlineno(ctx, p, ctx->lno_cur++);
 }
 
+FDEFU size_t
+prchunk_getfono(prch_ctx_t ctx, const uint32_t **fo, int lno)
+{
+	size_t beg;
+
+	if (UNLIKELY(!ctx->dlm)) {
+		*fo = NULL;
+		return 0U;
+	} else if (UNLIKELY(lno < 0 || (size_t)lno >= prchunk_get_nlines(ctx))) {
+		*fo = NULL;
+		return 0U;
+	}
+	beg = ctx->lfo[lno];
+	*fo = ctx->fo + beg;
+	return ctx->lfo[lno + 1] - beg;
+}
+
+FDEFU size_t
+prchunk_getfo(prch_ctx_t ctx, const uint32_t **fo)
+{
+	return prchunk_getfono(ctx, fo, ctx->lno_cur - 1);
+}
+
 FDEFU void
 prchunk_reset(prch_ctx_t ctx)
 {
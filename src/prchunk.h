@@ -38,6 +38,8 @@
 #if !defined INCLUDED_prchunk_h_
 #define INCLUDED_prchunk_h_
 
+#include <stdint.h>
+
 #if !defined STATIC_GUTS
 # define FDECL		extern
 # define FDEFU
@@ -54,6 +56,11 @@ typedef struct prch_ctx_s *prch_ctx_t;
 FDECL prch_ctx_t init_prchunk(int fd);
 FDECL void free_prchunk(prch_ctx_t);
 
+/**
+ * Have prchunk_fill() find the field delimiters DELIM along with the
+ * line ends, call before the first fill. */
+FDECL void prchunk_set_delim(prch_ctx_t ctx, char delim);
+
 FDECL int prchunk_fill(prch_ctx_t ctx);
 
 FDECL size_t prchunk_get_nlines(prch_ctx_t);
@@ -64,6 +71,23 @@ FDECL size_t prchunk_getline(prch_ctx_t ctx, char **p);
 FDECL void prchunk_reset(prch_ctx_t ctx);
 FDECL int prchunk_haslinep(prch_ctx_t ctx);
 
+/**
+ * Point FO to the delimiter offsets of line LNO, relative to the
+ * beginning of the line, and return how many there are.
+ * The delimiters themselves are left alone.
+ * Only available after prchunk_set_delim(). */
+FDECL size_t prchunk_getfono(prch_ctx_t ctx, const uint32_t **fo, int lno);
+/**
+ * Like prchunk_getfono() for the line last returned by prchunk_getline(). */
+FDECL size_t prchunk_getfo(prch_ctx_t ctx, const uint32_t **fo);
+
+/**
+ * Return non-zero if the BSZ bytes in BUF look like the beginning of
+ * gzip, xz or zstd compressed input.
+ * init_prchunk() checks for this itself and has prchunk_fill() decode
+ * such input transparently. */
+FDECL int prchunk_zipp(const char *buf, size_t bsz);
+
 FDECL void prchunk_rechunk(prch_ctx_t ctx, char delim, int ncols);
 FDECL size_t prchunk_getcolno(prch_ctx_t ctx, char **p, int lno, int cno);
 
@@ -0,0 +1,151 @@
+/*** prfmt.h -- digits and stamps for line printers
+ *
+ * Copyright (C) 2026 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of uterus.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+#if !defined INCLUDED_prfmt_h_
+#define INCLUDED_prfmt_h_
+
+#include <stdint.h>
+#include <string.h>
+
+/* all two-digit numbers, 00 to 99 */
+static const char __attribute__((unused)) prfmt_dig2[200U] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static inline char*
+prfmt_udec_rev(char *ep, uint64_t v)
+{
+/* write V in decimal so that it ends right before EP,
+ * return a pointer to the first digit */
+	while (v >= 100U) {
+		const unsigned int d = (unsigned int)(v % 100U);
+
+		v /= 100U;
+		ep -= 2;
+		memcpy(ep, prfmt_dig2 + 2U * d, 2U);
+	}
+	if (v >= 10U) {
+		ep -= 2;
+		memcpy(ep, prfmt_dig2 + 2U * v, 2U);
+	} else {
+		*--ep = (char)('0' + v);
+	}
+	return ep;
+}
+
+static inline char*
+prfmt_frac_rev(char *ep, uint64_t *v, unsigned int n)
+{
+/* write the N least significant decimal digits of *V so that they end
+ * right before EP, leading zeroes included, and strip them off *V */
+	uint64_t x = *v;
+
+	for (; n >= 2U; n -= 2U) {
+		const unsigned int d = (unsigned int)(x % 100U);
+
+		x /= 100U;
+		ep -= 2;
+		memcpy(ep, prfmt_dig2 + 2U * d, 2U);
+	}
+	if (n) {
+		*--ep = (char)('0' + x % 10U);
+		x /= 10U;
+	}
+	*v = x;
+	return ep;
+}
+
+/**
+ * Print V in decimal to BUF, return the number of characters written. */
+static inline size_t
+prfmt_udec(char *restrict buf, uint64_t v)
+{
+	char tmp[20U];
+	const char *p = prfmt_udec_rev(tmp + sizeof(tmp), v);
+	const size_t n = tmp + sizeof(tmp) - p;
+
+	memcpy(buf, p, n);
+	return n;
+}
+
+/**
+ * Print V in lower-case hex to BUF like "%x" would,
+ * return the number of characters written. */
+static inline size_t
+prfmt_hex(char *restrict buf, uint32_t v)
+{
+	static const char hx[] = "0123456789abcdef";
+	/* number of nibbles, at least one */
+	const size_t n = v ? (32U - __builtin_clz(v) + 3U) / 4U : 1U;
+
+	for (size_t i = n; i-- > 0U; v >>= 4U) {
+		buf[i] = hx[v & 0xfU];
+	}
+	return n;
+}
+
+/**
+ * Like prfmt_hex() but always print 8 nibbles, like "%08x". */
+static inline size_t
+prfmt_hex8(char *restrict buf, uint32_t v)
+{
+	static const char hx[] = "0123456789abcdef";
+
+	for (size_t i = 8U; i-- > 0U; v >>= 4U) {
+		buf[i] = hx[v & 0xfU];
+	}
+	return 8U;
+}
+
+/**
+ * Print the two decimal digits of V (< 100) to BUF. */
+static inline void
+prfmt_dig2_s(char *restrict buf, unsigned int v)
+{
+	memcpy(buf, prfmt_dig2 + 2U * v, 2U);
+	return;
+}
+
+#endif	/* INCLUDED_prfmt_h_ */
@@ -261,6 +261,9 @@ scom_thdr_set_tblidx(scom_thdr_t h, unsigned int idx)
 #define SCOM_FLAG_LM	16
 /* flag that denotes quadruple tick size(?) used for level2 ticks */
 #define SCOM_FLAG_L2M	32
+/* both flags denote a wide index sandwich that precedes the actual tick,
+ * the sandwich's sat slot carries the full 32bit symbol index */
+#define SCOM_FLAG_WIDX	(SCOM_FLAG_LM | SCOM_FLAG_L2M)
 
 static inline __attribute__((pure)) uint16_t
 scom_thdr_ttf(scom_t h)
@@ -295,6 +298,45 @@ scom_thdr_unset_linked(scom_thdr_t h)
 	return;
 }
 
+/**
+ * Return true if H is a wide index sandwich. */
+static inline __attribute__((pure)) bool
+scom_thdr_widx_p(scom_t h)
+{
+	return (h->ttf & SCOM_FLAG_WIDX) == SCOM_FLAG_WIDX;
+}
+
+/**
+ * Return the full symbol index stored in wide index sandwich H. */
+static inline __attribute__((pure)) unsigned int
+scom_widx(scom_t h)
+{
+	return ((const uint32_t*)h)[2];
+}
+
+/**
+ * Return the tick following the wide index sandwich H. */
+static inline __attribute__((pure)) scom_t
+scom_widx_tick(scom_t h)
+{
+	return (scom_t)((const struct sndwch_s*)h + 1);
+}
+
+/**
+ * Fill wide index sandwich TGT for tick T and symbol index IDX. */
+static inline void
+scom_widx_fill(scom_thdr_t tgt, scom_t t, unsigned int idx)
+{
+	uint32_t *p = (uint32_t*)tgt;
+
+	tgt->u = t->u;
+	tgt->idx = idx;
+	tgt->ttf = SCOM_FLAG_WIDX;
+	p[2] = idx;
+	p[3] = 0U;
+	return;
+}
+
 
 /* weird stuff */
 static inline void
@@ -407,22 +449,36 @@ scom_thdr_mark_padding(scom_thdr_t t)
 
 
 /* helpers for variadically-sized ticks */
-/**
- * Return the size of T in ticks (multiples of struct sndwch_s). */
-static inline __attribute__((pure)) size_t
-scom_tick_size(scom_t t)
+static inline __attribute__((const)) size_t
+__scom_ttf_size(unsigned int ttf)
 {
-	if (!(scom_thdr_ttf(t) & (SCOM_FLAG_LM | SCOM_FLAG_L2M))) {
+	switch (ttf & (SCOM_FLAG_LM | SCOM_FLAG_L2M)) {
+	case 0U:
+	case SCOM_FLAG_WIDX:
+		/* stray wide index sandwiches count as 1 */
 		return 1UL;
-	} else if (scom_thdr_ttf(t) & SCOM_FLAG_LM) {
+	case SCOM_FLAG_LM:
 		return 2UL;
-	} else if (scom_thdr_ttf(t) & SCOM_FLAG_L2M) {
+	case SCOM_FLAG_L2M:
 		return 4UL;
-	} else {
+	default:
 		return 0UL;
 	}
 }
 
+/**
+ * Return the size of T in ticks (multiples of struct sndwch_s).
+ * Wide index sandwiches are accounted for together with their tick. */
+static inline __attribute__((pure)) size_t
+scom_tick_size(scom_t t)
+{
+	if (scom_thdr_widx_p(t)) {
+		/* the wide index sandwich travels with its tick */
+		return 1UL + __scom_ttf_size(scom_widx_tick(t)->ttf);
+	}
+	return __scom_ttf_size(t->ttf);
+}
+
 /**
  * Return the size of T in bytes. */
 static inline __attribute__((pure)) size_t
@@ -0,0 +1,106 @@
+/*** swar.h -- decimal digits, 8 at a time
+ *
+ * Copyright (C) 2026 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of uterus.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+#if !defined INCLUDED_swar_h_
+#define INCLUDED_swar_h_
+
+#include <stdint.h>
+#include <string.h>
+
+#define SWAR_ONES	(0x0101010101010101ULL)
+
+static const uint64_t swar_p10[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL,
+};
+
+static inline int
+swar_safe_p(const char *p)
+{
+/* whether 8 bytes at P are on the same (smallest possible) page */
+	return __builtin_expect(((uintptr_t)p & 4095U) <= 4096U - 8U, 1);
+}
+
+static inline uint64_t
+swar_ld(const char *p, size_t n)
+{
+/* load the 8 bytes at P of which only the first N are known to exist,
+ * the first byte goes to the least significant end */
+	uint64_t w = 0U;
+
+	if (swar_safe_p(p)) {
+		/* can't run into an unmapped page */
+		memcpy(&w, p, 8U);
+	} else {
+		memcpy(&w, p, n < 8U ? n : 8U);
+	}
+#if defined WORDS_BIGENDIAN
+	w = __builtin_bswap64(w);
+#endif	/* WORDS_BIGENDIAN */
+	return w;
+}
+
+static inline uint64_t
+swar_get8(uint64_t w, unsigned int n)
+{
+/* return the value of the first N (at most 8) digits in W */
+	if (__builtin_expect(n == 0U, 0)) {
+		return 0U;
+	}
+	/* ascii to digits, push the excess bytes out at the top */
+	w ^= 0x30U * SWAR_ONES;
+	w <<= 8U * (8U - n);
+	/* combine neighbours, 2 digits, then 4, then 8 */
+	w = (w * 10U + (w >> 8U)) & 0x00ff00ff00ff00ffULL;
+	w = (w * 100U + (w >> 16U)) & 0x0000ffff0000ffffULL;
+	w = (w * 10000U + (w >> 32U)) & 0x00000000ffffffffULL;
+	return w;
+}
+
+static inline uint64_t
+swar_getn(const char *p, size_t n)
+{
+/* return the value of the N digits at P, modulo 2^64 */
+	uint64_t r = 0U;
+
+	for (; n > 8U; n -= 8U, p += 8U) {
+		r = r * swar_p10[8U] + swar_get8(swar_ld(p, 8U), 8U);
+	}
+	return r * swar_p10[n] + swar_get8(swar_ld(p, n), n);
+}
+
+#endif	/* INCLUDED_swar_h_ */
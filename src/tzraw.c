@@ -625,13 +625,29 @@ zif_find_zrng(zif_t z, int32_t t)
 	return __find_zrng(z, t, min, max);
 }
 
-static int32_t
-__offs(struct zif_s z[static 1U], int32_t t)
+static struct zrng_s
+__seek_zrng(const struct zif_s z[static 1U], struct zrng_s r, int32_t t)
 {
-/* return the offset of T in Z and cache the result. */
-	int min;
-	size_t max;
+/* find the range T belongs to, R is the range of the previous lookup
+ * so only the transitions on T's side of R need searching */
+	int min = 0;
+	int max = zif_ntrans(z);
+
+	if (UNLIKELY(r.prev >= r.next)) {
+		/* R is no range at all */
+		;
+	} else if (t >= r.next) {
+		min = r.trno + 1;
+	} else if (t < r.prev) {
+		max = r.trno;
+	}
+	return __find_zrng(z, t, min, max);
+}
 
+static inline int32_t
+__offs_r(const struct zif_s z[static 1U], struct zrng_s r[static 1U], int32_t t)
+{
+/* return the offset of T in Z, R caches the range of the last lookup */
 	switch (z->cz) {
 	default:
 	case TZCZ_UNK:
@@ -640,26 +656,22 @@ __offs(struct zif_s z[static 1U], int32_t t)
 		return 0;
 	}
 
-	/* use the classic code */
-	if (LIKELY(t >= z->cache.prev && t < z->cache.next)) {
+	if (LIKELY(t >= r->prev && t < r->next)) {
 		/* use the cached offset */
-		return z->cache.offs;
-	} else if (t >= z->cache.next) {
-		min = z->cache.trno + 1;
-		max = zif_ntrans(z);
-	} else if (t < z->cache.prev) {
-		max = z->cache.trno;
-		min = 0;
-	} else {
-		/* we shouldn't end up here at all */
-		min = 0;
-		max = 0;
+		return r->offs;
 	}
-	return (z->cache = __find_zrng(z, t, min, max)).offs;
+	return (*r = __seek_zrng(z, *r, t)).offs;
 }
 
-DEFUN int32_t
-zif_utc_time(zif_t z, int32_t t)
+static int32_t
+__offs(struct zif_s z[static 1U], int32_t t)
+{
+/* return the offset of T in Z and cache the result. */
+	return __offs_r(z, &z->cache, t);
+}
+
+static int32_t
+__utc_time(const struct zif_s z[static 1U], struct zrng_s r[static 1U], int32_t t)
 {
 /* here's the setup, given t in local time, we denote the corresponding
  * UTC time by t' = t - x' where x' is the true offset
@@ -670,23 +682,36 @@ zif_utc_time(zif_t z, int32_t t)
  * To make this iterative we just solve:
  * x_{i+1} - x_i = 0, where x_{i+1} = o(t - x_i) and o maps a given
  * time stamp to an offset. */
-/* make me use the cache please! */
 	/* let's go */
 	int32_t xi = 0;
 	int32_t xj;
 	int32_t old = -1;
 
-	/* jump off the cliff if Z is nought */
-	if (UNLIKELY(z == NULL)) {
-		return t;
-	}
+	/* a day away from R's transitions the cached offset is the only
+	 * solution, offsets never differ by a day or more */
+	{
+		const int64_t u = (int64_t)t - r->offs;
 
-	while ((xj = __offs(AS_MUT_ZIF(z), t - xi)) != xi && xi != old) {
+		if (LIKELY(u - r->prev >= 86400 && r->next - u > 86400)) {
+			return (int32_t)u;
+		}
+	}
+	while ((xj = __offs_r(z, r, t - xi)) != xi && xi != old) {
 		old = xi = xj;
 	}
 	return t - xj;
 }
 
+DEFUN int32_t
+zif_utc_time(zif_t z, int32_t t)
+{
+	/* jump off the cliff if Z is nought */
+	if (UNLIKELY(z == NULL)) {
+		return t;
+	}
+	return __utc_time(z, &AS_MUT_ZIF(z)->cache, t);
+}
+
 /* convert utc to local */
 DEFUN int32_t
 zif_local_time(zif_t z, int32_t t)
@@ -698,5 +723,55 @@ zif_local_time(zif_t z, int32_t t)
 	return t + __offs(AS_MUT_ZIF(z), t);
 }
 
+
+/* cursors */
+DEFUN void
+zif_cur_init(struct zcur_s c[static 1U], zif_t z)
+{
+	c->z = z;
+	/* an empty range, the first lookup will search everything */
+	c->rng = (struct zrng_s){0};
+	return;
+}
+
+DEFUN int32_t
+zif_cur_local_time(struct zcur_s c[static 1U], int32_t t)
+{
+	if (UNLIKELY(c->z == NULL)) {
+		return t;
+	}
+	return t + __offs_r(c->z, &c->rng, t);
+}
+
+DEFUN int32_t
+zif_cur_utc_time(struct zcur_s c[static 1U], int32_t t)
+{
+	if (UNLIKELY(c->z == NULL)) {
+		return t;
+	}
+	return __utc_time(c->z, &c->rng, t);
+}
+
+DEFUN void
+zif_cur_local_times(
+	struct zcur_s c[static 1U],
+	int32_t *tgt, const int32_t *src, size_t n)
+{
+	if (UNLIKELY(c->z == NULL)) {
+		memmove(tgt, src, n * sizeof(*src));
+		return;
+	}
+	for (size_t i = 0U; i < n;) {
+		const int32_t offs = __offs_r(c->z, &c->rng, src[i]);
+		const int32_t next = c->rng.next;
+
+		/* the whole run inside the current range in one go */
+		do {
+			tgt[i] = src[i] + offs;
+		} while (++i < n && src[i] < next && src[i] >= c->rng.prev);
+	}
+	return;
+}
+
 #endif	/* INCLUDED_tzraw_c_ */
 /* tzraw.c ends here */
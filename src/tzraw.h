@@ -153,6 +153,38 @@ extern int32_t zif_utc_time(zif_t z, int32_t t);
 extern int32_t zif_local_time(zif_t z, int32_t t);
 
 
+/**
+ * Cursor into the transitions of a zone.
+ * A cursor remembers the transition range of the last stamp converted
+ * and searches again only when a stamp leaves it, so converting stamps
+ * in (mostly) ascending order is O(1) per stamp. */
+struct zcur_s {
+	zif_t z;
+	struct zrng_s rng;
+};
+
+/**
+ * Set up cursor C for zone Z, Z may be NULL for UTC. */
+extern void zif_cur_init(struct zcur_s c[static 1U], zif_t z);
+
+/**
+ * Like zif_local_time() but use the range cached in C. */
+extern int32_t zif_cur_local_time(struct zcur_s c[static 1U], int32_t t);
+
+/**
+ * Like zif_utc_time() but use the range cached in C. */
+extern int32_t zif_cur_utc_time(struct zcur_s c[static 1U], int32_t t);
+
+/**
+ * Convert the N UTC stamps in SRC to local time and put them into TGT,
+ * TGT may be SRC.  For sorted SRC, transitions are looked up only once
+ * per range. */
+extern void
+zif_cur_local_times(
+	struct zcur_s c[static 1U],
+	int32_t *tgt, const int32_t *src, size_t n);
+
+
 /* exposure for specific zif-inspecting tools (dzone(1) for one) */
 extern inline size_t zif_ntrans(zif_t z);
 
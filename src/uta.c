@@ -80,6 +80,9 @@
 #define MAX_LINE_LEN	512
 #define countof(x)	(sizeof(x) / sizeof(*x))
 
+/* lines don't depend on each other, ute-mux may cut our inputs */
+const int mux_linewise = 1;
+
 
 /* muxing caps */
 /* read buffer goodies */
@@ -126,8 +129,9 @@ hex2int(const char **cursor)
 }
 
 static const char*
-parse_symbol(const char **cursor)
+parse_symbol(const char **cursor, const char *eos)
 {
+/* EOS is the tab after the symbol as found by the indexer, or NULL */
 	const char *p = *cursor;
 	static char symbuf[64];
 	size_t len;
@@ -147,7 +151,7 @@ parse_symbol(const char **cursor)
 	}
 
 	/* otherwise it could be a real symbol, read up to the tab */
-	if ((p = strchr(p + 1, '\t')) == NULL) {
+	if ((p = eos) == NULL) {
 		/* no idea what *cursor should point to, NULL maybe? */
 		return *cursor = NULL;
 	}
@@ -276,10 +280,11 @@ __u64_payload_p(uint16_t ttf)
 }
 
 static int
-read_line(mux_ctx_t ctx, struct sndwch_s *tl)
+read_line(mux_ctx_t ctx, struct sndwch_s *tl, unsigned int *idx)
 {
 	const char *cursor;
 	char *line;
+	const uint32_t *fo;
 	/* symbol and its index */
 	const char *sym;
 	unsigned int symidx;
@@ -292,7 +297,11 @@ read_line(mux_ctx_t ctx, struct sndwch_s *tl)
 	cursor = line;
 
 	/* symbol comes next, or `nothing' or `C-c' */
-	if (UNLIKELY((sym = parse_symbol(&cursor), cursor == NULL))) {
+	if (UNLIKELY(!prchunk_getfo(ctx->rdr, &fo))) {
+		/* not even a tab */
+		return -1;
+	} else if (UNLIKELY((sym = parse_symbol(&cursor, line + *fo),
+			     cursor == NULL))) {
 		/* symbol parse error, innit? */
 		return -1;
 	} else if (UNLIKELY(parse_rcv_stmp(AS_SCOM_THDR(tl), &cursor) < 0)) {
@@ -331,9 +340,10 @@ read_line(mux_ctx_t ctx, struct sndwch_s *tl)
 		return -1;
 	}
 
-	/* bang it all into the target tick */
-	scom_thdr_set_tblidx(AS_SCOM_THDR(tl), (uint16_t)symidx);
+	/* bang it all into the target tick, wide indices go separately */
+	scom_thdr_set_tblidx(AS_SCOM_THDR(tl), symidx);
 	scom_thdr_set_ttf(AS_SCOM_THDR(tl), ttf);
+	*idx = symidx;
 
 	/* now on to the payload */
 	if (ttf < SCOM_FLAG_LM && UNLIKELY(__u64_payload_p(ttf))) {
@@ -413,8 +423,10 @@ read_lines(mux_ctx_t ctx)
 {
 	while (moar_ticks_p(ctx)) {
 		struct sndwch_s buf[4];
-		if (read_line(ctx, buf) == 0) {
-			ute_add_tick(ctx->wrr, AS_SCOM(buf));
+		unsigned int idx;
+
+		if (read_line(ctx, buf, &idx) == 0) {
+			ute_add_tick_idx(ctx->wrr, AS_SCOM(buf), idx);
 		}
 	}
 	return;
@@ -485,12 +497,12 @@ __pr_snap(char *tgt, scom_t st)
 	p += ffff_m30_s(p, (m30_t)snp->aq);
 	*p++ = '\t';
 	/* volume-weighted trade price */
-	p += sprintf(p, "%08x", snp->tvpr);
+	p += prfmt_hex8(p, snp->tvpr);
 	*p++ = '|';
 	p += ffff_m30_s(p, (m30_t)snp->tvpr);
 	*p++ = '\t';
 	/* trade quantity */
-	p += sprintf(p, "%08x", snp->tq);
+	p += prfmt_hex8(p, snp->tq);
 	*p++ = '|';
 	p += ffff_m30_s(p, (m30_t)snp->tq);
 	return p - tgt;
@@ -520,7 +532,7 @@ __pr_cdl(char *tgt, scom_t st)
 	p += ffff_m30_s(p, (m30_t)cdl->c);
 	*p++ = '\t';
 	/* start of the candle */
-	p += sprintf(p, "%08x", cdl->sta_ts);
+	p += prfmt_hex8(p, cdl->sta_ts);
 	*p++ = '|';
 	if (cdl->sta_ts >= 100000 || scom_thdr_sec(cdl->hdr) < 100000) {
 		p += pr_tsmstz(p, cdl->sta_ts, 0, NULL, 'T');
@@ -530,7 +542,7 @@ __pr_cdl(char *tgt, scom_t st)
 	}
 	*p++ = '\t';
 	/* event count in candle, print 3 times */
-	p += sprintf(p, "%08x", cdl->cnt);
+	p += prfmt_hex8(p, cdl->cnt);
 	*p++ = '|';
 	p += ffff_m30_s(p, (m30_t)cdl->cnt);
 	return p - tgt;
@@ -543,6 +555,7 @@ mux(mux_ctx_t ctx)
 {
 	/* main loop */
 	ctx->rdr = init_prchunk(ctx->infd);
+	prchunk_set_delim(ctx->rdr, '\t');
 	while (fetch_lines(ctx)) {
 		read_lines(ctx);
 	}
@@ -554,16 +567,21 @@ mux(mux_ctx_t ctx)
 int
 pr(pr_ctx_t pctx, scom_t st)
 {
-	char tl[MAX_LINE_LEN];
+	char tbuf[MAX_LINE_LEN];
+	char *tl;
 	uint32_t sec = scom_thdr_sec(st);
 	uint16_t msec = scom_thdr_msec(st);
 	uint16_t ttf = scom_thdr_ttf(st);
 	ssize_t res;
 	char *p;
 
+	/* format straight into the output buffer if there is one */
+	if ((tl = pr_obuf(pctx, sizeof(tbuf))) == NULL) {
+		tl = tbuf;
+	}
 	/* equip or print context with buffers and whatnot */
 	pctx->buf = tl;
-	pctx->bsz = sizeof(tl);
+	pctx->bsz = sizeof(tbuf);
 	if ((res = print_tick_sym(pctx, st)) > 0) {
 		p = tl + res;
 	} else {
@@ -572,13 +590,13 @@ pr(pr_ctx_t pctx, scom_t st)
 		*p++ = '0';
 	}
 	*p++ = '\t';
-	p += pr_tsmstz(p, sec, msec, NULL, 'T');
+	p += pr_tsmstz_ctx(pctx, p, sec, msec, NULL, 'T');
 	*p++ = '\t';
 	/* index into the sym table */
-	p += sprintf(p, "%x", scom_thdr_tblidx(st));
+	p += prfmt_hex(p, pr_tblidx(pctx, st));
 	*p++ = '\t';
 	/* tick type */
-	p += sprintf(p, "%x", ttf);
+	p += prfmt_hex(p, ttf);
 	*p++ = '\t';
 	switch (ttf) {
 		const_sl1t_t l1t;
@@ -637,7 +655,9 @@ pr(pr_ctx_t pctx, scom_t st)
 	*p = '\0';
 
 	/* and off we go */
-	if (write(pctx->outfd, tl, p - tl) < 0) {
+	if (LIKELY(tl != tbuf)) {
+		pr_obuf_adv(pctx, p - tl);
+	} else if (write(pctx->outfd, tl, p - tl) < 0) {
 		return -1;
 	}
 	return 0;
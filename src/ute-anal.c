@@ -40,11 +40,15 @@
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "utefile-private.h"
 #include "utefile.h"
 #include "scommon.h"
@@ -87,13 +91,21 @@ typedef const struct anal_ctx_s *anal_ctx_t;
 struct anal_ctx_s {
 	int intv;
 	int modu;
+	size_t njobs;
 	utectx_t u;
 };
 
-
-/* the actual anal'ing */
-/* we're anal'ing single scom's, much like a prf() in ute-print */
-static struct anal_pot_s {
+#if defined HAVE_PNG_H
+/* hold maps, they indicate the return when going long or short
+ * at one point and close the position at another */
+#define HMAP_WIDTH	(256U)
+#define HMAP_FACTR	(4U)
+#define MINI_WIDTH	(HMAP_WIDTH / HMAP_FACTR)
+/* samples kept per symbol, thinned out to every other once full */
+#define SMPL_WIDTH	(2U * HMAP_WIDTH)
+#endif	/* HAVE_PNG_H */
+
+struct anal_pot_s {
 	double o;
 	double c;
 	time_t to;
@@ -102,10 +114,29 @@ static struct anal_pot_s {
 	double hi;
 	time_t tlo;
 	time_t thi;
-} pot;
+};
 
+struct anal_sym_s {
+	struct anal_pot_s pot;
+#if defined HAVE_PNG_H
+	/* bid/ask samples, one every STRD seconds from POT.TO on */
+	time_t ref;
+	time_t strd;
+	size_t nsmpl;
+	m30_t *bids;
+	m30_t *asks;
+	/* the sample being assembled, bit 0 for bid, bit 1 for ask */
+	m30_t pb;
+	m30_t pa;
+	unsigned int pf;
+#endif	/* HAVE_PNG_H */
+};
+
+
+/* the actual anal'ing */
+/* we're anal'ing single scom's, much like a prf() in ute-print */
 static int
-anal(anal_ctx_t UNUSED(ctx), scom_t ti)
+anal(struct anal_pot_s *restrict pot, scom_t ti)
 {
 	unsigned int ttf = scom_thdr_ttf(ti);
 	time_t t;
@@ -121,28 +152,28 @@ anal(anal_ctx_t UNUSED(ctx), scom_t ti)
 		return 0;
 	}
 
-	if (UNLIKELY(!pot.to)) {
-		pot.o = p;
-		pot.to = t;
+	if (UNLIKELY(!pot->to)) {
+		pot->o = p;
+		pot->to = t;
 	}
-	if (p < pot.lo) {
-		pot.lo = p;
-		pot.tlo = t;
+	if (p < pot->lo) {
+		pot->lo = p;
+		pot->tlo = t;
 	}
-	if (p > pot.hi) {
-		pot.hi = p;
-		pot.thi = t;
+	if (p > pot->hi) {
+		pot->hi = p;
+		pot->thi = t;
 	}
 	/* always go for the clo */
-	pot.c = p;
-	pot.tc = t;
+	pot->c = p;
+	pot->tc = t;
 	return 0;
 }
 
 static void
-pr_pot(void)
+pr_pot(const struct anal_pot_s *pot)
 {
-	static char buf[64];
+	static char buf[256];
 	enum {
 		SHAPE__,
 		SHAPE_N,
@@ -150,9 +181,9 @@ pr_pot(void)
 	} shape;
 	char *bp = buf;
 
-	if (pot.tlo < pot.thi) {
+	if (pot->tlo < pot->thi) {
 		shape = SHAPE_M;
-	} else if (pot.tlo > pot.thi) {
+	} else if (pot->tlo > pot->thi) {
 		shape = SHAPE_N;
 	} else {
 		shape = SHAPE__;
@@ -172,42 +203,42 @@ pr_pot(void)
 	}
 	*bp++ = ',';
 
-	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot.o);
+	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot->o);
 	*bp++ = ',';
 	switch (shape) {
 	default:
 	case SHAPE__:
 		break;
 	case SHAPE_N:
-		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot.hi);
+		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot->hi);
 		*bp++ = ',';
-		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot.lo);
+		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot->lo);
 		break;
 	case SHAPE_M:
-		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot.lo);
+		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot->lo);
 		*bp++ = ',';
-		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot.hi);
+		bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot->hi);
 		break;
 	}
 	*bp++ = ',';
 
-	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot.c);
+	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f", pot->c);
 	*bp++ = ',';
 
 	/* relative values now */
-	double rel_co = pot.c / pot.o - 1.0;
+	double rel_co = pot->c / pot->o - 1.0;
 	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f%%", 100.0 * rel_co);
 	*bp++ = ',';
 
-	double rel_hl = pot.hi / pot.lo - 1.0;
+	double rel_hl = pot->hi / pot->lo - 1.0;
 	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f%%", 100.0 * rel_hl);
 	*bp++ = ',';
 
-	double rel_co2 = (pot.c - pot.o) / (pot.c + pot.o);
+	double rel_co2 = (pot->c - pot->o) / (pot->c + pot->o);
 	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f%%", 100.0 * rel_co2);
 	*bp++ = ',';
 
-	double rel_hl2 = (pot.hi - pot.lo) / (pot.hi + pot.lo);
+	double rel_hl2 = (pot->hi - pot->lo) / (pot->hi + pot->lo);
 	bp += snprintf(bp, sizeof(buf) - (bp - buf), "%.4f%%", 100.0 * rel_hl2);
 	*bp++ = ',';
 
@@ -219,24 +250,17 @@ pr_pot(void)
 
 
 #if defined HAVE_PNG_H
-/* hold maps, they indicate the return when going long or short
- * at one point and close the position at another */
-#define HMAP_WIDTH	(256U)
-#define HMAP_FACTR	(4U)
-#define MINI_WIDTH	(HMAP_WIDTH / HMAP_FACTR)
-
 static struct {
 	double bids[HMAP_WIDTH];
 	double asks[HMAP_WIDTH];
 	float hmap[HMAP_WIDTH * HMAP_WIDTH];
-	size_t idx;
 } hmap;
 
 static png_structp pp;
 static png_infop ip;
 
 static void
-rset_hmap(void)
+rset_hmap(const struct anal_sym_s *s)
 {
 	pp = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	ip = png_create_info_struct(pp);
@@ -249,13 +273,23 @@ rset_hmap(void)
 		PNG_FILTER_TYPE_DEFAULT);
 
 	memset(&hmap, -1, sizeof(hmap));
+	if (UNLIKELY(!s->nsmpl)) {
+		return;
+	}
+	/* stretch the samples we've got over the hold map */
+	for (size_t i = 0; i < HMAP_WIDTH; i++) {
+		size_t k = i * (s->nsmpl - 1U) / (HMAP_WIDTH - 1U);
+
+		hmap.bids[i] = ffff_m30_d(s->bids[k]);
+		hmap.asks[i] = ffff_m30_d(s->asks[k]);
+	}
 	return;
 }
 
 static void
-fill_hmap(void)
+fill_hmap(const struct anal_sym_s *s)
 {
-	double rel_hl = pot.hi / pot.lo - 1.0;
+	double rel_hl = s->pot.hi / s->pot.lo - 1.0;
 
 	/* lower half is bid by ask */
 	for (size_t i = 0; i < HMAP_WIDTH; i++) {
@@ -275,35 +309,60 @@ fill_hmap(void)
 }
 
 static int
-t_anal(anal_ctx_t UNUSED(ctx), scom_t ti)
+t_anal(struct anal_sym_s *restrict s, scom_t ti)
 {
+/* sample the first full bid/ask pair at or past S's reference time */
 	unsigned int ttf = scom_thdr_ttf(ti);
-	size_t idx = hmap.idx;
+
+	if (UNLIKELY(!s->pot.to)) {
+		/* the envelope hasn't started yet */
+		return -1;
+	} else if (UNLIKELY(!s->ref)) {
+		/* sampling starts along with the envelope */
+		s->ref = s->pot.to;
+	} else if (scom_thdr_sec(ti) < s->ref) {
+		return 1;
+	}
 
 	switch (ttf) {
-		m30_t b, a;
 	case SL1T_TTF_BID:
-		b = (m30_t){.v = AS_CONST_SL1T(ti)->bid};
-		hmap.bids[idx] = ffff_m30_d(b);
+		s->pb = (m30_t){.v = AS_CONST_SL1T(ti)->bid};
+		s->pf |= 1U;
 		break;
 	case SL1T_TTF_ASK:
-		a = (m30_t){.v = AS_CONST_SL1T(ti)->ask};
-		hmap.asks[idx] = ffff_m30_d(a);
+		s->pa = (m30_t){.v = AS_CONST_SL1T(ti)->ask};
+		s->pf |= 2U;
 		break;
 	case SL1T_TTF_BIDASK:
-		b = (m30_t){.v = AS_CONST_SL1T(ti)->v[0]};
-		a = (m30_t){.v = AS_CONST_SL1T(ti)->v[1]};
-		hmap.bids[idx] = ffff_m30_d(b);
-		hmap.asks[idx] = ffff_m30_d(a);
-		goto succ;
+		s->pb = (m30_t){.v = AS_CONST_SL1T(ti)->v[0]};
+		s->pa = (m30_t){.v = AS_CONST_SL1T(ti)->v[1]};
+		s->pf = 3U;
+		break;
 	default:
 		return -1;
 	}
-	if (isnan(hmap.bids[idx]) || isnan(hmap.asks[idx])) {
+	if (s->pf < 3U) {
 		return 1;
+	} else if (UNLIKELY(s->bids == NULL)) {
+		if ((s->bids = malloc(2U * SMPL_WIDTH * sizeof(*s->bids))) == NULL) {
+			return -1;
+		}
+		s->asks = s->bids + SMPL_WIDTH;
+	} else if (UNLIKELY(s->nsmpl >= SMPL_WIDTH)) {
+		/* keep every other sample and double the stride,
+		 * the reference time stays where it is */
+		for (size_t i = 1U; i < SMPL_WIDTH / 2U; i++) {
+			s->bids[i] = s->bids[2U * i];
+			s->asks[i] = s->asks[2U * i];
+		}
+		s->nsmpl = SMPL_WIDTH / 2U;
+		s->strd *= 2;
 	}
-succ:
-	hmap.idx++;
+	s->bids[s->nsmpl] = s->pb;
+	s->asks[s->nsmpl] = s->pa;
+	s->nsmpl++;
+	s->ref += s->strd;
+	s->pf = 0U;
 	return 0;
 }
 
@@ -366,12 +425,14 @@ out:
 }
 
 static void
-prnt_mini(const char *sym)
+prnt_mini(const char *sym, const struct anal_sym_s *s)
 {
 	static png_byte __rows[4U * MINI_WIDTH * MINI_WIDTH];
 	static png_byte *rows[MINI_WIDTH];
 	static png_structp png;
 	static png_infop nfo;
+	const double lo = s->pot.lo;
+	const double hi = s->pot.hi;
 	FILE *fp;
 
 	/* construct the file name */
@@ -388,8 +449,8 @@ prnt_mini(const char *sym)
 	memset(__rows, -1, sizeof(__rows));
 	for (size_t i = 0; i < MINI_WIDTH; i++) {
 		png_byte *rp;
-		double yb = (hmap.bids[HMAP_FACTR * i] - pot.lo) / (pot.hi - pot.lo);
-		double ya = (hmap.asks[HMAP_FACTR * i] - pot.lo) / (pot.hi - pot.lo);
+		double yb = (hmap.bids[HMAP_FACTR * i] - lo) / (hi - lo);
+		double ya = (hmap.asks[HMAP_FACTR * i] - lo) / (hi - lo);
 		int vb = (int)((MINI_WIDTH - 1) * (1.0 - yb));
 		int va = (int)((MINI_WIDTH - 1) * (1.0 - ya));
 
@@ -447,56 +508,126 @@ out:
 
 
 /* file wide operations */
+#if defined HAVE_PNG_H
+static void
+draw(anal_ctx_t ctx, const struct anal_sym_s *syms, size_t from, size_t till)
+{
+/* render hold map and mini chart of symbols FROM till TILL */
+	for (size_t i = from; i < till; i++) {
+		const char *sym = ute_idx2sym(ctx->u, i);
+
+		UDEBUG("drawing %s (%zu) ...\n", sym, i);
+		/* construct the hold map */
+		rset_hmap(syms + i);
+		fill_hmap(syms + i);
+		/* print the hold map */
+		prnt_hmap(sym);
+		/* print a mini chart */
+		prnt_mini(sym, syms + i);
+	}
+	return;
+}
+
+static int
+draw_par(anal_ctx_t ctx, const struct anal_sym_s *syms, size_t nsyms)
+{
+/* render the charts of NSYMS symbols with CTX's number of jobs */
+	const size_t njobs = ctx->njobs;
+	pid_t *kids;
+	int rc = 0;
+
+	if (UNLIKELY((kids = calloc(njobs, sizeof(*kids))) == NULL)) {
+		return -1;
+	}
+	/* don't let the kids inherit what's buffered */
+	fflush(stdout);
+	for (size_t j = 0U; j < njobs; j++) {
+		const size_t from = j * nsyms / njobs + 1U;
+		const size_t till = (j + 1U) * nsyms / njobs + 1U;
+
+		switch ((kids[j] = fork())) {
+		case -1:
+			/* do it ourselves */
+			kids[j] = 0;
+			draw(ctx, syms, from, till);
+			break;
+		case 0:
+			draw(ctx, syms, from, till);
+			_exit(EXIT_SUCCESS);
+		default:
+			break;
+		}
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		int st = 0;
+
+		if (kids[j] <= 0) {
+			continue;
+		}
+		while (waitpid(kids[j], &st, 0) < 0 && errno == EINTR);
+		if (UNLIKELY(!WIFEXITED(st) || WEXITSTATUS(st))) {
+			errno = 0;
+			error("anal job %zu died", j);
+			rc = -1;
+		}
+	}
+	free(kids);
+	return rc;
+}
+#endif	/* HAVE_PNG_H */
+
 static int
 anal1(anal_ctx_t ctx)
 {
 	utectx_t hdl = ctx->u;
 	size_t nsyms = ute_nsyms(hdl);
+	struct anal_sym_s *syms;
+	int rc = 0;
 
+	if (UNLIKELY((syms = calloc(nsyms + 1U, sizeof(*syms))) == NULL)) {
+		return -1;
+	}
 	for (size_t i = 1; i <= nsyms; i++) {
-		const char *sym = ute_idx2sym(ctx->u, i);
+		syms[i].pot.lo = INFINITY;
+		syms[i].pot.hi = -INFINITY;
+#if defined HAVE_PNG_H
+		syms[i].strd = 1;
+#endif	/* HAVE_PNG_H */
+	}
 
-		UDEBUG("anal'ing %s (%zu) ...\n", sym, i);
-		pot.lo = INFINITY;
-		pot.hi = -INFINITY;
+	/* one go through the file, each tick feeds its symbol's pot */
+	for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
+		size_t i = ute_tblidx(hdl, ti);
 
-		for (scom_t ti; (ti = ute_iter(ctx->u)) != NULL;) {
-			/* now to what we always do */
-			if (scom_thdr_tblidx(ti) == i) {
-				anal(ctx, ti);
-			}
+		if (UNLIKELY(!i || i > nsyms)) {
+			continue;
 		}
+		anal(&syms[i].pot, ti);
+#if defined HAVE_PNG_H
+		/* and the hold map samples */
+		t_anal(syms + i, ti);
+#endif	/* HAVE_PNG_H */
+	}
+
+	for (size_t i = 1; i <= nsyms; i++) {
+		UDEBUG("anal'ing %s (%zu) ...\n", ute_idx2sym(hdl, i), i);
 		/* print the analysis pot */
-		pr_pot();
+		pr_pot(&syms[i].pot);
+	}
 
 #if defined HAVE_PNG_H
-		/* now on to the hold map */
-		{
-			time_t ref = pot.to;
-			time_t inc = (pot.tc - pot.to) / (HMAP_WIDTH - 1U);
-
-			rset_hmap();
-			for (scom_t ti; (ti = ute_iter(ctx->u)) != NULL;) {
-				/* now to what we always do */
-				unsigned int ttf = scom_thdr_tblidx(ti);
-				time_t t = scom_thdr_sec(ti);
-
-				if (t >= ref && ttf == i) {
-					if (t_anal(ctx, ti) == 0) {
-						ref += inc;
-					}
-				}
-			}
-			/* construct the hold map */
-			fill_hmap();
-			/* print the hold map */
-			prnt_hmap(sym);
-			/* print a mini chart */
-			prnt_mini(sym);
-		}
-#endif	/* HAVE_PNG_H */
+	/* now on to the hold maps */
+	if (ctx->njobs > 1U) {
+		rc = draw_par(ctx, syms, nsyms);
+	} else {
+		draw(ctx, syms, 1U, nsyms + 1U);
 	}
-	return 0;
+	for (size_t i = 1; i <= nsyms; i++) {
+		free(syms[i].bids);
+	}
+#endif	/* HAVE_PNG_H */
+	free(syms);
+	return rc;
 }
 
 
@@ -525,6 +656,17 @@ main(int argc, char *argv[])
 warning: --modulus without --interval is not meaningful, ignored");
 	}
 
+	ctx->njobs = 1U;
+	if (argi->jobs_arg) {
+		long int nj = strtol(argi->jobs_arg, NULL, 10);
+
+		if (nj <= 0) {
+			/* use all the cpus */
+			nj = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		ctx->njobs = nj > 0 ? (size_t)nj : 1U;
+	}
+
 	for (size_t j = 0U; j < argi->nargs; j++) {
 		const char *fn = argi->args[j];
 		const int fl = UO_RDONLY | UO_NO_LOAD_TPC;
@@ -41,8 +41,12 @@
 #endif	/* HAVE_CONFIG_H */
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/wait.h>
 
 /* we're just as good as rudi, aren't we? */
 #if defined DEBUG_FLAG
@@ -61,6 +65,7 @@
 /* our own goodness */
 #include "ute-chndl.h"
 #include "cmd-aux.c"
+#include "cmd-mrg.c"
 
 /* we need to look into ticks and tick packets */
 #include "sl1t.h"
@@ -92,16 +97,47 @@ struct bkts_s {
 	uint32_t nsyms;
 	time_t cur_ts;
 	xcand_t cand;
+
+	/* candle length */
+	int interval;
+	/* level whose closed candles we're fed, or -1 for plain ticks */
+	int src;
+	/* output file */
+	void *wrr;
+
+	/* symbols that saw quotes in the current interval */
+	uint32_t *act;
+	uint32_t nact;
+	/* reader to writer symbol index, 0 if not yet looked up */
+	uint32_t *omap;
 };
 
 /* scand fiddlers */
 static inline void
 bkts_cleanse(bkts_t b)
 {
-	memset(b->cand, 0, (b->nsyms + 1) * sizeof(*b->cand));
+	/* only the active candles can be dirty */
+	for (uint32_t i = 0U; i < b->nact; i++) {
+		memset(b->cand + b->act[i], 0, sizeof(*b->cand));
+	}
+	b->nact = 0U;
 	return;
 }
 
+static int
+u32cmp(const void *x, const void *y)
+{
+	uint32_t a = *(const uint32_t*)x;
+	uint32_t b = *(const uint32_t*)y;
+	return (a > b) - (a < b);
+}
+
+static bool
+xcand_untouched_p(xcand_t c)
+{
+	return c->bcnt == 0U && c->acnt == 0U && c->tcnt == 0U;
+}
+
 static bool
 xcand_empty_p(xcand_t c)
 {
@@ -226,10 +262,14 @@ xcand_push_cdl(xcand_t c, const_scdl_t cdl)
 		c->bc->cnt += cdl->cnt;
 		if (c->bcnt == 0U) {
 			*c->bc = *cdl;
-		} else if (cdl->h > c->bc->h) {
-			c->bc->h = cdl->h;
-		} else if (cdl->l < c->bc->l) {
-			c->bc->l = cdl->l;
+		} else {
+			/* a candle can extend both ends */
+			if (cdl->h > c->bc->h) {
+				c->bc->h = cdl->h;
+			}
+			if (cdl->l < c->bc->l) {
+				c->bc->l = cdl->l;
+			}
 		}
 		c->bcnt++;
 		break;
@@ -238,10 +278,14 @@ xcand_push_cdl(xcand_t c, const_scdl_t cdl)
 		c->ac->cnt += cdl->cnt;
 		if (c->acnt == 0U) {
 			*c->ac = *cdl;
-		} else if (cdl->h > c->ac->h) {
-			c->ac->h = cdl->h;
-		} else if (cdl->l < c->ac->l) {
-			c->ac->l = cdl->l;
+		} else {
+			/* a candle can extend both ends */
+			if (cdl->h > c->ac->h) {
+				c->ac->h = cdl->h;
+			}
+			if (cdl->l < c->ac->l) {
+				c->ac->l = cdl->l;
+			}
 		}
 		c->acnt++;
 		break;
@@ -250,10 +294,14 @@ xcand_push_cdl(xcand_t c, const_scdl_t cdl)
 		c->tc->cnt += cdl->cnt;
 		if (c->tcnt == 0U) {
 			*c->tc = *cdl;
-		} else if (cdl->h > c->tc->h) {
-			c->tc->h = cdl->h;
-		} else if (cdl->l < c->tc->l) {
-			c->tc->l = cdl->l;
+		} else {
+			/* a candle can extend both ends */
+			if (cdl->h > c->tc->h) {
+				c->tc->h = cdl->h;
+			}
+			if (cdl->l < c->tc->l) {
+				c->tc->l = cdl->l;
+			}
 		}
 		c->tcnt++;
 		break;
@@ -302,21 +350,21 @@ get_buckets_time(bkts_t bctx)
 
 
 static inline time_t
-aligned_stamp(chndl_ctx_t ctx, time_t ts)
+aligned_stamp(chndl_ctx_t ctx, bkts_t b, time_t ts)
 {
-	return (time_t)(ts - ((ts - ctx->opts->offset) % ctx->opts->interval));
+	return (time_t)(ts - ((ts - ctx->opts->offset) % b->interval));
 }
 
 static inline time_t
-next_stamp(chndl_ctx_t ctx, time_t ts)
+next_stamp(bkts_t b, time_t ts)
 {
-	return ts + ctx->opts->interval;
+	return ts + b->interval;
 }
 
 static inline time_t
-next_aligned_stamp(chndl_ctx_t ctx, time_t ts)
+next_aligned_stamp(chndl_ctx_t ctx, bkts_t b, time_t ts)
 {
-	return next_stamp(ctx, aligned_stamp(ctx, ts));
+	return next_stamp(b, aligned_stamp(ctx, b, ts));
 }
 
 static inline bool
@@ -327,9 +375,9 @@ cdl_snp_p(scom_t t)
 }
 
 static inline bool
-new_candle_p(chndl_ctx_t ctx, scom_t t)
+new_candle_p(bkts_t b, scom_t t)
 {
-	time_t t1 = get_buckets_time(ctx->bkt);
+	time_t t1 = get_buckets_time(b);
 	time_t t2 = scom_thdr_sec(t);
 
 	if (UNLIKELY(t1 == 0)) {
@@ -345,30 +393,63 @@ new_candle_p(chndl_ctx_t ctx, scom_t t)
 }
 
 static unsigned int
-copy_sym(chndl_ctx_t ctx, unsigned int cidx)
+copy_sym(chndl_ctx_t ctx, bkts_t b, unsigned int cidx)
 {
-	const char *cur_sym = ute_idx2sym(ctx->rdr, cidx);
-	if (UNLIKELY(cur_sym == NULL)) {
+	const char *cur_sym;
+
+	if (LIKELY(b->omap[cidx])) {
+		return b->omap[cidx];
+	} else if (UNLIKELY((cur_sym = ute_idx2sym(ctx->rdr, cidx)) == NULL)) {
 		return 0;
 	}
-	return ute_sym2idx(ctx->wrr, cur_sym);
+	return b->omap[cidx] = ute_sym2idx(b->wrr, cur_sym);
+}
+
+static void bucketiser(chndl_ctx_t ctx, bkts_t b, unsigned int i, scom_t t);
+
+static void
+cascade(chndl_ctx_t ctx, bkts_t b,
+	unsigned int cidx, const_scdl_t c, uint32_t sta)
+{
+/* feed closed candle C of symbol CIDX to the levels built off B
+ * STA is the start stamp C came with, or 0 if it was made up */
+	const int lvl = b - ctx->bkt;
+
+	if (c->cnt == 0U) {
+		/* the other side of a one-sided candle, nothing to pass on */
+		return;
+	}
+	for (size_t k = lvl + 1U; k < ctx->nbkt; k++) {
+		if (ctx->bkt[k].src == lvl) {
+			struct scdl_s tmp = *c;
+
+			/* the bigger candle has a start of its own
+			 * unless the input dictated one */
+			tmp.sta_ts = sta;
+			bucketiser(ctx, ctx->bkt + k, cidx, AS_SCOM(&tmp));
+		}
+	}
+	return;
 }
 
 static void
-write_cand(chndl_ctx_t ctx, unsigned int cidx)
+write_cand(chndl_ctx_t ctx, bkts_t b, unsigned int cidx)
 {
 	scdl_t c[3];
+	uint32_t sta[3];
 	unsigned int nidx;
 	time_t ts;
 
-	if (xcand_empty_p(ctx->bkt->cand + cidx)) {
+	if (xcand_empty_p(b->cand + cidx)) {
 		goto check_trades;
 	}
 
-	c[0] = ctx->bkt->cand[cidx].bc;
-	c[1] = ctx->bkt->cand[cidx].ac;
-	nidx = copy_sym(ctx, cidx);
-	ts = get_buckets_time(ctx->bkt);
+	c[0] = b->cand[cidx].bc;
+	c[1] = b->cand[cidx].ac;
+	sta[0] = c[0]->sta_ts;
+	sta[1] = c[1]->sta_ts;
+	nidx = copy_sym(ctx, b, cidx);
+	ts = get_buckets_time(b);
 
 	/* bid candle */
 	scom_thdr_set_tblidx(c[0]->hdr, nidx);
@@ -383,28 +464,32 @@ write_cand(chndl_ctx_t ctx, unsigned int cidx)
 
 	/* set cnt and sta_ts */
 	if (c[0]->sta_ts == 0U) {
-		c[0]->sta_ts = ts - ctx->opts->interval;
+		c[0]->sta_ts = ts - b->interval;
 	}
 	if (c[0]->cnt == 0U) {
-		c[0]->cnt = ctx->bkt->cand[cidx].bcnt;
+		c[0]->cnt = b->cand[cidx].bcnt;
 	}
 	if (c[1]->sta_ts == 0U) {
-		c[1]->sta_ts = ts - ctx->opts->interval;
+		c[1]->sta_ts = ts - b->interval;
 	}
 	if (c[1]->cnt == 0U) {
-		c[1]->cnt = ctx->bkt->cand[cidx].acnt;
+		c[1]->cnt = b->cand[cidx].acnt;
 	}
 
 	/* kick off */
-	ute_add_tick(ctx->wrr, AS_SCOM(c[0]));
-	ute_add_tick(ctx->wrr, AS_SCOM(c[1]));
+	ute_add_tick_idx(b->wrr, AS_SCOM(c[0]), nidx);
+	ute_add_tick_idx(b->wrr, AS_SCOM(c[1]), nidx);
+	/* and pass them on */
+	cascade(ctx, b, cidx, c[0], sta[0]);
+	cascade(ctx, b, cidx, c[1], sta[1]);
 
 check_trades:
 	/* tra candle */
-	if (xcand_trades_p(ctx->bkt->cand + cidx)) {
-		c[2] = ctx->bkt->cand[cidx].tc;
-		nidx = copy_sym(ctx, cidx);
-		ts = get_buckets_time(ctx->bkt);
+	if (xcand_trades_p(b->cand + cidx)) {
+		c[2] = b->cand[cidx].tc;
+		sta[2] = c[2]->sta_ts;
+		nidx = copy_sym(ctx, b, cidx);
+		ts = get_buckets_time(b);
 
 		scom_thdr_set_tblidx(c[2]->hdr, nidx);
 		scom_thdr_set_sec(c[2]->hdr, ts);
@@ -412,65 +497,96 @@ check_trades:
 		scom_thdr_set_ttf(c[2]->hdr, SCDL_FLAVOUR | SL1T_TTF_TRA);
 
 		if (c[2]->sta_ts == 0U) {
-			c[2]->sta_ts = ts - ctx->opts->interval;
+			c[2]->sta_ts = ts - b->interval;
 		}
 		if (c[2]->cnt == 0U) {
-			c[2]->cnt = ctx->bkt->cand[cidx].tcnt;
+			c[2]->cnt = b->cand[cidx].tcnt;
 		}
 
-		ute_add_tick(ctx->wrr, AS_SCOM(c[2]));
+		ute_add_tick_idx(b->wrr, AS_SCOM(c[2]), nidx);
+		cascade(ctx, b, cidx, c[2], sta[2]);
 	}
 	return;
 }
 
 static void
-new_candle(chndl_ctx_t ctx)
+new_candle(chndl_ctx_t ctx, bkts_t b)
 {
 	if (UNLIKELY(ctx->opts->dryp)) {
 		return;
 	}
 
-	/* write all the candshots so far */
-	for (unsigned int i = 0; i <= ctx->bkt->nsyms; i++) {
-		write_cand(ctx, i);
+	/* write all the candshots so far, in symbol order */
+	qsort(b->act, b->nact, sizeof(*b->act), u32cmp);
+	for (uint32_t i = 0U; i < b->nact; i++) {
+		write_cand(ctx, b, b->act[i]);
 	}
 	return;
 }
 
 static void
-check_candle(chndl_ctx_t ctx, scom_t t)
+check_candle(chndl_ctx_t ctx, bkts_t b, scom_t t)
 {
-	if (UNLIKELY(new_candle_p(ctx, t))) {
+	if (UNLIKELY(new_candle_p(b, t))) {
 		time_t tts = scom_thdr_sec(t);
 		time_t new_ts;
 
 		/* print what we've got */
-		new_candle(ctx);
+		new_candle(ctx, b);
 
 		/* determine and implant new bucket time */
-		if (LIKELY(!cdl_snp_p(t) || tts != aligned_stamp(ctx, tts))) {
-			new_ts = next_aligned_stamp(ctx, tts);
+		if (LIKELY(!cdl_snp_p(t) || tts != aligned_stamp(ctx, b, tts))) {
+			new_ts = next_aligned_stamp(ctx, b, tts);
 		} else {
 			/* in the candle/cand case we allow the first time to
 			 * be the bucket time already because they represent
 			 * spans of times already */
 			new_ts = tts;
 		}
-		set_buckets_time(ctx->bkt, new_ts);
+		set_buckets_time(b, new_ts);
 		/* also rinse the buckets */
-		bkts_cleanse(ctx->bkt);
+		bkts_cleanse(b);
 	}
 	return;
 }
 
 static void
-bucketiser(chndl_ctx_t ctx, scom_t t)
+bucketiser(chndl_ctx_t ctx, bkts_t b, unsigned int i, scom_t t)
 {
-	unsigned int i = scom_thdr_tblidx(t);
-	xcand_t b = ctx->bkt->cand + i;
+	xcand_t c = b->cand + i;
+
+	bool freshp;
 
-	check_candle(ctx, t);
-	xcand_push(b, t);
+	check_candle(ctx, b, t);
+	freshp = xcand_untouched_p(c);
+	xcand_push(c, t);
+	if (freshp && !xcand_untouched_p(c)) {
+		/* first quote this interval, remember the symbol */
+		b->act[b->nact++] = i;
+	}
+	return;
+}
+
+static void
+feed(chndl_ctx_t ctx, unsigned int i, scom_t t)
+{
+/* hand T of symbol I to all levels that are built off plain ticks */
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		if (ctx->bkt[k].src < 0) {
+			bucketiser(ctx, ctx->bkt + k, i, t);
+		}
+	}
+	return;
+}
+
+static void
+flush(chndl_ctx_t ctx)
+{
+/* last round, emit what we've got, smaller candles first
+ * as they might complete the bigger ones */
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		new_candle(ctx, ctx->bkt + k);
+	}
 	return;
 }
 
@@ -478,28 +594,75 @@ bucketiser(chndl_ctx_t ctx, scom_t t)
 /* simple bucket sort */
 #include <stdio.h>
 
+static char*
+level_fn(const char *fn, int interval)
+{
+/* FN with the INTERVAL put in front of the .ute suffix, if any */
+	static const char sfx[] = ".ute";
+	size_t fz = strlen(fn);
+	size_t bz = fz + 16U;
+	char *res;
+
+	if (UNLIKELY((res = malloc(bz)) == NULL)) {
+		return NULL;
+	} else if (fz >= sizeof(sfx) - 1U &&
+		   !strcmp(fn + fz - (sizeof(sfx) - 1U), sfx)) {
+		fz -= sizeof(sfx) - 1U;
+	}
+	snprintf(res, bz, "%.*s.%d%s", (int)fz, fn, interval, fn + fz);
+	return res;
+}
+
 static int
-init(chndl_ctx_t ctx, chndl_opt_t opt)
+init(chndl_ctx_t ctx, chndl_opt_t opt, bkts_t bkt)
 {
 	const char *outf = opt->outfile;
+	/* resumed outputs must be there already */
+	const int oflags = opt->resumep ? UO_RDWR : UO_CREAT | UO_TRUNC;
 
 	/* start with a rinse, keep our opts though */
 	memset(ctx, 0, sizeof(*ctx));
 	/* just so we know where our options are */
 	ctx->opts = opt;
+	ctx->bkt = bkt;
+	ctx->nbkt = opt->nintervals;
 
-	if (outf == NULL) {
-		/* what if outfile == infile? */
-		ctx->wrr = ute_mktemp(0);
-
-	} else if (outf[0] == '-' && outf[1] == '\0') {
+	if (outf != NULL && outf[0] == '-' && outf[1] == '\0') {
 		/* bad idea */
-		ctx->wrr = NULL;
 		fputs("This is binary data, cannot dump to stdout\n", stderr);
 		return -1;
-	} else if ((ctx->wrr = ute_open(outf, UO_CREAT | UO_TRUNC)) == NULL) {
-		error("cannot open `%s' for output", outf);
-		return -1;
+	}
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		const int iv = opt->intervals[k];
+
+		bkt[k].interval = iv;
+		/* build off the biggest smaller candles that fit */
+		bkt[k].src = -1;
+		for (size_t j = k; j-- > 0U;) {
+			if (iv % opt->intervals[j] == 0) {
+				bkt[k].src = (int)j;
+				break;
+			}
+		}
+
+		if (outf == NULL) {
+			/* what if outfile == infile? */
+			bkt[k].wrr = ute_mktemp(0);
+		} else if (ctx->nbkt == 1U) {
+			bkt[k].wrr = ute_open(outf, oflags);
+		} else {
+			/* one file per interval */
+			char *fn = level_fn(outf, iv);
+
+			if (fn != NULL) {
+				bkt[k].wrr = ute_open(fn, oflags);
+			}
+			free(fn);
+		}
+		if (bkt[k].wrr == NULL) {
+			error("cannot open `%s' for output", outf);
+			return -1;
+		}
 	}
 	return 0;
 }
@@ -507,68 +670,431 @@ init(chndl_ctx_t ctx, chndl_opt_t opt)
 static void
 deinit(chndl_ctx_t ctx, size_t nsucc)
 {
-	if (ctx->wrr) {
-		/* check if we wrote to a tmp file */
-		if (ctx->opts->outfile == NULL) {
-			const char *fn;
-			if ((fn = ute_fn(ctx->wrr)) && nsucc) {
-				puts(fn);
-			} else if (fn) {
-				(void)unlink(fn);
-			}
-		} else if (!nsucc) {
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		bkts_t b = ctx->bkt + k;
+		const char *fn;
+
+		if (b->wrr == NULL || (fn = ute_fn(b->wrr)) == NULL) {
+			/* closed already */
+			;
+		} else if (!nsucc && !ctx->opts->resumep) {
 			/* better delete the outfile again */
-			(void)unlink(ctx->opts->outfile);
+			(void)unlink(fn);
+		} else if (nsucc &&
+			   (ctx->opts->outfile == NULL || ctx->nbkt > 1U)) {
+			/* we wrote to a tmp file, or to many */
+			puts(fn);
 		}
-		/* writing those ticks to the disk is paramount */
-		ute_close(ctx->wrr);
-	}
-	if (ctx->bkt == NULL) {
-		;
-	} else if (ctx->bkt->cand) {
-		xcand_t cand = ctx->bkt->cand;
-		munmap(cand, (ctx->bkt->nsyms + 1) * sizeof(*cand));
+		if (b->wrr != NULL) {
+			/* writing those ticks to the disk is paramount */
+			ute_close(b->wrr);
+		}
+
+		if (b->cand) {
+			munmap(b->cand, (b->nsyms + 1) * sizeof(*b->cand));
+		}
+		free(b->act);
+		free(b->omap);
 	}
 	return;
 }
 
 static void
-init_buckets(chndl_ctx_t ctx, utectx_t hdl, bkts_t bkt)
+init_buckets(chndl_ctx_t ctx, utectx_t hdl)
 {
 	size_t nsyms_hdl = ute_nsyms(hdl);
-	size_t nsyms_bkt = bkt->nsyms;
 
-	if (nsyms_bkt < nsyms_hdl || (bkt->cand == NULL && nsyms_hdl == 0)) {
-		xcand_t cand = bkt->cand;
-		size_t sz = (nsyms_hdl + 1) * sizeof(*cand);
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		bkts_t bkt = ctx->bkt + k;
+		size_t nsyms_bkt = bkt->nsyms;
 
-		if (cand == NULL) {
-			bkt->cand = mmap(cand, sz, PROT_MEM, MAP_MEM, -1, 0);
-		} else {
-			size_t old = (nsyms_bkt + 1) * sizeof(*cand);
-			bkt->cand = mremap(cand, old, sz, MREMAP_MAYMOVE);
+		if (nsyms_bkt < nsyms_hdl ||
+		    (bkt->cand == NULL && nsyms_hdl == 0)) {
+			xcand_t cand = bkt->cand;
+			size_t sz = (nsyms_hdl + 1) * sizeof(*cand);
+
+			if (cand == NULL) {
+				cand = mmap(cand, sz, PROT_MEM, MAP_MEM, -1, 0);
+			} else {
+				size_t old = (nsyms_bkt + 1) * sizeof(*cand);
+				cand = mremap(cand, old, sz, MREMAP_MAYMOVE);
+			}
+			bkt->cand = cand;
+			sz = (nsyms_hdl + 1) * sizeof(*bkt->act);
+			bkt->act = realloc(bkt->act, sz);
+			bkt->omap = realloc(bkt->omap, sz);
+			bkt->nsyms = nsyms_hdl;
 		}
-		bkt->nsyms = nsyms_hdl;
+		/* scrub the buckets in b thoroughly */
+		bkts_cleanse(bkt);
+		/* symbol indices are per reader */
+		memset(bkt->omap, 0, (bkt->nsyms + 1) * sizeof(*bkt->omap));
 	}
 	/* assign the reader */
 	ctx->rdr = hdl;
-	/* scrub the buckets in b thoroughly */
-	bkts_cleanse(bkt);
-	/* and assign buckets to ctx */
-	ctx->bkt = bkt;
 	return;
 }
 
 static void
 fini_buckets(chndl_ctx_t ctx)
 {
-	if (ctx->bkt) {
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
 		/* reset the bucket time */
-		set_buckets_time(ctx->bkt, 0);
+		set_buckets_time(ctx->bkt + k, 0);
+	}
+	return;
+}
+
+static size_t
+parse_intervals(int *tgt, size_t ntgt, const char *spec)
+{
+/* read comma separated SECS from SPEC into TGT, ascending, no dupes
+ * return the number of intervals or 0 on error */
+	size_t n = 0U;
+
+	for (const char *p = spec; *p;) {
+		char *on;
+		long int iv = strtol(p, &on, 10);
+		size_t j;
+
+		if (on == p || iv <= 0 || iv > INT_MAX || n >= ntgt) {
+			return 0U;
+		}
+		/* insertion sort */
+		for (j = n; j > 0U && tgt[j - 1U] > iv; j--) {
+			tgt[j] = tgt[j - 1U];
+		}
+		if (j > 0U && tgt[j - 1U] == iv) {
+			/* dupe, undo the shift */
+			memmove(tgt + j, tgt + j + 1U, (n - j) * sizeof(*tgt));
+		} else {
+			tgt[j] = (int)iv;
+			n++;
+		}
+		p = on + (*on == ',');
+		if (*on != ',' && *on != '\0') {
+			return 0U;
+		}
+	}
+	return n;
+}
+
+static void
+chndl1(chndl_ctx_t ctx, utectx_t hdl, size_t j, size_t nj)
+{
+/* draw the candles of the J-th of NJ shares of HDL's symbols */
+	const size_t nsyms = ute_nsyms(hdl);
+	const unsigned int from = j ? j * nsyms / nj + 1U : 0U;
+	const unsigned int till = (j + 1U) * nsyms / nj + 1U;
+
+	/* (re)initialise our buckets */
+	init_buckets(ctx, hdl);
+	/* otherwise print all them ticks */
+	for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
+		unsigned int i = ute_tblidx(hdl, ti);
+
+		if (i >= from && i < till) {
+			/* now to what we always do */
+			feed(ctx, i, ti);
+		}
+	}
+	/* last round, just emit what we've got */
+	flush(ctx);
+
+	/* finish our buckets */
+	fini_buckets(ctx);
+	return;
+}
+
+
+/* checkpoints, the open candles of all intervals and the input position
+ * in native format, so that a growing input can be picked up again */
+#define CHST_MAGIC	"UTEchst1"
+
+struct chst_s {
+	char magic[8U];
+	uint32_t nbkt;
+	int32_t offset;
+	uint64_t si;
+	uint64_t nsyms;
+};
+
+struct chst_bkt_s {
+	int32_t interval;
+	uint32_t nact;
+	int64_t cur_ts;
+	/* followed by NACT pairs of symbol index and xcand */
+};
+
+static int
+load_state(chndl_ctx_t ctx, utectx_t hdl)
+{
+	const size_t nsyms = ute_nsyms(hdl);
+	struct chst_s st;
+	FILE *f;
+	int rc = -1;
+
+	if ((f = fopen(ctx->opts->statefile, "rb")) == NULL) {
+		return -1;
+	} else if (fread(&st, sizeof(st), 1U, f) < 1U) {
+		goto out;
+	} else if (memcmp(st.magic, CHST_MAGIC, sizeof(st.magic))) {
+		goto out;
+	} else if (st.nbkt != ctx->nbkt || st.offset != ctx->opts->offset) {
+		/* different options */
+		goto out;
+	} else if (st.nsyms > nsyms) {
+		/* inputs only ever grow */
+		goto out;
+	}
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		bkts_t b = ctx->bkt + k;
+		struct chst_bkt_s sb;
+
+		if (fread(&sb, sizeof(sb), 1U, f) < 1U) {
+			goto out;
+		} else if (sb.interval != b->interval || sb.nact > nsyms + 1U) {
+			goto out;
+		}
+		set_buckets_time(b, sb.cur_ts);
+		for (uint32_t i = 0U; i < sb.nact; i++) {
+			uint32_t idx;
+
+			if (fread(&idx, sizeof(idx), 1U, f) < 1U ||
+			    idx > nsyms ||
+			    !xcand_untouched_p(b->cand + idx) ||
+			    fread(b->cand + idx, sizeof(*b->cand), 1U, f) < 1U) {
+				goto out;
+			}
+			b->act[b->nact++] = idx;
+		}
+	}
+	/* and carry on behind the last tick we've seen */
+	ute_iter_seek(hdl, st.si);
+	rc = 0;
+out:
+	fclose(f);
+	return rc;
+}
+
+static int
+save_state(chndl_ctx_t ctx, utectx_t hdl)
+{
+	const char *sfn = ctx->opts->statefile;
+	struct chst_s st = {
+		.nbkt = ctx->nbkt,
+		.offset = ctx->opts->offset,
+		.si = ute_iter_tell(hdl),
+		.nsyms = ute_nsyms(hdl),
+	};
+	char tmp[PATH_MAX];
+	FILE *f;
+	int rc = 0;
+
+	/* write aside and rename so there's always a usable state */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", sfn);
+	if ((f = fopen(tmp, "wb")) == NULL) {
+		return -1;
+	}
+	memcpy(st.magic, CHST_MAGIC, sizeof(st.magic));
+	fwrite(&st, sizeof(st), 1U, f);
+	for (size_t k = 0U; k < ctx->nbkt; k++) {
+		bkts_t b = ctx->bkt + k;
+		struct chst_bkt_s sb = {
+			.interval = b->interval,
+			.nact = b->nact,
+			.cur_ts = get_buckets_time(b),
+		};
+
+		fwrite(&sb, sizeof(sb), 1U, f);
+		for (uint32_t i = 0U; i < b->nact; i++) {
+			fwrite(b->act + i, sizeof(*b->act), 1U, f);
+			fwrite(b->cand + b->act[i], sizeof(*b->cand), 1U, f);
+		}
+	}
+	if (ferror(f)) {
+		rc = -1;
+	}
+	if (fclose(f) < 0 || rc < 0 || rename(tmp, sfn) < 0) {
+		(void)unlink(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+chndl_resume(chndl_ctx_t ctx, utectx_t hdl)
+{
+/* like chndl1() but pick up the open candles and HDL's position from the
+ * state file, if any, and instead of emitting the open candles put them
+ * back into the state file, unless HDL has stopped growing */
+	const char *sfn = ctx->opts->statefile;
+
+	/* (re)initialise our buckets */
+	init_buckets(ctx, hdl);
+	if (ctx->opts->resumep && load_state(ctx, hdl) < 0) {
+		errno = 0, error("state file `%s' does not match "
+				 "the input or the options", sfn);
+		return 1;
+	}
+	for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
+		feed(ctx, ute_tblidx(hdl, ti), ti);
+	}
+	if (ute_stream_p(hdl)) {
+		/* more to come */
+		if (save_state(ctx, hdl) < 0) {
+			error("cannot write state file `%s'", sfn);
+			return 1;
+		}
+	} else {
+		/* input's complete, so are the candles */
+		flush(ctx);
+		(void)unlink(sfn);
+	}
+	/* finish our buckets */
+	fini_buckets(ctx);
+	return 0;
+}
+
+
+/* parallel candling, every job takes a contiguous share of each file's
+ * symbols into runs of its own, one per interval, then the runs are
+ * merged by time, symbol buckets are independent of one another */
+struct chjob_s {
+	/* set once the runs have been closed */
+	int donep;
+	int rc;
+	size_t nsucc;
+};
+
+static void
+chndl_job(struct chjob_s *jb, char (*fns)[PATH_MAX],
+	  chndl_opt_t opt, char *const *args, size_t nargs, size_t j, size_t nj)
+{
+/* draw the J-th share of candles of files ARGS into temp runs FNS */
+	struct chndl_opt_s jopt = *opt;
+	struct chndl_ctx_s jctx[1U];
+	bkts_t jbkt;
+
+	if (UNLIKELY((jbkt = calloc(opt->nintervals, sizeof(*jbkt))) == NULL)) {
+		jb->rc = 1;
+		return;
+	}
+	jopt.outfile = NULL;
+	if (init(jctx, &jopt, jbkt) < 0) {
+		jb->rc = 1;
+		goto out;
 	}
+	for (size_t i = 0U; i < nargs; i++) {
+		void *hdl;
+
+		if ((hdl = ute_open(args[i], UO_RDONLY)) == NULL) {
+			jb->rc = 2;
+			continue;
+		}
+		chndl1(jctx, hdl, j, nj);
+		ute_close(hdl);
+		jb->nsucc++;
+	}
+	for (size_t k = 0U; k < jctx->nbkt; k++) {
+		strncpy(fns[k], ute_fn(jbkt[k].wrr), sizeof(*fns) - 1U);
+		ute_close(jbkt[k].wrr);
+		jbkt[k].wrr = NULL;
+	}
+	jb->donep = 1;
+out:
+	deinit(jctx, 0U);
+	free(jbkt);
 	return;
 }
 
+static int
+chndl_par(chndl_ctx_t ctx, char *const *args, size_t nargs,
+	  size_t njobs, size_t *nsucc)
+{
+/* candle files ARGS with NJOBS jobs into CTX's writers */
+	const size_t nbkt = ctx->nbkt;
+	struct chjob_s *jobs;
+	char (*fns)[PATH_MAX];
+	char **runs;
+	pid_t *kids;
+	int rc = 0;
+
+	/* results must be visible across the fork()s */
+	jobs = mmap(NULL, njobs * sizeof(*jobs), PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (UNLIKELY(jobs == MAP_FAILED)) {
+		return 1;
+	}
+	fns = mmap(NULL, njobs * nbkt * sizeof(*fns), PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (UNLIKELY(fns == MAP_FAILED)) {
+		munmap(jobs, njobs * sizeof(*jobs));
+		return 1;
+	} else if (UNLIKELY((kids = calloc(njobs, sizeof(*kids))) == NULL)) {
+		rc = 1;
+		goto out;
+	} else if (UNLIKELY((runs = calloc(njobs, sizeof(*runs))) == NULL)) {
+		free(kids);
+		rc = 1;
+		goto out;
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		switch ((kids[j] = fork())) {
+		case -1:
+			/* do it ourselves */
+			kids[j] = 0;
+			chndl_job(jobs + j, fns + j * nbkt,
+				  ctx->opts, args, nargs, j, njobs);
+			break;
+		case 0:
+			chndl_job(jobs + j, fns + j * nbkt,
+				  ctx->opts, args, nargs, j, njobs);
+			_exit(EXIT_SUCCESS);
+		default:
+			break;
+		}
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		if (kids[j] > 0) {
+			while (waitpid(kids[j], NULL, 0) < 0 && errno == EINTR);
+		}
+	}
+	free(kids);
+
+	for (size_t j = 0U; j < njobs; j++) {
+		if (UNLIKELY(!jobs[j].donep)) {
+			errno = 0;
+			error("chndl job %zu died", j);
+			rc = 1;
+		} else if (jobs[j].rc > rc) {
+			rc = jobs[j].rc;
+		}
+	}
+	/* all jobs see the same files */
+	*nsucc = rc != 1 ? jobs->nsucc : 0U;
+	for (size_t k = 0U; k < nbkt; k++) {
+		size_t nruns = 0U;
+
+		for (size_t j = 0U; j < njobs; j++) {
+			if (jobs[j].donep) {
+				runs[nruns++] = fns[j * nbkt + k];
+			}
+		}
+		if (*nsucc && mrg_runs(ctx->bkt[k].wrr, runs, nruns, NULL) < 0) {
+			rc = 1;
+		}
+		for (size_t j = 0U; j < nruns; j++) {
+			(void)unlink(runs[j]);
+		}
+	}
+	free(runs);
+out:
+	munmap(fns, njobs * nbkt * sizeof(*fns));
+	munmap(jobs, njobs * sizeof(*jobs));
+	return rc;
+}
+
 
 #if defined STANDALONE
 #include "ute-chndl.yucc"
@@ -579,8 +1105,10 @@ main(int argc, char *argv[])
 	yuck_t argi[1U];
 	struct chndl_ctx_s ctx[1U] = {{0}};
 	struct chndl_opt_s opt[1U] = {{0}};
-	struct bkts_s bkt[1U] = {{0}};
+	int ivs[32U] = {300};
+	struct bkts_s bkt[countof(ivs)] = {{0}};
 	size_t nsucc = 0U;
+	size_t njobs = 1U;
 	int rc = 0;
 
 	if (yuck_parse(argi, argc, argv)) {
@@ -597,11 +1125,19 @@ main(int argc, char *argv[])
 		opt->z = zif_open(argi->zone_arg);
 	}
 
+	opt->intervals = ivs;
 	if (argi->interval_arg) {
-		opt->interval = strtoul(argi->interval_arg, NULL, 10);
+		opt->nintervals = parse_intervals(
+			ivs, countof(ivs), argi->interval_arg);
+		if (!opt->nintervals) {
+			errno = 0, error("invalid interval `%s'",
+					 argi->interval_arg);
+			rc = 1;
+			goto out;
+		}
 	} else {
 		/* default value */
-		opt->interval = 300;
+		opt->nintervals = 1U;
 	}
 	if (argi->modulus_arg) {
 		opt->offset = strtoul(argi->modulus_arg, NULL, 10);
@@ -610,12 +1146,50 @@ main(int argc, char *argv[])
 		opt->offset = 0;
 	}
 
+	if (argi->jobs_arg) {
+		long int nj = strtol(argi->jobs_arg, NULL, 10);
+
+		if (nj <= 0) {
+			/* use all the cpus */
+			nj = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		njobs = nj > 0 ? (size_t)nj : 1U;
+	}
+	if (argi->state_arg) {
+		if (opt->outfile == NULL || argi->nargs != 1U) {
+			fputs("--state needs an output file "
+			      "and exactly one input file\n", stderr);
+			rc = 1;
+			goto out;
+		}
+		opt->statefile = argi->state_arg;
+		/* append to what the last run left us */
+		opt->resumep = access(opt->statefile, F_OK) == 0;
+		njobs = 1U;
+	}
+
 	/* initialise context */
-	if (init(ctx, opt) < 0) {
+	if (init(ctx, opt, bkt) < 0) {
 		rc = 1;
-		goto out;
+		goto clo;
 	}
 
+	if (opt->statefile != NULL) {
+		void *hdl;
+
+		if ((hdl = ute_open(*argi->args, UO_RDONLY)) == NULL) {
+			rc = 2;
+		} else if ((rc = chndl_resume(ctx, hdl)) == 0) {
+			nsucc++;
+		}
+		if (hdl != NULL) {
+			ute_close(hdl);
+		}
+		goto clo;
+	} else if (njobs > 1U) {
+		rc = chndl_par(ctx, argi->args, argi->nargs, njobs, &nsucc);
+		goto clo;
+	}
 	for (size_t j = 0U; j < argi->nargs; j++) {
 		const char *f = argi->args[j];
 		void *hdl;
@@ -624,23 +1198,13 @@ main(int argc, char *argv[])
 			rc = 2;
 			continue;
 		}
-		/* (re)initialise our buckets */
-		init_buckets(ctx, hdl, bkt);
-		/* otherwise print all them ticks */
-		for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
-			/* now to what we always do */
-			bucketiser(ctx, ti);
-		}
-		/* last round, just emit what we've got */
-		new_candle(ctx);
-
-		/* finish our buckets */
-		fini_buckets(ctx);
+		chndl1(ctx, hdl, 0U, 1U);
 		/* oh right, close the handle */
 		ute_close(hdl);
 		/* count this run as success */
 		nsucc++;
 	}
+clo:
 	/* leave a footer and finish the chndl series */
 	deinit(ctx, nsucc);
 
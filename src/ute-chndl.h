@@ -43,11 +43,11 @@ typedef const struct chndl_opt_s *chndl_opt_t;
 struct chndl_ctx_s {
 	/* contains the currently processed ute file */
 	void *rdr;
-	/* contains the ute output file */
-	void *wrr;
 
-	/* our buckets, defined in the C file */
+	/* our buckets, one per interval, defined in the C file
+	 * each level of buckets comes with its own ute output file */
 	struct bkts_s *bkt;
+	size_t nbkt;
 
 	/* our options */
 	chndl_opt_t opts;
@@ -60,9 +60,16 @@ struct chndl_opt_s {
 	/* time zone info */
 	zif_t z;
 
-	int interval;
+	/* candle lengths in ascending order */
+	const int *intervals;
+	size_t nintervals;
 	int offset;
 	int dryp;
+
+	/* checkpoint file to resume from and leave the open candles in */
+	const char *statefile;
+	/* whether the outputs are to be appended to */
+	int resumep;
 };
 
 #endif	/* INCLUDED_ute_chndl_h_ */
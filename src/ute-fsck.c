@@ -44,7 +44,10 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #if defined(HAVE_FUTIMES) || defined(HAVE_FUTIMESAT) || defined(HAVE_UTIMES)
 # include <sys/time.h>
 #elif defined(HAVE_UTIME)
@@ -66,6 +69,9 @@
 #if !defined countof
 # define countof(x)	(sizeof(x) / sizeof(*x))
 #endif	/* !countof */
+#if !defined MAP_ANONYMOUS && defined MAP_ANON
+# define MAP_ANONYMOUS	(MAP_ANON)
+#endif	/* !MAP_ANONYMOUS && MAP_ANON */
 
 /* one day verbpr() might become --verbose */
 #if defined DEBUG_FLAG
@@ -88,6 +94,8 @@ struct fsck_ctx_s {
 	bool a_dryp:1;
 	/* compress or decompress using temporaries */
 	bool zp:1;
+	/* number of verifiers to run in parallel */
+	size_t njobs;
 	ute_end_t tgtend;
 	ute_end_t natend;
 	utectx_t outctx;
@@ -145,14 +153,11 @@ conv_1_swap(scom_thdr_t ti, size_t tz)
 }
 
 static void
-__addconv_tick(utectx_t hdl, scom_t si, size_t tbsz)
+__conv_tick(uint32_t *restrict tgt_sndwch, const uint32_t *src_sndwch, size_t tbsz)
 {
-/* do a conversion and then add the tick */
-	uint32_t ALGN(ti[16], sizeof(uint64_t));
-	const uint32_t *src_sndwch = (const uint32_t*)si;
-	const uint64_t *src_sndw64 = (const uint64_t*)si;
-	uint32_t *tgt_sndwch = (uint32_t*)ti;
-	uint64_t *tgt_sndw64 = (uint64_t*)ti;
+/* convert the tick in SRC_SNDWCH to opposite endianness into TGT_SNDWCH */
+	const uint64_t *src_sndw64 = (const uint64_t*)src_sndwch;
+	uint64_t *tgt_sndw64 = (uint64_t*)tgt_sndwch;
 
 	/* header is always 64b */
 	tgt_sndw64[0] = swap64(src_sndw64[0]);
@@ -177,17 +182,58 @@ __addconv_tick(utectx_t hdl, scom_t si, size_t tbsz)
 	default:
 		break;
 	}
+	return;
+}
+
+static void
+__addconv_tick(utectx_t hdl, scom_t si, size_t tbsz)
+{
+/* do a conversion and then add the tick */
+	uint32_t ALGN(ti[16], sizeof(uint64_t));
+	const uint32_t *src_sndwch = (const uint32_t*)si;
+	uint64_t x = swap64(si->u);
+
+	if (UNLIKELY(scom_thdr_widx_p(AS_SCOM(&x)))) {
+		/* convert the tick proper, add it under its wide index */
+		unsigned int idx = swap32(src_sndwch[2]);
+
+		__conv_tick(ti, src_sndwch + 4U, tbsz - 1U);
+		ute_add_tick_idx(hdl, AS_SCOM(ti), idx);
+		return;
+	}
+	__conv_tick(ti, src_sndwch, tbsz);
 	ute_add_tick(hdl, AS_SCOM(ti));
 	return;
 }
 
-
+static size_t
+fsck_tick_size(scom_t ti, bool same_end_p)
+{
+/* like scom_tick_size() but for ticks of either endianness */
+	uint64_t x = same_end_p ? ti->u : swap64(ti->u);
+
+	if (UNLIKELY(scom_thdr_widx_p(AS_SCOM(&x)))) {
+		scom_t nx = scom_widx_tick(ti);
+		uint64_t y = same_end_p ? nx->u : swap64(nx->u);
+
+		if (UNLIKELY(scom_thdr_widx_p(AS_SCOM(&y)))) {
+			/* stray wide index */
+			return 1U;
+		}
+		return 1U + scom_tick_size(AS_SCOM(&y));
+	}
+	return scom_tick_size(AS_SCOM(&x));
+}
+
+
 /* page wise operations */
 enum {
 	ISS_NO_ISSUES = 0,
 	ISS_OLD_VER = 1,
 	ISS_UNSORTED = 2,
 	ISS_NO_ENDIAN = 4,
+	ISS_CSUM = 8,
+	ISS_CORRUPT = 16,
 };
 
 /* the actual fscking */
@@ -230,7 +276,7 @@ fsckp(fsck_ctx_t ctx, uteseek_t sk, utectx_t hdl, int old_iss, scidx_t last)
 		}
 
 		/* determine the length for the increment */
-		tsz = scom_byte_size(AS_SCOM(&x));
+		tsz = fsck_tick_size(ti, same_end_p) * ssz;
 
 		/* check for sortedness */
 		if (last.u > x) {
@@ -262,6 +308,155 @@ fsckp(fsck_ctx_t ctx, uteseek_t sk, utectx_t hdl, int old_iss, scidx_t last)
 	return issues;
 }
 
+/* verification results, one per page */
+struct vrfy_s {
+	/* smallest and largest key on the page */
+	uint64_t lo;
+	uint64_t hi;
+	/* issues found on the page */
+	int iss;
+	/* whether the page has been looked at */
+	bool donep;
+};
+
+static void
+vrfyp(struct vrfy_s *restrict res, utectx_t hdl, uint32_t pg)
+{
+/* check page PG's checksum and the order of its ticks, read-only */
+	const bool same_end_p = ute_check_endianness(hdl) == 0;
+	const uint32_t *sum;
+	struct uteseek_s sk[1];
+	size_t nsk;
+
+	res->lo = res->hi = 0U;
+	res->iss = ISS_NO_ISSUES;
+	res->donep = true;
+	if ((sum = page_csum(hdl, pg)) != NULL) {
+		uint32_t crc;
+
+		if (page_crc(&crc, hdl, pg) < 0 || crc != *sum) {
+			/* don't bother looking at the ticks */
+			res->iss |= ISS_CSUM;
+			return;
+		}
+	}
+	if (UNLIKELY(seek_page(sk, hdl, pg) < 0)) {
+		res->iss |= ISS_CORRUPT;
+		return;
+	}
+	nsk = seek_byte_size(sk) / sizeof(*sk->sp);
+	for (size_t i = sk->si, tsz; i < nsk; i += tsz) {
+		scom_t ti = AS_SCOM(sk->sp + i);
+		uint64_t x = same_end_p ? ti->u : swap64(ti->u);
+
+		tsz = fsck_tick_size(ti, same_end_p);
+		if (UNLIKELY(!x || i + tsz > nsk)) {
+			res->iss |= ISS_CORRUPT;
+			break;
+		} else if (UNLIKELY(x < res->hi)) {
+			res->iss |= ISS_UNSORTED;
+		}
+		if (UNLIKELY(!res->lo)) {
+			res->lo = x;
+		}
+		res->hi = x;
+	}
+	flush_seek(sk);
+	return;
+}
+
+static void
+vrfy_range(struct vrfy_s *res, utectx_t hdl, size_t from, size_t till)
+{
+	for (size_t p = from; p < till; p++) {
+		vrfyp(res + p, hdl, p);
+	}
+	return;
+}
+
+static int
+vrfy1(fsck_ctx_t ctx, utectx_t hdl, const char *fn)
+{
+/* verify all pages of HDL, NJOBS contiguous page ranges at a time */
+	const size_t npg = ute_npages(hdl);
+	size_t nj = ctx->njobs < npg ? ctx->njobs : npg;
+	struct vrfy_s *v;
+	pid_t *kids;
+	int issues = 0;
+
+	if (UNLIKELY(npg == 0U)) {
+		return 0;
+	} else if (hdl->pgs->s == NULL && ctx->verbp) {
+		fprintf(stderr, "file `%s' has no page checksums\n", fn);
+	}
+	/* results must be visible across the fork()s */
+	v = mmap(NULL, npg * sizeof(*v), PROT_READ | PROT_WRITE,
+		 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (UNLIKELY(v == MAP_FAILED)) {
+		error("cannot verify file `%s'", fn);
+		return -1;
+	}
+	if (UNLIKELY((kids = calloc(nj, sizeof(*kids))) == NULL)) {
+		/* do it all ourselves then */
+		nj = 1U;
+	}
+	for (size_t j = 1U; j < nj; j++) {
+		const size_t from = j * npg / nj;
+		const size_t till = (j + 1U) * npg / nj;
+
+		switch ((kids[j] = fork())) {
+		case -1:
+			/* do it ourselves */
+			kids[j] = 0;
+			vrfy_range(v, hdl, from, till);
+			break;
+		case 0:
+			vrfy_range(v, hdl, from, till);
+			_exit(EXIT_SUCCESS);
+		default:
+			break;
+		}
+	}
+	/* our share */
+	vrfy_range(v, hdl, 0U, npg / nj);
+	for (size_t j = 1U; j < nj; j++) {
+		if (kids[j] > 0) {
+			while (waitpid(kids[j], NULL, 0) < 0 && errno == EINTR);
+		}
+	}
+	free(kids);
+
+	/* collect the results, in page order */
+	for (size_t p = 0U; p < npg; p++) {
+		int iss = v[p].iss;
+
+		if (UNLIKELY(!v[p].donep)) {
+			/* verifier died on us */
+			iss |= ISS_CORRUPT;
+		} else if (p && !(iss | v[p - 1U].iss) &&
+			   v[p].lo < v[p - 1U].hi) {
+			/* pages overlap */
+			iss |= ISS_UNSORTED;
+		}
+		if (ctx->verbp) {
+			fprintf(stderr, "page %zu ...\n", p);
+		}
+		if (iss & ISS_CSUM) {
+			printf("file `%s' page %zu checksum mismatch ...\n",
+			       fn, p);
+		}
+		if (iss & ISS_CORRUPT) {
+			printf("file `%s' page %zu is corrupt ...\n", fn, p);
+		}
+		if (iss & ISS_UNSORTED) {
+			printf("file `%s' page %zu needs sorting ...\n", fn, p);
+		}
+		issues |= iss;
+	}
+	munmap(v, npg * sizeof(*v));
+	return issues;
+}
+
 static void
 conv_sk_swap(fsck_ctx_t ctx, uteseek_t sk, bool src_is_native_endian_p)
 {
@@ -276,10 +471,12 @@ conv_sk_swap(fsck_ctx_t ctx, uteseek_t sk, bool src_is_native_endian_p)
 		scom_thdr_t ti = AS_SCOM_THDR(sp);
 		size_t tz;
 
-		if (src_is_native_endian_p) {
-			tz = scom_tick_size(ti);
+		uint64_t x = src_is_native_endian_p ? ti->u : swap64(ti->u);
+
+		if (UNLIKELY(scom_thdr_widx_p(AS_SCOM(&x)))) {
+			/* wide index sandwiches are converted on their own */
+			tz = 1U;
 		} else {
-			uint64_t x = swap64(ti->u);
 			tz = scom_tick_size(AS_SCOM(&x));
 		}
 
@@ -497,6 +694,13 @@ ute_decompress(utectx_t hdl)
 }
 #endif	/* HAVE_LZMA_H */
 
+static void
+ute_checksum(utectx_t hdl)
+{
+	hdl->hdrc->flags |= UTEHDR_FLAG_CHECKSUM;
+	return;
+}
+
 static int
 file_flags(fsck_ctx_t ctx, const char *fn)
 {
@@ -656,6 +860,35 @@ main(int argc, char *argv[])
 		ctx->tgtend = ctx->natend;
 	}
 
+	if (argi->verify_flag) {
+		/* verify only, no changes, no conversions */
+		ctx->njobs = 1U;
+		if (argi->jobs_arg) {
+			long int nj = strtol(argi->jobs_arg, NULL, 10);
+
+			if (nj <= 0) {
+				/* use all the cpus */
+				nj = sysconf(_SC_NPROCESSORS_ONLN);
+			}
+			ctx->njobs = nj > 0 ? (size_t)nj : 1U;
+		}
+		for (size_t j = 0U; j < argi->nargs; j++) {
+			const char *fn = argi->args[j];
+			const int fl = UO_RDONLY | UO_NO_LOAD_TPC;
+			utectx_t hdl;
+
+			if (UNLIKELY((hdl = ute_open(fn, fl)) == NULL)) {
+				error("cannot open file `%s'", fn);
+				rc = 1;
+				continue;
+			} else if (vrfy1(ctx, hdl, fn)) {
+				rc = 1;
+			}
+			ute_close(hdl);
+		}
+		goto out;
+	}
+
 	/* set the comprcsion level in either case */
 	if (argi->compression_level_arg) {
 		ute_encode_clevel =
@@ -673,6 +906,8 @@ main(int argc, char *argv[])
 			error("cannot open output file `%s'", fn);
 			rc = 1;
 			goto out;
+		} else if (argi->checksum_flag) {
+			ute_checksum(ctx->outctx);
 		}
 	}
 
@@ -754,6 +989,9 @@ cannot convert file with issues `%s', rerun conversion later", fn);
 		/* safe than sorry */
 		if (ctx->outctx != NULL) {
 			ute_clone_slut(ctx->outctx, hdl);
+			/* checksummed files stay checksummed */
+			ctx->outctx->hdrc->flags |=
+				hdl->hdrc->flags & UTEHDR_FLAG_CHECKSUM;
 		} else if (ctx->dryp) {
 			/* do fuckall in dry mode */
 			;
@@ -766,6 +1004,9 @@ cannot convert file with issues `%s', rerun conversion later", fn);
 			} else if (argi->decompress_flag) {
 				ute_decompress(hdl);
 			}
+			if (argi->checksum_flag) {
+				ute_checksum(hdl);
+			}
 		}
 
 		/* and that's us */
@@ -783,6 +1024,9 @@ cannot convert file with issues `%s', rerun conversion later", fn);
 			} else if (argi->decompress_flag) {
 				ute_decompress(ctx->outctx);
 			}
+			if (argi->checksum_flag) {
+				ute_checksum(ctx->outctx);
+			}
 
 			/* store timestamps in question for later use */
 			if (UNLIKELY(stat(fn, &st) < 0)) {
@@ -524,7 +524,7 @@ out:
 static int
 mark(info_ctx_t ctx, scom_t ti)
 {
-	unsigned int tidx = scom_thdr_tblidx(ti);
+	unsigned int tidx = ute_tblidx(ctx->u, ti);
 	unsigned int ttf = scom_thdr_ttf(ti);
 
 	if (ctx->intv && UNLIKELY(check_stmp(ctx, ti))) {
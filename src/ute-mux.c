@@ -47,47 +47,73 @@
 #include <math.h>
 #include <limits.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include "module.h"
 #include "nifty.h"
 
 #include "utefile-private.h"
 #include "ute-mux.h"
+#include "prchunk.h"
 #include "cmd-aux.c"
+#include "cmd-mrg.c"
 
 #if !defined _INDEXT
 # define _INDEXT
 typedef size_t index_t;
 #endif	/* !_INDEXT */
 
-typedef uint_fast16_t slutlut_t[65536U];
+typedef struct slutlut_s *slutlut_t;
+
+struct slutlut_s {
+	size_t nsyms;
+	uint_fast32_t *x;
+};
+
 
-
 #define scom_scom_size(t)	(scom_byte_size(t) / sizeof(*t))
 
 static bool
-build_slutlut(slutlut_t x, utectx_t tgt, utectx_t src)
+build_slutlut(slutlut_t lut, utectx_t tgt, utectx_t src)
 {
 /* build a slut look-up table, to transition tblidxs from SRC to TGT. */
 	const size_t src_nsyms = ute_nsyms(src);
 	bool compatp = true;
 
+	if (src_nsyms > lut->nsyms || lut->x == NULL) {
+		/* make room for the indices of SRC and the 0-th one */
+		lut->x = realloc(lut->x, (src_nsyms + 1U) * sizeof(*lut->x));
+	}
+	lut->nsyms = src_nsyms;
+	lut->x[0U] = 0U;
 	for (size_t i = 1UL; i <= src_nsyms; i++) {
 		const char *sym = ute_idx2sym(src, i);
 
 		if (UNLIKELY(sym == NULL)) {
 			/* huh? */
-			x[i] = 0U;
+			lut->x[i] = 0U;
 			compatp = false;
-		} else if ((x[i] = ute_sym2idx(tgt, sym)) != i) {
+		} else if ((lut->x[i] = ute_sym2idx(tgt, sym)) != i) {
 			/* not coinciding */
 			compatp = false;
 		}
 	}
-	/* wipe the rest? */
-	memset(x + src_nsyms + 1U, 0, (65536U - (src_nsyms + 1U)) * sizeof(*x));
 	return compatp;
 }
 
+static void
+free_slutlut(slutlut_t lut)
+{
+	if (lut->x != NULL) {
+		free(lut->x);
+		lut->x = NULL;
+	}
+	lut->nsyms = 0U;
+	return;
+}
+
 static void
 add_ticks(utectx_t tgt, const void *t, size_t z)
 {
@@ -99,15 +125,21 @@ add_ticks(utectx_t tgt, const void *t, size_t z)
 }
 
 static void
-add_ticks_trnsl(utectx_t tgt, const void *t, size_t z, slutlut_t x)
+add_ticks_trnsl(utectx_t tgt, const void *t, size_t z, slutlut_t lut)
 {
-	scidx_t cch[1];
-
 	for (scom_t tp = t, et = tp + z / sizeof(*tp);
 	     tp < et; tp += scom_scom_size(tp)) {
-		*cch = *AS_SCOM(tp);
-		scom_thdr_set_tblidx(cch, x[scom_thdr_tblidx(tp)]);
-		ute_add_tick_as(tgt, tp, cch);
+		unsigned int idx;
+
+		if (UNLIKELY(scom_thdr_widx_p(tp))) {
+			idx = scom_widx(tp);
+		} else {
+			idx = scom_thdr_tblidx(tp);
+		}
+		if (UNLIKELY(idx > lut->nsyms)) {
+			idx = 0U;
+		}
+		ute_add_tick_idx(tgt, tp, lut->x[idx]);
 	}
 	return;
 }
@@ -119,7 +151,7 @@ add_ticks_trnsl(utectx_t tgt, const void *t, size_t z, slutlut_t x)
 static void
 ute_mux(mux_ctx_t ctx)
 {
-	static uint_fast16_t stt[65536U];
+	struct slutlut_s stt[1] = {{0U}};
 	const int fl = UO_RDONLY;
 	const char *fn = ctx->infn;
 	bool compatp = true;
@@ -155,28 +187,56 @@ ute_mux(mux_ctx_t ctx)
 
 	/* and off we are */
 	ute_close(hdl);
+	free_slutlut(stt);
 	return;
 }
 
 
+static void
+mrg_keepidx(unsigned int *omap, utectx_t tgt, utectx_t src)
+{
+/* like build_slutlut() but keep SRC's indices where TGT has them free,
+ * runs cut from files with explicit indices (uta) then merge into the
+ * indices a serial mux would have banged, dense runs append as usual */
+	const size_t src_nsyms = ute_nsyms(src);
+
+	for (size_t i = 1UL; i <= src_nsyms; i++) {
+		const char *sym = ute_idx2sym(src, i);
+		const char *tsym;
+
+		if (sym == NULL || *sym == '\0') {
+			/* hole in SRC's slut */
+			omap[i] = 0U;
+		} else if ((tsym = ute_idx2sym(tgt, i)) == NULL || !*tsym) {
+			omap[i] = ute_bang_symidx(tgt, sym, i);
+		} else {
+			omap[i] = ute_sym2idx(tgt, sym);
+		}
+	}
+	return;
+}
+
+
 static ute_dso_t mux_dso;
 
 struct muxer_s {
 	void(*muxf)(mux_ctx_t);
 	int(*mux_main_f)(mux_ctx_t, int, char*[]);
+	/* whether input files may be cut at line boundaries */
+	bool linewisep;
 };
 
 static struct muxer_s
 find_muxer(const char *opt)
 {
-	struct muxer_s res = {NULL, NULL};
+	struct muxer_s res = {NULL, NULL, false};
 	ute_dso_sym_t sym;
 
 	if (opt == NULL) {
 		/* ah, default muxer is ute himself */
-		return (struct muxer_s){ute_mux, NULL};
+		return (struct muxer_s){ute_mux, NULL, false};
 	} else if ((mux_dso = open_aux(opt)) == NULL) {
-		return (struct muxer_s){NULL, NULL};
+		return (struct muxer_s){NULL, NULL, false};
 	}
 	/* try and resolve at least the mux symbol */
 	if ((sym = find_sym(mux_dso, "mux")) != NULL) {
@@ -185,6 +245,9 @@ find_muxer(const char *opt)
 	if ((sym = find_sym(mux_dso, "mux_main")) != NULL) {
 		res.mux_main_f = (int(*)())sym;
 	}
+	if ((sym = find_sym(mux_dso, "mux_linewise")) != NULL) {
+		res.linewisep = true;
+	}
 	return res;
 }
 
@@ -232,6 +295,349 @@ print_muxers(void)
 }
 
 
+/* input files or parts thereof */
+struct mxseg_s {
+	char *fn;
+	/* byte range, LEN < 0 means the whole file */
+	off_t off;
+	off_t len;
+};
+
+static void
+feed_seg(int tgt, int fd, off_t off, off_t len)
+{
+/* copy LEN bytes from FD at offset OFF to TGT */
+	static char buf[65536U];
+
+	while (len > 0) {
+		const size_t nrq = len < (off_t)sizeof(buf)
+			? (size_t)len : sizeof(buf);
+		ssize_t nrd;
+
+		if ((nrd = pread(fd, buf, nrq, off)) <= 0) {
+			break;
+		}
+		for (ssize_t nwr = 0, tot = 0; tot < nrd; tot += nwr) {
+			if ((nwr = write(tgt, buf + tot, nrd - tot)) < 0) {
+				return;
+			}
+		}
+		off += nrd;
+		len -= nrd;
+	}
+	return;
+}
+
+static int
+mux1(mux_ctx_t ctx, struct muxer_s mxer, const struct mxseg_s *s)
+{
+/* mux segment S (or stdin if its file is `-') into CTX's writer */
+	const char *f = s->fn;
+	pid_t feeder = 0;
+	int fd;
+
+	/* open the infile ... */
+	if (f[0] == '-' && f[1] == '\0') {
+		ctx->infd = fd = STDIN_FILENO;
+		ctx->infn = NULL;
+		ctx->badfd = STDERR_FILENO;
+	} else if ((fd = open(f, 0)) >= 0) {
+		ctx->infd = fd;
+		ctx->infn = f;
+		ctx->badfd = STDERR_FILENO;
+	} else {
+		error("cannot open file `%s'", f);
+		return -1;
+	}
+	if (s->len >= 0) {
+		/* muxers want a descriptor, so pipe the segment through */
+		int pp[2];
+
+		if (pipe(pp) < 0) {
+			error("cannot mux file `%s'", f);
+			close(fd);
+			return -1;
+		}
+		switch ((feeder = fork())) {
+		case -1:
+			error("cannot mux file `%s'", f);
+			close(pp[0]);
+			close(pp[1]);
+			close(fd);
+			return -1;
+		case 0:
+			close(pp[0]);
+			feed_seg(pp[1], fd, s->off, s->len);
+			_exit(EXIT_SUCCESS);
+		default:
+			close(pp[1]);
+			close(fd);
+			ctx->infd = fd = pp[0];
+			break;
+		}
+	}
+	/* ... and now mux it */
+	mxer.muxf(ctx);
+	/* close the infile */
+	close(fd);
+	if (feeder > 0) {
+		while (waitpid(feeder, NULL, 0) < 0 && errno == EINTR);
+	}
+	return 0;
+}
+
+static size_t
+cut_file(struct mxseg_s *tgt, char *fn, off_t fsz, size_t n)
+{
+/* cut FN of size FSZ into at most N segments at line boundaries */
+	char buf[4096U];
+	size_t res = 0U;
+	off_t last = 0;
+	ssize_t nrd;
+	int fd;
+
+	if (n <= 1U || (fd = open(fn, O_RDONLY)) < 0) {
+		tgt[0U] = (struct mxseg_s){fn, 0, -1};
+		return 1U;
+	} else if ((nrd = pread(fd, buf, 16U, 0)) > 0 &&
+		   prchunk_zipp(buf, nrd)) {
+		/* compressed files can't be cut */
+		tgt[0U] = (struct mxseg_s){fn, 0, -1};
+		close(fd);
+		return 1U;
+	}
+	for (size_t i = 1U; i < n; i++) {
+		off_t cut = (off_t)(i * fsz / n);
+
+		if (cut <= last) {
+			continue;
+		}
+		/* go to the beginning of the next line */
+		for (; (nrd = pread(fd, buf, sizeof(buf), cut)) > 0; cut += nrd) {
+			const char *eol = memchr(buf, '\n', nrd);
+
+			if (eol != NULL) {
+				cut += eol - buf + 1;
+				break;
+			}
+		}
+		if (nrd <= 0 || cut >= fsz) {
+			/* last line goes to the final segment */
+			break;
+		}
+		tgt[res++] = (struct mxseg_s){fn, last, cut - last};
+		last = cut;
+	}
+	tgt[res++] = (struct mxseg_s){fn, last, fsz - last};
+	close(fd);
+	return res;
+}
+
+
+/* parallel muxing, every job muxes a contiguous share of the segments
+ * into a run of its own, closing sorts the run, then the runs are merged */
+struct mxjob_s {
+	/* set once the run has been closed */
+	int donep;
+	int rc;
+	size_t nsucc;
+	char fn[PATH_MAX];
+};
+
+static void
+mux_job(struct mxjob_s *j, const struct mux_ctx_s *ctx, struct muxer_s mxer,
+	char *const *args, size_t nargs, const struct mxseg_s *segs, size_t nsegs)
+{
+/* mux segments SEGS into a fresh temp run, mux_main() style muxers are
+ * passed the option arguments ARGS first and the (whole) files then */
+	static char prog[] = "mux";
+	struct mux_ctx_s jctx = *ctx;
+	utectx_t run;
+
+	if ((run = ute_mktemp(0)) == NULL) {
+		error("cannot create intermediate file");
+		j->rc = 1;
+		return;
+	}
+	jctx.wrr = run;
+	if (mxer.mux_main_f != NULL) {
+		char **argv = calloc(nargs + nsegs + 2U, sizeof(*argv));
+
+		if (UNLIKELY(argv == NULL)) {
+			j->rc = 1;
+		} else {
+			argv[0U] = prog;
+			memcpy(argv + 1U, args, nargs * sizeof(*args));
+			for (size_t i = 0U; i < nsegs; i++) {
+				argv[1U + nargs + i] = segs[i].fn;
+			}
+			j->rc = mxer.mux_main_f(&jctx, nargs + nsegs + 1U, argv);
+			j->nsucc = 1U;
+			free(argv);
+		}
+	} else {
+		for (size_t i = 0U; i < nsegs; i++) {
+			if (mux1(&jctx, mxer, segs + i) < 0) {
+				j->rc = 2;
+				continue;
+			} else if (segs[i].off == 0) {
+				/* count files, not segments */
+				j->nsucc++;
+			}
+		}
+	}
+	if (jctx.wrr != NULL) {
+		/* muxers might decide against ute output altogether */
+		strncpy(j->fn, ute_fn(jctx.wrr), sizeof(j->fn) - 1U);
+		ute_close(jctx.wrr);
+	}
+	j->donep = 1;
+	return;
+}
+
+static size_t
+mk_segs(struct mxseg_s *tgt, char *const *fns, size_t nfns,
+	struct muxer_s mxer, size_t njobs)
+{
+/* turn files FNS into segments, for line-wise muxers cut the regular ones
+ * so that there's about NJOBS segments in total, sizes permitting */
+	struct stat st;
+	off_t *fsz;
+	off_t tot = 0;
+	size_t res = 0U;
+
+	if (!mxer.linewisep || (fsz = calloc(nfns, sizeof(*fsz))) == NULL) {
+		for (size_t i = 0U; i < nfns; i++) {
+			tgt[i] = (struct mxseg_s){fns[i], 0, -1};
+		}
+		return nfns;
+	}
+	for (size_t i = 0U; i < nfns; i++) {
+		if (stat(fns[i], &st) == 0 && S_ISREG(st.st_mode)) {
+			tot += fsz[i] = st.st_size;
+		}
+	}
+	for (size_t i = 0U; i < nfns; i++) {
+		/* the bigger the file the more segments */
+		size_t n = tot > 0 ? (size_t)(fsz[i] * njobs / tot) : 0U;
+
+		res += cut_file(tgt + res, fns[i], fsz[i], n ?: 1U);
+	}
+	free(fsz);
+	return res;
+}
+
+static int
+mux_par(mux_ctx_t ctx, struct muxer_s mxer, char *const *args, size_t nargs,
+	size_t njobs, size_t *nsucc)
+{
+/* mux the files among ARGS with NJOBS jobs, return the exit code */
+	struct mxseg_s *segs;
+	char **fns;
+	char **opts;
+	size_t nfns = 0U;
+	size_t nopts = 0U;
+	size_t nsegs;
+	struct mxjob_s *jobs;
+	pid_t *kids;
+	int rc = 0;
+
+	/* FNS is reused for the run names later on */
+	if (UNLIKELY((fns = calloc(nargs + njobs, sizeof(*fns))) == NULL)) {
+		return 1;
+	} else if (UNLIKELY((opts = calloc(nargs, sizeof(*opts))) == NULL)) {
+		free(fns);
+		return 1;
+	} else if (UNLIKELY((segs = calloc(
+				     nargs + njobs, sizeof(*segs))) == NULL)) {
+		free(opts);
+		free(fns);
+		return 1;
+	}
+	/* option args go to every job, the rest is files */
+	for (size_t i = 0U; i < nargs; i++) {
+		if (args[i][0U] == '-') {
+			opts[nopts++] = args[i];
+		} else {
+			fns[nfns++] = args[i];
+		}
+	}
+	nsegs = mk_segs(segs, fns, nfns, mxer, njobs);
+	if (njobs > nsegs) {
+		njobs = nsegs;
+	}
+	/* results must be visible across the fork()s */
+	jobs = mmap(NULL, njobs * sizeof(*jobs), PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (UNLIKELY(jobs == MAP_FAILED)) {
+		rc = 1;
+		goto out;
+	} else if (UNLIKELY((kids = calloc(njobs, sizeof(*kids))) == NULL)) {
+		munmap(jobs, njobs * sizeof(*jobs));
+		rc = 1;
+		goto out;
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		const size_t from = j * nsegs / njobs;
+		const size_t till = (j + 1U) * nsegs / njobs;
+		const struct mxseg_s *jsegs = segs + from;
+
+		switch ((kids[j] = fork())) {
+		case -1:
+			/* do it ourselves */
+			kids[j] = 0;
+			mux_job(jobs + j, ctx, mxer,
+				opts, nopts, jsegs, till - from);
+			break;
+		case 0:
+			mux_job(jobs + j, ctx, mxer,
+				opts, nopts, jsegs, till - from);
+			_exit(EXIT_SUCCESS);
+		default:
+			break;
+		}
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		if (kids[j] > 0) {
+			while (waitpid(kids[j], NULL, 0) < 0 && errno == EINTR);
+		}
+	}
+	free(kids);
+
+	/* collect the runs, in file order */
+	with (char **runs = fns) {
+		size_t nruns = 0U;
+
+		for (size_t j = 0U; j < njobs; j++) {
+			if (UNLIKELY(!jobs[j].donep)) {
+				errno = 0;
+				error("mux job %zu died", j);
+				rc = 1;
+				continue;
+			} else if (jobs[j].rc > rc) {
+				rc = jobs[j].rc;
+			}
+			*nsucc += jobs[j].nsucc;
+			if (*jobs[j].fn) {
+				runs[nruns++] = jobs[j].fn;
+			}
+		}
+		if (ctx->wrr != NULL && mrg_runs(ctx->wrr, runs, nruns, mrg_keepidx) < 0) {
+			rc = 1;
+		}
+		for (size_t j = 0U; j < nruns; j++) {
+			(void)unlink(runs[j]);
+		}
+	}
+	munmap(jobs, njobs * sizeof(*jobs));
+out:
+	free(segs);
+	free(opts);
+	free(fns);
+	return rc;
+}
+
+
 static int
 init_ticks(mux_ctx_t ctx, sumux_opt_t opts)
 {
@@ -309,6 +715,7 @@ main(int argc, char *argv[])
 	struct muxer_s mxer;
 	int muxer_specific_options_p = 0;
 	size_t nsucc = 0U;
+	size_t njobs = 1U;
 	int rc = 0;
 
 	if (yuck_parse(argi, argc, argv)) {
@@ -395,34 +802,39 @@ muxer specific options given but cannot find muxer\n", stderr);
 		rc = 1;
 		goto out;
 	}
-	/* prefer the fully fledged version */
-	if (mxer.mux_main_f != NULL) {
+	if (argi->jobs_arg) {
+		long int nj = strtol(argi->jobs_arg, NULL, 10);
+
+		if (nj <= 0) {
+			/* use all the cpus */
+			nj = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		njobs = nj > 0 ? (size_t)nj : 1U;
+	}
+	for (size_t j = 0; j < argi->nargs; j++) {
+		const char *f = argi->args[j];
+
+		if (f[0] == '-' && f[1] == '\0') {
+			/* stdin can't be shared out */
+			njobs = 1U;
+		}
+	}
+
+	if (njobs > 1U && (argi->nargs > 1U || mxer.linewisep)) {
+		rc = mux_par(ctx, mxer, argi->args, argi->nargs, njobs, &nsucc);
+	} else if (mxer.mux_main_f != NULL) {
+		/* prefer the fully fledged version */
 		rc = mxer.mux_main_f(ctx, argi->nargs + 1U, argi->args - 1);
 		nsucc++;
 	} else {
 		for (size_t j = 0; j < argi->nargs; j++) {
-			const char *f = argi->args[j];
-			int fd;
-
-			/* open the infile ... */
-			if (f[0] == '-' && f[1] == '\0') {
-				ctx->infd = fd = STDIN_FILENO;
-				ctx->infn = NULL;
-				ctx->badfd = STDERR_FILENO;
-			} else if ((fd = open(f, 0)) >= 0) {
-				ctx->infd = fd;
-				ctx->infn = f;
-				ctx->badfd = STDERR_FILENO;
-			} else {
-				error("cannot open file `%s'", f);
+			const struct mxseg_s s = {argi->args[j], 0, -1};
+
+			if (mux1(ctx, mxer, &s) < 0) {
 				rc = 2;
 				/* just try the next bloke */
 				continue;
 			}
-			/* ... and now mux it */
-			mxer.muxf(ctx);
-			/* close the infile */
-			close(fd);
 			/* great success innit? */
 			nsucc++;
 		}
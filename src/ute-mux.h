@@ -86,4 +86,10 @@ extern void mux(mux_ctx_t mctx);
  * Same as `mux()' but also hand over command line args. */
 extern int mux_main(mux_ctx_t mctx, int argc, char *argv[]);
 
+/**
+ * Muxers whose input lines can be parsed independently of each other
+ * define this, ute-mux may then cut large inputs at line boundaries and
+ * mux the parts in parallel. */
+extern const int mux_linewise;
+
 #endif	/* INCLUDED_ute_mux_h_ */
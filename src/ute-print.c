@@ -39,12 +39,17 @@
 #if defined HAVE_CONFIG_H
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #if defined HAVE_SYS_TYPES_H
 /* for ssize_t */
 # include <sys/types.h>
 #endif	/* HAVE_SYS_TYPES_H */
 #include <fcntl.h>
+#include <sys/wait.h>
+#include "utefile-private.h"
 #include "utefile.h"
 #include "boobs.h"
 
@@ -82,6 +87,9 @@
 # define countof(x)	(sizeof(x) / sizeof(*x))
 #endif	/* !countof */
 
+/* output buffer size, line printers flush in chunks this big */
+#define OBUF_SZ		(256U * 1024U)
+
 
 static ute_dso_t pr_dso;
 
@@ -159,10 +167,158 @@ print_mudems(void)
 	return;
 }
 
+static ssize_t
+rdpg(char *restrict tgt, size_t tsz, int fd)
+{
+	ssize_t tot = 0;
+
+	for (ssize_t n; (n = read(fd, tgt + tot, tsz - tot)) > 0; tot += n);
+	return tot;
+}
+
+static int
+prpgj(pr_ctx_t ctx, utectx_t hdl, size_t pg, int(*prf)(pr_ctx_t, scom_t))
+{
+/* format the ticks of page PG of HDL into CTX's output buffer, growing
+ * it rather than flushing, the last page also takes the tpc ticks */
+	const size_t npg = ute_npages(hdl);
+	const sidx_t lo = pg ? pg * UTE_BLKSZ - ute_hdrzt(hdl) : 0U;
+	const sidx_t hi = pg + 1U < npg
+		? (pg + 1U) * UTE_BLKSZ - ute_hdrzt(hdl) : (sidx_t)-1;
+
+	ute_iter_seek(hdl, lo);
+	for (scom_t ti;
+	     ute_iter_tell(hdl) < hi && (ti = ute_iter(hdl)) != NULL;) {
+		if (UNLIKELY(ctx->obi + MAX_LINE_LEN > ctx->obsz)) {
+			const size_t nusz = 2U * ctx->obsz;
+			char *nu;
+
+			if (UNLIKELY((nu = realloc(ctx->obuf, nusz)) == NULL)) {
+				return -1;
+			}
+			ctx->obuf = nu;
+			ctx->obsz = nusz;
+		}
+		prf(ctx, ti);
+	}
+	return 0;
+}
+
+static __attribute__((noreturn)) void
+prkid(pr_ctx_t ctx, utectx_t hdl, size_t j, size_t nj,
+      int(*prf)(pr_ctx_t, scom_t))
+{
+/* format every NJ-th page starting with J and send it down OUTFD
+ * as one frame, the frame length goes first */
+	const size_t npg = ute_npages(hdl);
+	int rc = EXIT_SUCCESS;
+
+	for (size_t pg = j; pg < npg; pg += nj) {
+		size_t len;
+
+		ctx->obi = sizeof(len);
+		if (UNLIKELY(prpgj(ctx, hdl, pg, prf) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		len = ctx->obi - sizeof(len);
+		memcpy(ctx->obuf, &len, sizeof(len));
+		if (UNLIKELY(pr_flush(ctx) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+	}
+	_exit(rc);
+}
+
+static int
+prj(pr_ctx_t ctx, utectx_t hdl, size_t nj, int(*prf)(pr_ctx_t, scom_t))
+{
+/* print HDL with NJ kids formatting pages round-robin, their frames
+ * are then passed on in page order */
+	const size_t npg = ute_npages(hdl);
+	const int outfd = ctx->outfd;
+	int fds[nj];
+	pid_t kids[nj];
+	int rc = 0;
+
+	/* whatever has been printed so far goes first */
+	if (UNLIKELY(ctx->obuf == NULL || pr_flush(ctx) < 0)) {
+		return -1;
+	}
+	for (size_t j = 0U; j < nj; j++) {
+		int p[2];
+
+		if (UNLIKELY(pipe(p) < 0)) {
+			nj = j;
+			rc = -1;
+			break;
+		}
+		switch ((kids[j] = fork())) {
+		case -1:
+			close(p[0]);
+			close(p[1]);
+			nj = j;
+			rc = -1;
+			break;
+		case 0:
+			/* the other kids' pipes are none of our business */
+			for (size_t k = 0U; k < j; k++) {
+				close(fds[k]);
+			}
+			close(p[0]);
+			ctx->outfd = p[1];
+			prkid(ctx, hdl, j, nj, prf);
+		default:
+			close(p[1]);
+			fds[j] = p[0];
+			continue;
+		}
+		break;
+	}
+
+	/* collect the frames in page order */
+	for (size_t pg = 0U; rc == 0 && pg < npg; pg++) {
+		const int fd = fds[pg % nj];
+		size_t len;
+
+		if (rdpg((char*)&len, sizeof(len), fd) < (ssize_t)sizeof(len)) {
+			rc = -1;
+			break;
+		}
+		for (ssize_t nrd; len > 0U; len -= nrd) {
+			const size_t n = len < ctx->obsz ? len : ctx->obsz;
+
+			if ((nrd = rdpg(ctx->obuf, n, fd)) < (ssize_t)n) {
+				rc = -1;
+				break;
+			}
+			ctx->obi = nrd;
+			if (UNLIKELY(pr_flush(ctx) < 0)) {
+				rc = -1;
+				break;
+			}
+		}
+	}
+	/* closing the pipes makes slacking kids die of SIGPIPE */
+	for (size_t j = 0U; j < nj; j++) {
+		int st;
+
+		close(fds[j]);
+		while (waitpid(kids[j], &st, 0) < 0 && errno == EINTR);
+		if (!WIFEXITED(st) || WEXITSTATUS(st) != EXIT_SUCCESS) {
+			rc = -1;
+		}
+	}
+	ctx->outfd = outfd;
+	return rc;
+}
+
 static int MAYBE_NOINLINE
-pr1(pr_ctx_t ctx, const char *f, int(*prf)(pr_ctx_t, scom_t))
+pr1(pr_ctx_t ctx, const char *f, size_t nj, int(*prf)(pr_ctx_t, scom_t))
 {
 	utectx_t hdl;
+	int rc = 0;
 
 	if ((hdl = ute_open(f, UO_RDONLY)) == NULL) {
 		error("cannot open file `%s'", f);
@@ -171,47 +327,284 @@ pr1(pr_ctx_t ctx, const char *f, int(*prf)(pr_ctx_t, scom_t))
 	/* otherwise print all them ticks */
 	ctx->uctx = hdl;
 
+	if (nj > 1U && ute_npages(hdl) > 1U) {
+		/* no more kids than pages */
+		if (nj > ute_npages(hdl)) {
+			nj = ute_npages(hdl);
+		}
+		if ((rc = prj(ctx, hdl, nj, prf)) < 0) {
+			error("cannot print file `%s' in parallel", f);
+		}
+		goto clo;
+	}
+
 	/* use the co-routine iterator */
 	for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
 		/* now to what we always do */
 		prf(ctx, ti);
 	}
 
+clo:
 	/* oh right, close the handle */
 	ute_close(hdl);
-	return 0;
+	return rc;
 }
 
-static ssize_t
-rdpg(char *restrict tgt, size_t tsz, int fd)
+
+/* streaming mode, for ute files coming through pipes and sockets */
+struct strm_s {
+	int fd;
+	bool eofp;
+	/* whether the stream is of foreign endianness */
+	bool swapp;
+	/* read buffer, consumed up to BI, filled up to BN */
+	char *b;
+	size_t bz;
+	size_t bi;
+	size_t bn;
+};
+
+static size_t
+strm_fill(struct strm_s *s, size_t want)
 {
-	ssize_t tot = 0;
+/* have WANT unconsumed bytes in S's buffer, or whatever is left before
+ * the end of the stream, return the number of unconsumed bytes */
+	if (s->bi) {
+		memmove(s->b, s->b + s->bi, s->bn - s->bi);
+		s->bn -= s->bi;
+		s->bi = 0U;
+	}
+	if (UNLIKELY(want > s->bz)) {
+		const size_t nusz = (want + 0xffffU) & ~(size_t)0xffffU;
+		char *nu;
 
-	for (ssize_t n; (n = read(fd, tgt + tot, tsz - tot)) > 0; tot += n);
-	return tot;
+		if (UNLIKELY((nu = realloc(s->b, nusz)) == NULL)) {
+			return s->bn;
+		}
+		s->b = nu;
+		s->bz = nusz;
+	}
+	while (!s->eofp && s->bn < want) {
+		ssize_t nrd = read(s->fd, s->b + s->bn, s->bz - s->bn);
+
+		if (nrd > 0) {
+			s->bn += nrd;
+		} else if (nrd < 0 && errno == EINTR) {
+			continue;
+		} else {
+			s->eofp = true;
+		}
+	}
+	return s->bn;
 }
 
-static ssize_t
-prpg(pr_ctx_t ctx, char *tpg, size_t tsz, int(*prf)(pr_ctx_t, scom_t))
+static size_t
+strm_cpgz(const struct strm_s *s, const char *p, size_t avail)
 {
-	char *eot = tpg + tsz;
-	ssize_t res = 0;
+/* if P points to a compressed page return its on-disk size, 0 otherwise
+ * like page_compressed_p() but mindful of the AVAIL bytes at P */
+	static const char xz[] = "\xfd" "7zXZ\0";
+	uint32_t len;
+
+	if (avail < sizeof(len) + sizeof(xz) - 1U ||
+	    memcmp(p + sizeof(len), xz, sizeof(xz) - 1U)) {
+		return 0U;
+	}
+	memcpy(&len, p, sizeof(len));
+	if (s->swapp) {
+		len = htooe32(len);
+	}
+	len += sizeof(len);
+	/* pages are padded to multiples of the sandwich size */
+	return (len + sizeof(struct sndwch_s) - 1U) &
+		~(sizeof(struct sndwch_s) - 1U);
+}
 
-	while (tpg < eot) {
-		scom_t ti = (void*)tpg;
-		prf(ctx, ti);
-		tpg += scom_byte_size(ti);
+static int
+strm_prpg(pr_ctx_t ctx, const struct strm_s *s, const char *pg, size_t z,
+	  int(*prf)(pr_ctx_t, scom_t))
+{
+/* print the ticks of the on-disk page PG of size Z, like seek_page()
+ * followed by ute_iter() on a file */
+	const struct sndwch_s *sp = (const void*)pg;
+	const struct sndwch_s *ep;
+	utectx_t hdl = ctx->uctx;
+
+	if (strm_cpgz(s, pg, z) == z) {
+		/* compressed page, can't be anything else */
+		void *x = NULL;
+		ssize_t mlen;
+		uint32_t len;
+
+		memcpy(&len, pg, sizeof(len));
+		if (s->swapp) {
+			len = htooe32(len);
+		}
+		if ((mlen = ute_decode(&x, pg + sizeof(len), len)) <= 0) {
+			errno = 0, error("cannot decompress page");
+			return -1;
+		}
+		sp = x;
+		z = mlen;
 	}
-	return res;
+	ep = sp + z / sizeof(*sp);
+	/* lone naughts at the end of a page are padding */
+	for (; ep > sp && ep[-1].key == -1ULL && ep[-1].sat == -1ULL; ep--);
+
+	for (size_t tz; sp < ep; sp += tz) {
+		prf(ctx, ute_iter_tick(hdl, (const void*)sp, &tz));
+	}
+	return 0;
 }
 
 static size_t
-get_slut_sz(utehdr2_t p)
+strm_tail(const struct utehdr2_s *hdr, size_t n)
 {
-	return p->slut_sz;
+/* given the last N bytes of a ute stream, pages and trailer, return
+ * where the trailer begins, going backwards like the load_*() routines */
+	const size_t tsz = sizeof(struct sndwch_s);
+	const uint32_t z[] = {hdr->ftr_sz, hdr->slut_sz};
+
+	for (size_t i = 0U; i < countof(z); i++) {
+		if (!z[i]) {
+			continue;
+		} else if (UNLIKELY(z[i] > n)) {
+			return 0U;
+		}
+		n = (n - z[i]) & ~(tsz - 1U);
+	}
+	return n;
 }
 
-
+static int
+prstrm(pr_ctx_t ctx, int fd, int(*prf)(pr_ctx_t, scom_t))
+{
+/* print the ute file coming in on FD in one forward pass,
+ * the slut is the first thing after the pages, so unless there's none
+ * pages are kept (as they came in) until it's been read */
+	const size_t tsz = sizeof(struct sndwch_s);
+	const size_t pgsz = UTE_BLKSZ * tsz;
+	struct strm_s s = {.fd = fd};
+	struct utehdr2_s hdr;
+	/* a bare context that only carries the slut and the iter state */
+	struct utectx_s *hdl;
+	struct {
+		char *p;
+		size_t z;
+	} *q = NULL;
+	size_t nq = 0U;
+	size_t npg = 0U;
+	size_t tz;
+	int rc = -1;
+
+	if (strm_fill(&s, sizeof(hdr) + tsz) < sizeof(hdr)) {
+		/* not even a header, do nothing, aye? */
+		return 0;
+	}
+	memcpy(&hdr, s.b, sizeof(hdr));
+	if (utehdr_check_magic(&hdr) < 0) {
+		errno = 0, error("stdin is not a ute file");
+		return -1;
+	} else if (UNLIKELY((hdl = calloc(1, sizeof(*hdl))) == NULL)) {
+		return -1;
+	} else if ((s.swapp = utehdr_check_endianness(&hdr) < 0)) {
+		hdr.ploff = htooe32(hdr.ploff);
+		hdr.slut_sz = htooe32(hdr.slut_sz);
+		hdr.ftr_sz = htooe32(hdr.ftr_sz);
+	}
+	/* the iterator needs the header to know about promotion and swaps */
+	*hdl->hdrc = hdr;
+	ute_iter_seek(hdl, 0U);
+	/* header size, i.e. where an uncompressed page 0 starts */
+	hdl->ploff = hdr.ploff ?: UTEHDR_MAX_SIZE;
+	/* upper bound for the trailer: slut (page tables included), footer */
+	tz = 0U;
+	tz += (hdr.slut_sz + tsz - 1U) & ~(tsz - 1U);
+	tz += (hdr.ftr_sz + tsz - 1U) & ~(tsz - 1U);
+	init_slut();
+	make_slut(hdl->slut);
+	ctx->uctx = hdl;
+
+	/* skip the header, compressed pages sit right behind it though */
+	if (hdr.flags & UTEHDR_FLAG_COMPRESSED &&
+	    strm_cpgz(&s, s.b + sizeof(hdr), s.bn - sizeof(hdr))) {
+		s.bi = sizeof(hdr);
+	} else if (strm_fill(&s, hdl->ploff) < hdl->ploff) {
+		goto out;
+	} else {
+		s.bi = hdl->ploff;
+	}
+
+	/* pages, a page is only a page if the trailer fits behind it */
+	for (size_t pz = pgsz - hdl->ploff, eop;; pz = pgsz, npg++) {
+		size_t z;
+
+		strm_fill(&s, pz + tz);
+		if (!(eop = s.eofp ? strm_tail(&hdr, s.bn) : s.bn - tz)) {
+			break;
+		} else if ((z = strm_cpgz(&s, s.b, eop)) == 0U) {
+			/* uncompressed, full size unless it's the last one */
+			z = pz < eop ? pz : eop;
+		} else if (z > eop && !s.eofp) {
+			/* compressed page bigger than what we've got */
+			strm_fill(&s, z + tz);
+			eop = s.eofp ? strm_tail(&hdr, s.bn) : s.bn - tz;
+		}
+		if (UNLIKELY(z > eop)) {
+			errno = 0, error("ute stream ends within a page");
+			goto out;
+		}
+
+		if (!hdr.slut_sz) {
+			/* no symbols to wait for */
+			if (strm_prpg(ctx, &s, s.b, z, prf) < 0) {
+				goto out;
+			}
+		} else if (!(nq % 16U) &&
+			   (q = realloc(q, (nq + 16U) * sizeof(*q))) == NULL) {
+			goto out;
+		} else if ((q[nq].p = malloc(z)) == NULL) {
+			goto out;
+		} else {
+			memcpy(q[nq].p, s.b, q[nq].z = z);
+			nq++;
+		}
+		s.bi = z;
+	}
+
+	/* the trailer, the slut comes first */
+	if (s.bn < (size_t)hdr.slut_sz + hdr.ftr_sz) {
+		errno = 0, error("ute stream ends prematurely");
+		goto out;
+	} else if (hdr.ftr_sz && hdr.ftr_sz / sizeof(struct uteftr_cell_s) != npg) {
+		errno = 0, error("ute stream has %zu pages, its footer says %zu",
+				 npg, hdr.ftr_sz / sizeof(struct uteftr_cell_s));
+		goto out;
+	} else if (hdr.slut_sz) {
+		slut_deser(hdl->slut, s.b, hdr.slut_sz);
+	}
+
+	/* now print whatever's been queued */
+	for (size_t i = 0U; i < nq; i++) {
+		if (strm_prpg(ctx, &s, q[i].p, q[i].z, prf) < 0) {
+			goto out;
+		}
+	}
+	rc = 0;
+out:
+	for (size_t i = 0U; i < nq; i++) {
+		free(q[i].p);
+	}
+	free(q);
+	free(s.b);
+	ctx->uctx = NULL;
+	free_slut(hdl->slut);
+	fini_slut();
+	free(hdl);
+	return rc;
+}
+
+
 #if defined STANDALONE
 #define yuck_post_help	yuck_post_help
 #include "ute-print.yucc"
@@ -222,6 +615,40 @@ static void yuck_post_help(const yuck_t UNUSED(src[static 1U]))
 	return;
 }
 
+static char**
+note_eqs(int argc, char *argv[])
+{
+/* remember where the = of every --opt=val is, yuck puts a \nul there */
+	char **eqs;
+
+	if ((eqs = calloc(argc, sizeof(*eqs))) == NULL) {
+		return NULL;
+	}
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] == '-' && argv[i][1] == '-') {
+			eqs[i] = strchr(argv[i], '=');
+		}
+	}
+	return eqs;
+}
+
+static void
+restore_eqs(int argc, char **eqs)
+{
+/* printer specific options are parsed again by the printer, so
+ * hand them over in the --opt=val form the user gave us */
+	if (eqs == NULL) {
+		return;
+	}
+	for (int i = 1; i < argc; i++) {
+		if (eqs[i] != NULL && *eqs[i] == '\0') {
+			*eqs[i] = '=';
+		}
+	}
+	free(eqs);
+	return;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -232,12 +659,17 @@ main(int argc, char *argv[])
 	int printer_specific_options_p = 0;
 	const char *fmt;
 	size_t nsucc = 0U;
+	size_t nj = 1U;
+	char **eqs = note_eqs(argc, argv);
 	int rc = 0;
 
 	if (yuck_parse(argi, argc, argv)) {
+		restore_eqs(argc, eqs);
 		rc = 1;
 		goto out;
 	}
+	/* our own options keep pointing behind the = */
+	restore_eqs(argc, eqs);
 
 	if (!argi->format_arg) {
 		/* superseding rudi's fave format */
@@ -250,6 +682,16 @@ main(int argc, char *argv[])
 		opt->outfile = argi->output_arg;
 	}
 
+	if (argi->jobs_arg) {
+		long int j = strtol(argi->jobs_arg, NULL, 10);
+
+		if (j <= 0) {
+			/* use all the cpus */
+			j = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		nj = j > 0 ? (size_t)j : 1U;
+	}
+
 	/* initialise the module system */
 	ute_module_init();
 
@@ -263,6 +705,11 @@ main(int argc, char *argv[])
 printer specific options given but cannot find printer\n", stderr);
 		rc = 1;
 		goto out;
+	} else if (nj > 1U && (prer.init_main_f || prer.initf || prer.finif)) {
+		/* printers with state of their own see every tick */
+		fputs("\
+printer cannot run in parallel, using one job\n", stderr);
+		nj = 1U;
 	}
 	if (argi->output_arg) {
 		const int oflags = O_CREAT | O_TRUNC | O_RDWR;
@@ -281,6 +728,20 @@ printer specific options given but cannot find printer\n", stderr);
 	/* we pass on the option structure so modules can have a finer
 	 * control over things, i.e. mmap the output file and whatnot */
 	ctx->opts = opt;
+	/* line printers collect their output here */
+	if ((ctx->obuf = malloc(OBUF_SZ)) != NULL) {
+		ctx->obsz = OBUF_SZ;
+	}
+
+	/* tell the printers what to expect so they can size things */
+	for (size_t j = 0U; j < argi->nargs; j++) {
+		utectx_t hdl;
+
+		if ((hdl = ute_open(argi->args[j], UO_RDONLY)) != NULL) {
+			ctx->nticks += ute_nticks(hdl);
+			ute_close(hdl);
+		}
+	}
 
 	/* check and call initialiser if any */
 	if (prer.init_main_f != NULL) {
@@ -298,34 +759,17 @@ printer specific options given but cannot find printer\n", stderr);
 	}
 
 	if (argi->nargs == 0U && !isatty(STDIN_FILENO)) {
-		/* operate on pages */
-		char pg[4096];
-		/* slut size */
-		size_t slsz;
-		ssize_t nrd;
-
-		/* first page is ute header, just read him off */
-		if (rdpg(pg, sizeof(pg), STDIN_FILENO) < (ssize_t)sizeof(pg)) {
-			/* oh oh oh, do nothing, aye? */
-			goto fina;
-		} else if (memcmp(pg, "UTE+", 4)) {
-			/* not the ute header, so fuck of too? */
+		/* header, pages and trailer as they come in */
+		if (prstrm(ctx, STDIN_FILENO, prer.prf) < 0) {
+			rc = 2;
 			goto fina;
 		}
-		/* otherwise try our harderst */
-		slsz = get_slut_sz((void*)pg);
-		while ((nrd = rdpg(pg, 4096, STDIN_FILENO)) > 0) {
-			if (UNLIKELY((size_t)nrd < sizeof(pg))) {
-				/* last page then? */
-				nrd -= slsz;
-			}
-			prpg(ctx, pg, nrd, prer.prf);
-		}
 		nsucc++;
 
 	} else {
-		for (size_t j = 0U; j < argi->nargs; j++) {
-			if (pr1(ctx, argi->args[j], prer.prf) < 0) {
+		/* printers with options leave only the files, \nul-terminated */
+		for (size_t j = 0U; j < argi->nargs && argi->args[j]; j++) {
+			if (pr1(ctx, argi->args[j], nj, prer.prf) < 0) {
 				rc = 2;
 				continue;
 			}
@@ -340,7 +784,14 @@ fina:
 		prer.finif(ctx);
 	}
 clo_out:
-	/* close the output file */
+	/* write out what's left over and close the output file */
+	if (ctx->obuf != NULL) {
+		if (pr_flush(ctx) < 0) {
+			error("cannot write output");
+			rc = 1;
+		}
+		free(ctx->obuf);
+	}
 	close(ctx->outfd);
 	if (!nsucc && opt->outfile) {
 		/* unlink output file */
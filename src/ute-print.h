@@ -41,16 +41,26 @@
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
 #include <string.h>
+#include <errno.h>
 /* for ssize_t */
 #include <unistd.h>
 #include "scommon.h"
 #include "nifty.h"
+#include "prfmt.h"
 
 #define MAX_LINE_LEN		512
 
 typedef struct pr_ctx_s *pr_ctx_t;
 typedef const struct pr_opt_s *pr_opt_t;
 
+/** the last stamp rendered by pr_tsmstz_ctx() and its date */
+struct pr_stmp_s {
+	int64_t t;
+	int64_t day;
+	char sep;
+	char s[20U];
+};
+
 struct pr_ctx_s {
 	/** file index for bad ticks */
 	int badfd;
@@ -59,10 +69,21 @@ struct pr_ctx_s {
 
 	/** overall ute context, will only be used for symbol printing */
 	utectx_t uctx;
+	/** upper bound on the number of ticks to come, or 0 if unknown */
+	size_t nticks;
 
 	char *buf;
 	size_t bsz;
 
+	/** output buffer, line printers append to it, see pr_obuf(),
+	 * or NULL to write every line straight to OUTFD */
+	char *obuf;
+	size_t obsz;
+	size_t obi;
+
+	/** stamp cache, consecutive ticks tend to share stamps and dates */
+	struct pr_stmp_s stmp[1];
+
 	/* options, for finer control */
 	pr_opt_t opts;
 };
@@ -74,66 +95,112 @@ struct pr_opt_s {
 
 /* some useful fun */
 #if defined INCLUDED_date_h_
+static inline void
+__pr_stmp(struct pr_stmp_s *restrict c, char *restrict buf, int64_t t, char sep)
+{
+/* print T as YYYY-MM-DD<SEP>HH:MM:SS into BUF,
+ * use and update the last stamp in C unless it's NULL */
+	if (c == NULL) {
+		struct tm tm;
+
+		ffff_gmtime(&tm, t);
+		ffff_strftime(buf, 32, &tm, sep);
+		return;
+	} else if (LIKELY(t == c->t && sep == c->sep)) {
+		/* spot on */
+		;
+	} else if (t / 86400 == c->day && t >= 0 && sep == c->sep) {
+		/* same day, just the clock then */
+		const unsigned int rem = (unsigned int)(t % 86400);
+
+		prfmt_dig2_s(c->s + 11U, rem / 3600U);
+		prfmt_dig2_s(c->s + 14U, (rem / 60U) % 60U);
+		prfmt_dig2_s(c->s + 17U, rem % 60U);
+		c->t = t;
+	} else {
+		struct tm tm;
+
+		ffff_gmtime(&tm, t);
+		ffff_strftime(c->s, sizeof(c->s), &tm, sep);
+		c->t = t;
+		c->day = t >= 0 ? t / 86400 : -1;
+		c->sep = sep;
+	}
+	memcpy(buf, c->s, 19U);
+	return;
+}
+
 static inline size_t
 pr_ts(char *restrict buf, uint32_t sec, char sep)
 {
-	struct tm tm;
-	ffff_gmtime(&tm, sec);
-	ffff_strftime(buf, 32, &tm, sep);
+	__pr_stmp(NULL, buf, sec, sep);
 	return 19;
 }
 
 static inline size_t
-pr_tsmstz(char *restrict buf, uint32_t sec, uint32_t msec, zif_t z, char sep)
+__pr_tsmstz(
+	struct pr_stmp_s *restrict c,
+	char *restrict buf, uint32_t sec, uint32_t msec, zif_t z, char sep)
 {
-	struct tm tm;
+	/* zif_local_time() caches the offset of the current DST range */
+	const int32_t lt = zif_local_time(z, sec);
 	int h, m, off;
 
-	ffff_localtime(&tm, sec, z);
 	if (UNLIKELY(msec == SCOM_MSEC_VALI)) {
+		struct tm tm;
+
+		ffff_gmtime(&tm, lt);
 		tm.tm_hour = 24;
 		tm.tm_min = 0;
 		tm.tm_sec = 0;
+		ffff_strftime(buf, 32, &tm, sep);
+	} else {
+		__pr_stmp(c, buf, lt, sep);
 	}
-	ffff_strftime(buf, 32, &tm, sep);
 	buf[19] = '.';
 	buf[20] = (char)(((msec / 100) % 10) + '0');
-	buf[21] = (char)(((msec / 10) % 10) + '0');
-	buf[22] = (char)(((msec / 1) % 10) + '0');
+	prfmt_dig2_s(buf + 21, msec % 100);
 
 #if defined HAVE_STRUCT_TM_TM_GMTOFF
-	off = tm.tm_gmtoff;
+	off = lt - (int32_t)sec;
 #else  /* !HAVE_STRUCT_TM_TM_GMTOFF */
 	off = 0;
 #endif	/* HAVE_STRUCT_TM_TM_GMTOFF */
 
 	/* compute offset as HHMM */
-	if (off == 0) {;
-		buf[23] = '+';
-		buf[24] = '0';
-		buf[25] = '0';
-		buf[26] = ':';
-		buf[27] = '0';
-		buf[28] = '0';
+	if (off == 0) {
+		memcpy(buf + 23, "+00:00", 6U);
 		goto done;
 	} else if (off > 0) {
-		h = off / 3600;
-		m = (off % 3600) / 60;
 		buf[23] = '+';
 	} else /* (off < 0) */ {
 		off = -off;
-		h = off / 3600;
-		m = (off % 3600) / 60;
 		buf[23] = '-';
 	}
-	buf[24] = (char)(((h / 10) % 10) + '0');
-	buf[25] = (char)(((h / 1) % 10) + '0');
+	h = off / 3600;
+	m = (off % 3600) / 60;
+	prfmt_dig2_s(buf + 24, h % 100);
 	buf[26] = ':';
-	buf[27] = (char)(((m / 10) % 10) + '0');
-	buf[28] = (char)(((m / 1) % 10) + '0');
+	prfmt_dig2_s(buf + 27, m % 100);
 done:
 	return 29;
 }
+
+static inline size_t
+pr_tsmstz(char *restrict buf, uint32_t sec, uint32_t msec, zif_t z, char sep)
+{
+	return __pr_tsmstz(NULL, buf, sec, msec, z, sep);
+}
+
+/**
+ * Like pr_tsmstz() but go through PCTX's stamp cache. */
+static inline size_t
+pr_tsmstz_ctx(
+	pr_ctx_t pctx,
+	char *restrict buf, uint32_t sec, uint32_t msec, zif_t z, char sep)
+{
+	return __pr_tsmstz(pctx->stmp, buf, sec, msec, z, sep);
+}
 #endif	/* INCLUDED_date_h_ */
 
 static inline size_t
@@ -149,19 +216,77 @@ pr_sym(utectx_t ctx, char *restrict buf, unsigned int idx)
 	return pl;
 }
 
+/**
+ * Return the symbol index of ST, wide indices included. */
+static inline unsigned int
+pr_tblidx(pr_ctx_t pctx, scom_t st)
+{
+	if (LIKELY(pctx->uctx != NULL)) {
+		return ute_tblidx(pctx->uctx, st);
+	}
+	return scom_thdr_tblidx(st);
+}
+
 /* has same signature as a prf */
 static inline ssize_t
 print_tick_sym(pr_ctx_t pctx, scom_t st)
 {
-	unsigned int si = scom_thdr_tblidx(st);
 	ssize_t res = 0;
 
 	if (LIKELY(pctx->uctx != NULL)) {
+		unsigned int si = ute_tblidx(pctx->uctx, st);
 		pctx->bsz += res = pr_sym(pctx->uctx, pctx->buf, si);
 	}
 	return res;
 }
 
+/**
+ * Write out what's in PCTX's output buffer.
+ * Return 0 on success and -1 if OUTFD won't take it, in which case the
+ * buffer contents are discarded. */
+static inline int
+pr_flush(pr_ctx_t pctx)
+{
+	const char *p = pctx->obuf;
+	const char *const ep = p + pctx->obi;
+
+	pctx->obi = 0U;
+	for (ssize_t nwr; p < ep; p += nwr) {
+		if (UNLIKELY((nwr = write(pctx->outfd, p, ep - p)) < 0)) {
+			if (errno == EINTR) {
+				nwr = 0;
+				continue;
+			}
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Return a pointer to N free bytes at the end of PCTX's output buffer,
+ * flushing it beforehand if need be.  Once formatted, the bytes are
+ * committed with pr_obuf_adv().
+ * Return NULL if PCTX has no output buffer or if flushing failed. */
+static inline char*
+pr_obuf(pr_ctx_t pctx, size_t n)
+{
+	if (UNLIKELY(pctx->obuf == NULL)) {
+		return NULL;
+	} else if (UNLIKELY(pctx->obi + n > pctx->obsz) &&
+		   pr_flush(pctx) < 0) {
+		return NULL;
+	}
+	return pctx->obuf + pctx->obi;
+}
+
+static inline void
+pr_obuf_adv(pr_ctx_t pctx, size_t n)
+{
+	pctx->obi += n;
+	return;
+}
+
 /**
  * Public print function.
  * Implemented through DSOs.
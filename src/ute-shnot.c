@@ -42,7 +42,10 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <limits.h>
+#include <errno.h>
 #include <sys/mman.h>
+#include <sys/wait.h>
 
 /* we're just as good as rudi, aren't we? */
 #if defined DEBUG_FLAG
@@ -61,6 +64,7 @@
 /* our own goodness */
 #include "ute-shnot.h"
 #include "cmd-aux.c"
+#include "cmd-mrg.c"
 
 /* we need to look into ticks and tick packets */
 #include "sl1t.h"
@@ -80,22 +84,42 @@ struct xsnap_s {
 	struct ssnp_s sn[1];
 	m62_t nt;
 	m62_t qpri;
+	/* number of pushes in the current interval */
+	uint32_t npush;
 };
 
 struct bkts_s {
 	uint32_t nsyms;
 	time_t cur_ts;
 	xsnap_t snap;
+
+	/* symbols that saw quotes in the current interval */
+	uint32_t *act;
+	uint32_t nact;
+	/* reader to writer symbol index, 0 if not yet looked up */
+	uint32_t *omap;
 };
 
 /* ssnap fiddlers */
 static inline void
 bkts_cleanse(bkts_t b)
 {
-	memset(b->snap, 0, (b->nsyms + 1) * sizeof(*b->snap));
+	/* only the active snapshots can be dirty */
+	for (uint32_t i = 0U; i < b->nact; i++) {
+		memset(b->snap + b->act[i], 0, sizeof(*b->snap));
+	}
+	b->nact = 0U;
 	return;
 }
 
+static int
+u32cmp(const void *x, const void *y)
+{
+	uint32_t a = *(const uint32_t*)x;
+	uint32_t b = *(const uint32_t*)y;
+	return (a > b) - (a < b);
+}
+
 static bool
 xsnap_empty_p(xsnap_t sn)
 {
@@ -261,11 +285,15 @@ new_candle_p(shnot_ctx_t ctx, scom_t t)
 static unsigned int
 copy_sym(shnot_ctx_t ctx, unsigned int cidx)
 {
-	const char *cur_sym = ute_idx2sym(ctx->rdr, cidx);
-	if (UNLIKELY(cur_sym == NULL)) {
+	uint32_t *omap = ctx->bkt->omap;
+	const char *cur_sym;
+
+	if (LIKELY(omap[cidx])) {
+		return omap[cidx];
+	} else if (UNLIKELY((cur_sym = ute_idx2sym(ctx->rdr, cidx)) == NULL)) {
 		return 0;
 	}
-	return ute_sym2idx(ctx->wrr, cur_sym);
+	return omap[cidx] = ute_sym2idx(ctx->wrr, cur_sym);
 }
 
 static void
@@ -293,7 +321,7 @@ write_snap(shnot_ctx_t ctx, unsigned int cidx)
 	sn->tq = ffff_m30_from_m62(xn->nt).v;
 
 	/* kick off */
-	ute_add_tick(ctx->wrr, AS_SCOM(sn));
+	ute_add_tick_idx(ctx->wrr, AS_SCOM(sn), nidx);
 	return;
 }
 
@@ -304,9 +332,10 @@ new_candle(shnot_ctx_t ctx)
 		return;
 	}
 
-	/* write all the snapshots so far */
-	for (unsigned int i = 0; i <= ctx->bkt->nsyms; i++) {
-		write_snap(ctx, i);
+	/* write all the snapshots so far, in symbol order */
+	qsort(ctx->bkt->act, ctx->bkt->nact, sizeof(*ctx->bkt->act), u32cmp);
+	for (uint32_t i = 0U; i < ctx->bkt->nact; i++) {
+		write_snap(ctx, ctx->bkt->act[i]);
 	}
 	return;
 }
@@ -338,12 +367,15 @@ check_candle(shnot_ctx_t ctx, scom_t t)
 }
 
 static void
-bucketiser(shnot_ctx_t ctx, scom_t t)
+bucketiser(shnot_ctx_t ctx, unsigned int i, scom_t t)
 {
-	unsigned int i = scom_thdr_tblidx(t);
 	xsnap_t b = ctx->bkt->snap + i;
 
 	check_candle(ctx, t);
+	if (!b->npush++) {
+		/* first quote this interval, remember the symbol */
+		ctx->bkt->act[ctx->bkt->nact++] = i;
+	}
 	xsnap_push(b, t);
 	return;
 }
@@ -402,6 +434,8 @@ deinit(shnot_ctx_t ctx, size_t nsucc)
 	} else if (ctx->bkt->snap) {
 		xsnap_t snap = ctx->bkt->snap;
 		munmap(snap, (ctx->bkt->nsyms + 1) * sizeof(*snap));
+		free(ctx->bkt->act);
+		free(ctx->bkt->omap);
 	}
 	return;
 }
@@ -422,12 +456,17 @@ init_buckets(shnot_ctx_t ctx, utectx_t hdl, bkts_t bkt)
 			size_t old = (nsyms_bkt + 1) * sizeof(*snap);
 			bkt->snap = mremap(snap, old, sz, MREMAP_MAYMOVE);
 		}
+		sz = (nsyms_hdl + 1) * sizeof(*bkt->act);
+		bkt->act = realloc(bkt->act, sz);
+		bkt->omap = realloc(bkt->omap, sz);
 		bkt->nsyms = nsyms_hdl;
 	}
 	/* assign the reader */
 	ctx->rdr = hdl;
 	/* scrub the buckets in b thoroughly */
 	bkts_cleanse(bkt);
+	/* symbol indices are per reader */
+	memset(bkt->omap, 0, (bkt->nsyms + 1) * sizeof(*bkt->omap));
 	/* and assign buckets to ctx */
 	ctx->bkt = bkt;
 	return;
@@ -442,6 +481,146 @@ fini_buckets(shnot_ctx_t ctx)
 	}
 	return;
 }
+static void
+shnot1(shnot_ctx_t ctx, utectx_t hdl, bkts_t bkt, size_t j, size_t nj)
+{
+/* snapshot the J-th of NJ shares of HDL's symbols */
+	const size_t nsyms = ute_nsyms(hdl);
+	const unsigned int from = j ? j * nsyms / nj + 1U : 0U;
+	const unsigned int till = (j + 1U) * nsyms / nj + 1U;
+
+	/* (re)initialise our buckets */
+	init_buckets(ctx, hdl, bkt);
+	/* otherwise print all them ticks */
+	for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
+		unsigned int i = ute_tblidx(hdl, ti);
+
+		if (i >= from && i < till) {
+			/* now to what we always do */
+			bucketiser(ctx, i, ti);
+		}
+	}
+	/* last round, just emit what we've got */
+	new_candle(ctx);
+
+	/* finish our buckets */
+	fini_buckets(ctx);
+	return;
+}
+
+
+/* parallel snapshots, every job takes a contiguous share of each file's
+ * symbols into a run of its own, then the runs are merged by time */
+struct shjob_s {
+	/* set once the run has been closed */
+	int donep;
+	int rc;
+	size_t nsucc;
+	char fn[PATH_MAX];
+};
+
+static void
+shnot_job(struct shjob_s *jb, shnot_opt_t opt,
+	  char *const *args, size_t nargs, size_t j, size_t nj)
+{
+/* snapshot the J-th share of symbols of files ARGS into a temp run */
+	struct shnot_opt_s jopt = *opt;
+	struct shnot_ctx_s jctx[1U];
+	struct bkts_s jbkt[1U] = {{0}};
+
+	jopt.outfile = NULL;
+	if (init(jctx, &jopt) < 0) {
+		jb->rc = 1;
+		goto out;
+	}
+	for (size_t i = 0U; i < nargs; i++) {
+		void *hdl;
+
+		if ((hdl = ute_open(args[i], UO_RDONLY)) == NULL) {
+			jb->rc = 2;
+			continue;
+		}
+		shnot1(jctx, hdl, jbkt, j, nj);
+		ute_close(hdl);
+		jb->nsucc++;
+	}
+	strncpy(jb->fn, ute_fn(jctx->wrr), sizeof(jb->fn) - 1U);
+	ute_close(jctx->wrr);
+	jctx->wrr = NULL;
+	jb->donep = 1;
+out:
+	deinit(jctx, 0U);
+	return;
+}
+
+static int
+shnot_par(shnot_ctx_t ctx, char *const *args, size_t nargs,
+	  size_t njobs, size_t *nsucc)
+{
+/* snapshot files ARGS with NJOBS jobs into CTX's writer */
+	struct shjob_s *jobs;
+	char **runs;
+	size_t nruns = 0U;
+	pid_t *kids;
+	int rc = 0;
+
+	/* results must be visible across the fork()s */
+	jobs = mmap(NULL, njobs * sizeof(*jobs), PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (UNLIKELY(jobs == MAP_FAILED)) {
+		return 1;
+	} else if (UNLIKELY((kids = calloc(njobs, sizeof(*kids))) == NULL)) {
+		munmap(jobs, njobs * sizeof(*jobs));
+		return 1;
+	} else if (UNLIKELY((runs = calloc(njobs, sizeof(*runs))) == NULL)) {
+		free(kids);
+		munmap(jobs, njobs * sizeof(*jobs));
+		return 1;
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		switch ((kids[j] = fork())) {
+		case -1:
+			/* do it ourselves */
+			kids[j] = 0;
+			shnot_job(jobs + j, ctx->opts, args, nargs, j, njobs);
+			break;
+		case 0:
+			shnot_job(jobs + j, ctx->opts, args, nargs, j, njobs);
+			_exit(EXIT_SUCCESS);
+		default:
+			break;
+		}
+	}
+	for (size_t j = 0U; j < njobs; j++) {
+		if (kids[j] > 0) {
+			while (waitpid(kids[j], NULL, 0) < 0 && errno == EINTR);
+		}
+	}
+	free(kids);
+
+	for (size_t j = 0U; j < njobs; j++) {
+		if (UNLIKELY(!jobs[j].donep)) {
+			errno = 0;
+			error("shnot job %zu died", j);
+			rc = 1;
+			continue;
+		} else if (jobs[j].rc > rc) {
+			rc = jobs[j].rc;
+		}
+		runs[nruns++] = jobs[j].fn;
+	}
+	/* all jobs see the same files */
+	*nsucc = rc != 1 ? jobs->nsucc : 0U;
+	if (*nsucc && mrg_runs(ctx->wrr, runs, nruns, NULL) < 0) {
+		rc = 1;
+	}
+	for (size_t j = 0U; j < nruns; j++) {
+		(void)unlink(runs[j]);
+	}
+	free(runs);
+	munmap(jobs, njobs * sizeof(*jobs));
+	return rc;
+}
 
 
 #if defined STANDALONE
@@ -455,6 +634,7 @@ main(int argc, char *argv[])
 	struct shnot_opt_s opt[1U] = {{0}};
 	struct bkts_s bkt[1U] = {{0}};
 	size_t nsucc = 0U;
+	size_t njobs = 1U;
 	int rc = 0;
 
 	if (yuck_parse(argi, argc, argv)) {
@@ -481,12 +661,26 @@ main(int argc, char *argv[])
 		opt->offset = 0;
 	}
 
+	if (argi->jobs_arg) {
+		long int nj = strtol(argi->jobs_arg, NULL, 10);
+
+		if (nj <= 0) {
+			/* use all the cpus */
+			nj = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		njobs = nj > 0 ? (size_t)nj : 1U;
+	}
+
 	/* initialise context */
 	if (init(ctx, opt) < 0) {
 		rc = 1;
 		goto out;
 	}
 
+	if (njobs > 1U) {
+		rc = shnot_par(ctx, argi->args, argi->nargs, njobs, &nsucc);
+		goto clo;
+	}
 	for (size_t j = 0U; j < argi->nargs; j++) {
 		const char *f = argi->args[j];
 		void *hdl;
@@ -495,23 +689,13 @@ main(int argc, char *argv[])
 			rc = 2;
 			continue;
 		}
-		/* (re)initialise our buckets */
-		init_buckets(ctx, hdl, bkt);
-		/* otherwise print all them ticks */
-		for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
-			/* now to what we always do */
-			bucketiser(ctx, ti);
-		}
-		/* last round, just emit what we've got */
-		new_candle(ctx);
-
-		/* finish our buckets */
-		fini_buckets(ctx);
+		shnot1(ctx, hdl, bkt, 0U, 1U);
 		/* oh right, close the handle */
 		ute_close(hdl);
 		/* count this run as success */
 		nsucc++;
 	}
+clo:
 	/* leave a footer and finish the shnot series */
 	deinit(ctx, nsucc);
 
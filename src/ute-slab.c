@@ -44,6 +44,10 @@
 #include <fcntl.h>
 #include <time.h>
 #include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
 
 /* using ute_add_tick_as() */
 #include "utefile-private.h"
@@ -93,6 +97,19 @@ struct slab_ctx_s {
 	/* interval for interval based explosion */
 	uint32_t intv;
 	uint32_t last;
+
+	/* maximum number of simultaneously open outputs when exploding */
+	size_t maxopen;
+	/* number of outputs to finalise in parallel */
+	size_t njobs;
+};
+
+/* per-symbol output state for explosions */
+struct xplo_s {
+	/* output context, NULL if there's none */
+	utectx_t out;
+	/* symbol index in OUT */
+	unsigned int idx;
 };
 
 /* bitsets */
@@ -205,6 +222,67 @@ open_out(const char *fn, int fl)
 	return ute_mktemp(fl);
 }
 
+/* finalisers running in the background */
+static pid_t *kids;
+static size_t nkids;
+
+static pid_t
+reap_out(pid_t pid)
+{
+/* wait for finaliser PID (or any if -1) and forget about it */
+	int st;
+
+	if ((pid = waitpid(pid, &st, 0)) > 0) {
+		for (size_t i = 0U; i < nkids; i++) {
+			if (kids[i] == pid) {
+				kids[i] = kids[--nkids];
+				break;
+			}
+		}
+	}
+	return pid;
+}
+
+static void
+wait_all(void)
+{
+	while (nkids > 0U && reap_out(-1) > 0);
+	return;
+}
+
+static void
+close_out(slab_ctx_t ctx, utectx_t out)
+{
+/* close OUT, in a child process if we're allowed several jobs */
+	pid_t pid;
+
+	if (ctx->njobs <= 1U) {
+		ute_close(out);
+		return;
+	} else if (UNLIKELY(kids == NULL)) {
+		kids = calloc(ctx->njobs, sizeof(*kids));
+	}
+	/* make room for another finaliser */
+	while (nkids >= ctx->njobs && reap_out(-1) > 0);
+
+	switch ((pid = fork())) {
+	case -1:
+		/* do it ourselves then */
+		ute_close(out);
+		break;
+	case 0:
+		/* sort, compress and write out the trailer */
+		ute_close(out);
+		_exit(EXIT_SUCCESS);
+	default:
+		/* the child does the disk work, just free our copy */
+		ute_free(out);
+		kids[nkids++] = pid;
+		break;
+	}
+	return;
+}
+
 static int
 rotate_intv(slab_ctx_t ctx, uint32_t cur_ts)
 {
@@ -215,7 +293,7 @@ rotate_intv(slab_ctx_t ctx, uint32_t cur_ts)
 
 	/* first of all, finalise the old guy */
 	if (LIKELY(ctx->out != NULL)) {
-		ute_close(ctx->out);
+		close_out(ctx, ctx->out);
 	}
 	/* construct the out file name */
 	prfz = strlen(ctx->outfn);
@@ -269,9 +347,10 @@ open_xplo(slab_ctx_t ctx, const char sym[static 1])
 
 
 static void
-slabt(slab_ctx_t ctx, scom_t ti, size_t max, bitset_t filtix, bitset_t copyix)
+slabt(slab_ctx_t ctx, scom_t ti, utectx_t orig,
+      size_t max, bitset_t filtix, bitset_t copyix)
 {
-	unsigned int idx = scom_thdr_tblidx(ti);
+	unsigned int idx = ute_tblidx(orig, ti);
 	time_t stmp = scom_thdr_sec(ti);
 
 	/* chain of filters, first one loses */
@@ -289,7 +368,7 @@ slabt(slab_ctx_t ctx, scom_t ti, size_t max, bitset_t filtix, bitset_t copyix)
 		bitset_set(copyix, idx);
 	}
 	/* we passed all them tests, just let him through */
-	ute_add_tick(ctx->out, ti);
+	ute_add_tick_idx(ctx->out, ti, idx);
 	return;
 }
 
@@ -307,18 +386,142 @@ slabi(slab_ctx_t ctx, scom_t ti, utectx_t orig)
 		}
 		/* copy the symbol table */
 		for (size_t i = 0; i <= ute_nsyms(orig); i++) {
-			const char *sym = ute_idx2sym(orig, (uint16_t)i);
+			const char *sym = ute_idx2sym(orig, i);
 
 			if (sym != NULL) {
-				ute_bang_symidx(ctx->out, sym, (uint16_t)i);
+				ute_bang_symidx(ctx->out, sym, i);
 			}
 		}
 	}
 
-	ute_add_tick(ctx->out, ti);
+	ute_add_tick_idx(ctx->out, ti, ute_tblidx(orig, ti));
 	return;
 }
 
+/* time range slabs off sorted files */
+static uint64_t
+stmp_key(time_t stmp)
+{
+/* the smallest tick key with a time stamp of STMP */
+	if (stmp <= 0) {
+		return 0U;
+	} else if (stmp > (time_t)UINT32_MAX) {
+		return UINT64_MAX;
+	}
+	return (uint64_t)stmp << 32U;
+}
+
+static ssize_t
+find_page(utectx_t hdl, size_t npg, uint64_t key, bool lop)
+{
+/* binary search for the first page whose smallest (if LOP) or largest key
+ * is no less than KEY, return NPG if there's none */
+	size_t lo = 0U;
+	size_t hi = npg;
+
+	while (lo < hi) {
+		const size_t mid = (lo + hi) / 2U;
+		const struct uteftr_krng_s *kr;
+
+		if (UNLIKELY((kr = page_krng(hdl, mid)) == NULL)) {
+			return -1;
+		} else if ((lop ? kr->lo : kr->hi) < key) {
+			lo = mid + 1U;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+static bool
+slab_sorted_p(utectx_t hdl)
+{
+/* whether HDL is sorted and has the key ranges of all its pages on file,
+ * ticks within a page always are sorted, so check that every page's keys
+ * follow the previous page's, we never look inside the pages here */
+	const size_t npg = ute_npages(hdl);
+	const struct uteftr_krng_s *prev;
+
+	if (!ute_sorted_p(hdl)) {
+		return false;
+	} else if (npg == 0U) {
+		return true;
+	} else if ((prev = page_krng(hdl, 0U)) == NULL) {
+		return false;
+	}
+	for (size_t pg = 1U; pg < npg; pg++) {
+		const struct uteftr_krng_s *kr;
+
+		if ((kr = page_krng(hdl, pg)) == NULL) {
+			return false;
+		} else if (kr->lo < prev->hi) {
+			return false;
+		}
+		prev = kr;
+	}
+	return true;
+}
+
+static int
+slab_range(slab_ctx_t ctx, utectx_t hdl, bitset_t copyix)
+{
+/* copy the ticks in [from, till) off HDL, relies on HDL being sorted
+ * and in native byte order, ticks are copied as they are
+ * if a page cannot be had, HDL's iterator is put at that page and
+ * -1 is returned, so the caller can slab the rest tick by tick */
+	const uint64_t from = stmp_key(ctx->from);
+	const uint64_t till = stmp_key(ctx->till);
+	const size_t npg = ute_npages(hdl);
+	ssize_t b;
+	ssize_t e;
+
+	if ((b = find_page(hdl, npg, from, false)) < 0) {
+		return -1;
+	} else if ((e = find_page(hdl, npg, till, true)) < 0) {
+		return -1;
+	}
+	for (size_t pg = b; pg < (size_t)e; pg++) {
+		struct uteseek_s sk[1];
+		const struct sndwch_s *sp;
+		const struct sndwch_s *ep;
+		const struct sndwch_s *rb = NULL;
+
+		if (UNLIKELY(seek_page(sk, hdl, pg) < 0)) {
+			/* pages before PG are done */
+			ute_iter_seek(hdl, pg ? pg * UTE_BLKSZ - ute_hdrzt(hdl) : 0);
+			return -1;
+		}
+		sp = sk->sp + sk->si;
+		ep = sk->sp + sk->szrw / sizeof(*sk->sp);
+		/* ticks are variadic, so step through the page to find the
+		 * run within [from, till) and to note down the symbols */
+		for (size_t tsz; sp < ep; sp += tsz) {
+			scom_t t = AS_SCOM(sp);
+
+			tsz = scom_tick_size(t);
+			if (t->u < from) {
+				continue;
+			} else if (t->u >= till) {
+				break;
+			} else if (rb == NULL) {
+				rb = sp;
+			}
+			if (UNLIKELY(scom_thdr_widx_p(t))) {
+				bitset_set(copyix, scom_widx(t));
+			} else {
+				bitset_set(copyix, scom_thdr_tblidx(t));
+			}
+		}
+		if (rb != NULL) {
+			/* the run goes in verbatim */
+			ute_add_ticks(ctx->out, rb, sp - rb);
+		}
+		flush_seek(sk);
+	}
+	return 0;
+}
+
 static void
 slab1(slab_ctx_t ctx, utectx_t hdl)
 {
@@ -365,10 +568,16 @@ slab1(slab_ctx_t ctx, utectx_t hdl)
 		ute_bang_symidx(ctx->out, sym, idx);
 	}
 
-	if (!ctx->intv) {
+	if (!ctx->intv && !max_idx &&
+	    (ctx->from > INT32_MIN || ctx->till < INT32_MAX) &&
+	    ute_check_endianness(hdl) == 0 &&
+	    slab_sorted_p(hdl) && slab_range(ctx, hdl, copyix) == 0) {
+		/* pure time range off a sorted file, pages have been copied */
+		;
+	} else if (!ctx->intv) {
 		for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
 			/* now to what we always do */
-			slabt(ctx, ti, max_idx, filtix, copyix);
+			slabt(ctx, ti, hdl, max_idx, filtix, copyix);
 		}
 	} else {
 		for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
@@ -379,7 +588,7 @@ slab1(slab_ctx_t ctx, utectx_t hdl)
 
 	if (max_idx == 0) {
 		BITSET_LOOP(copyix, i) {
-			uint16_t idx = (uint16_t)i;
+			unsigned int idx = i;
 			const char *sym = ute_idx2sym(hdl, idx);
 			ute_bang_symidx(ctx->out, sym, idx);
 		}
@@ -390,40 +599,58 @@ slab1(slab_ctx_t ctx, utectx_t hdl)
 static void
 xplo1(slab_ctx_t ctx, utectx_t hdl)
 {
-	size_t nsyms;
-	utectx_t out;
-
 	/* number of syms we're talking */
-	nsyms = ute_nsyms(hdl);
+	const size_t nsyms = ute_nsyms(hdl);
+	/* symbols per pass, each has its output open throughout the pass */
+	const size_t ngrp = ctx->maxopen < nsyms ? ctx->maxopen : nsyms;
+	struct xplo_s *x;
 
-	/* generate the outfile */
-	for (size_t i = 1; i <= nsyms; i++) {
-		const char *sym = ute_idx2sym(hdl, (uint16_t)i);
-		unsigned int new_idx;
+	if (UNLIKELY(nsyms == 0U)) {
+		return;
+	} else if (UNLIKELY((x = calloc(ngrp, sizeof(*x))) == NULL)) {
+		return;
+	}
 
-		/* open the new file */
-		if (UNLIKELY(sym == NULL)) {
-			continue;
-		} else if (UNLIKELY((out = open_xplo(ctx, sym)) == NULL)) {
-			continue;
+	/* one pass over the input per NGRP symbols, usually just one */
+	for (size_t beg = 1U, end; beg <= nsyms; beg = end) {
+		end = beg + ngrp <= nsyms ? beg + ngrp : nsyms + 1U;
+
+		/* symbols without ticks get an empty file */
+		for (size_t i = beg; i < end; i++) {
+			const char *sym = ute_idx2sym(hdl, i);
+			struct xplo_s *xi = x + (i - beg);
+
+			if (UNLIKELY(sym == NULL)) {
+				xi->out = NULL;
+				continue;
+			} else if ((xi->out = open_xplo(ctx, sym)) == NULL) {
+				continue;
+			}
+			/* bang the symbol we're talking */
+			xi->idx = ute_sym2idx(xi->out, sym);
 		}
-		/* bang the symbol we're talking */
-		new_idx = ute_sym2idx(out, sym);
 
+		/* route every tick of this group to its symbol's output */
+		ute_iter_seek(hdl, 0U);
 		for (scom_t ti; (ti = ute_iter(hdl)) != NULL;) {
+			unsigned int i = ute_tblidx(hdl, ti);
 
-			if (scom_thdr_tblidx(ti) == (uint16_t)i) {
-				scidx_t hdr[1];
-
-				/* fiddle with the index first */
-				*hdr = *ti;
-				scom_thdr_set_tblidx(hdr, (uint16_t)new_idx);
-				ute_add_tick_as(out, ti, hdr);
+			if (i < beg || i >= end || x[i - beg].out == NULL) {
+				continue;
 			}
+			/* fiddle with the index on the way */
+			ute_add_tick_idx(x[i - beg].out, ti, x[i - beg].idx);
 		}
 
-		ute_close(out);
+		/* finalise the group, possibly in the background */
+		for (size_t i = beg; i < end; i++) {
+			if (x[i - beg].out != NULL) {
+				close_out(ctx, x[i - beg].out);
+			}
+		}
 	}
+	wait_all();
+	free(x);
 	return;
 }
 
@@ -480,6 +707,33 @@ main(int argc, char *argv[])
 	if (argi->explode_by_interval_arg) {
 		ctx->intv = strtoul(argi->explode_by_interval_arg, NULL, 10);
 	}
+	/* as many as the descriptor limit allows, unless told otherwise */
+	ctx->maxopen = SIZE_MAX;
+	if (argi->max_open_arg) {
+		ctx->maxopen = strtoul(argi->max_open_arg, NULL, 10);
+	}
+	with (struct rlimit r) {
+		/* leave some descriptors for inputs and sorting */
+		if (getrlimit(RLIMIT_NOFILE, &r) == 0 &&
+		    r.rlim_cur != RLIM_INFINITY &&
+		    (ctx->maxopen >= r.rlim_cur ||
+		     r.rlim_cur - ctx->maxopen < 16U)) {
+			ctx->maxopen = r.rlim_cur > 32U ? r.rlim_cur - 16U : 16U;
+		}
+	}
+	if (ctx->maxopen == 0U) {
+		ctx->maxopen = 1U;
+	}
+	ctx->njobs = 1U;
+	if (argi->jobs_arg) {
+		long int nj = strtol(argi->jobs_arg, NULL, 10);
+
+		if (nj <= 0) {
+			/* use all the cpus */
+			nj = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		ctx->njobs = nj > 0 ? (size_t)nj : 1U;
+	}
 
 	/* check explosion options */
 	if (argi->explode_by_interval_arg && argi->explode_by_symbol_flag) {
@@ -551,7 +805,12 @@ run the other option on the generated files\n");
 
 	/* clear out rcources */
 	if (ctx->out != NULL) {
-		ute_close(ctx->out);
+		close_out(ctx, ctx->out);
+	}
+	/* and wait for the finalisers */
+	wait_all();
+	if (kids != NULL) {
+		free(kids);
 	}
 
 out:
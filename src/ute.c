@@ -80,9 +80,9 @@ DEFCMD(sort)(int UNUSED(argc), char *argv[])
 {
 	const char *file = argv[1];
 	void *hdl = ute_open(file, UO_RDWR);
-	ute_sort(hdl);
+	int rc = ute_sort(hdl) < 0;
 	ute_close(hdl);
-	return 0;
+	return rc;
 }
 
 DEFCMD(version)(int UNUSED(argc), char *UNUSED(argv)[])
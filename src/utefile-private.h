@@ -106,11 +106,28 @@ struct utectx_s {
 		struct uteftr_cell_s *c;
 	} ftr[1];
 
+	/* page key ranges, lets the sort planner skip page payloads */
+	struct {
+		size_t z;
+		struct uteftr_krng_s *k;
+	} pgk[1];
+
+	/* page checksums, crc32c of each page as it is on the disk */
+	struct {
+		size_t z;
+		uint32_t *s;
+		/* pages below this one haven't changed since loading */
+		size_t nclean;
+	} pgs[1];
+
 	/* iter magic */
 	struct {
 		unsigned int iter_st;
 		sidx_t iter_si;
 		struct __gen_s iter_tmp;
+		/* full symbol index of the last yielded tick */
+		unsigned int iter_widx;
+		scom_t iter_last;
 	};
 };
 
@@ -132,6 +149,15 @@ extern void bump_header(struct utehdr2_s *hdr);
  * Add the tick T to the ute context specified by CTX, using the header in H. */
 extern void ute_add_tick_as(utectx_t ctx, scom_t t, scom_t h);
 
+/**
+ * Add NSNDWCHS sandwiches of sorted ticks at T to CTX in bulk. */
+extern void ute_add_ticks(utectx_t ctx, const void *t, size_t nsndwchs);
+
+/**
+ * Compute the checksum of page PG of CTX as it is on the disk into CRC.
+ * Return -1 if the page cannot be mapped. */
+extern int page_crc(uint32_t *crc, utectx_t ctx, uint32_t pg);
+
 /**
  * Compress (whatever that means) BSZ bytes in BUF. */
 extern ssize_t
@@ -214,6 +240,30 @@ page_sizet(const_utectx_t ctx, uint32_t page)
 	return page_size(ctx, page) / sizeof(*ctx->seek->sp);
 }
 
+static inline __attribute__((pure)) const struct uteftr_krng_s*
+page_krng(const_utectx_t ctx, uint32_t page)
+{
+/* Return the persisted key range of the PAGE-th page in CTX or NULL. */
+	const size_t nk = ctx->pgk->z / sizeof(*ctx->pgk->k);
+
+	if (page >= ctx->npages || page >= nk || !ctx->pgk->k[page].lo) {
+		return NULL;
+	}
+	return ctx->pgk->k + page;
+}
+
+static inline __attribute__((pure)) const uint32_t*
+page_csum(const_utectx_t ctx, uint32_t page)
+{
+/* Return the persisted checksum of the PAGE-th page in CTX or NULL. */
+	const size_t ns = ctx->pgs->z / sizeof(*ctx->pgs->s);
+
+	if (page >= ctx->npages || page >= ns) {
+		return NULL;
+	}
+	return ctx->pgs->s + page;
+}
+
 static inline bool
 ute_sorted_p(const_utectx_t ctx)
 {
@@ -54,6 +54,7 @@
 #include "utetpc.h"
 #include "mem.h"
 #include "boobs.h"
+#include "crc32c.h"
 
 #if defined HAVE_LZMA_H
 # include <lzma.h>
@@ -89,10 +90,12 @@
 static inline size_t
 __local_scom_tick_size(scom_t t)
 {
-	assert((t->ttf & 0x30U) != 0x30U);
-
 	if (!(scom_thdr_ttf(t) & (SCOM_FLAG_LM | SCOM_FLAG_L2M))) {
 		return 1UL;
+	} else if (scom_thdr_widx_p(t)) {
+		/* wide index sandwiches never come in pairs */
+		assert(!scom_thdr_widx_p(scom_widx_tick(t)));
+		return 1UL + __local_scom_tick_size(scom_widx_tick(t));
 	} else if (scom_thdr_ttf(t) & SCOM_FLAG_LM) {
 		return 2UL;
 	} else if (scom_thdr_ttf(t) & SCOM_FLAG_L2M) {
@@ -170,6 +173,66 @@ get_ftr_size(const_utectx_t ctx)
 	return 0U;
 }
 
+static __attribute__((pure)) size_t
+get_pgk_size(const_utectx_t ctx)
+{
+/* retrieve the size of the page key table in native endianness */
+	utehdr2_t hdr = ctx->hdrc;
+
+	switch (utehdr_endianness(hdr)) {
+	case UTE_ENDIAN_UNK:
+	case UTE_ENDIAN_LITTLE:
+		return le32toh(hdr->pgk_sz);
+	case UTE_ENDIAN_BIG:
+		return be32toh(hdr->pgk_sz);
+	default:
+		break;
+	}
+	return 0U;
+}
+
+static __attribute__((pure)) off_t
+get_pgk_off(const_utectx_t ctx)
+{
+/* get the offset of the page key table, it's the last thing in the file
+ * once the page checksums have been read */
+	const size_t tz = sizeof(*ctx->seek->sp);
+	size_t cand = ctx->fsz - get_pgk_size(ctx);
+
+	/* round down to previous TZ multiple */
+	return cand & ~(tz - 1);
+}
+
+static __attribute__((pure)) size_t
+get_pgs_size(const_utectx_t ctx)
+{
+/* retrieve the size of the page checksum table in native endianness */
+	utehdr2_t hdr = ctx->hdrc;
+
+	switch (utehdr_endianness(hdr)) {
+	case UTE_ENDIAN_UNK:
+	case UTE_ENDIAN_LITTLE:
+		return le32toh(hdr->pgs_sz);
+	case UTE_ENDIAN_BIG:
+		return be32toh(hdr->pgs_sz);
+	default:
+		break;
+	}
+	return 0U;
+}
+
+static __attribute__((pure)) off_t
+get_pgs_off(const_utectx_t ctx)
+{
+/* get the offset of the page checksums, they're the last thing in the
+ * file once the footer has been read */
+	const size_t tz = sizeof(*ctx->seek->sp);
+	size_t cand = ctx->fsz - get_pgs_size(ctx);
+
+	/* round down to previous TZ multiple */
+	return cand & ~(tz - 1);
+}
+
 static __attribute__((pure)) off_t
 get_ftr_off(const_utectx_t ctx)
 {
@@ -200,6 +263,24 @@ get_slut_size(const_utectx_t ctx)
 	return 0U;
 }
 
+static __attribute__((pure)) size_t
+get_slutx_size(const_utectx_t ctx)
+{
+/* retrieve the slut size as written along with the page tables */
+	utehdr2_t hdr = ctx->hdrc;
+
+	switch (utehdr_endianness(hdr)) {
+	case UTE_ENDIAN_UNK:
+	case UTE_ENDIAN_LITTLE:
+		return le32toh(hdr->slutx_sz);
+	case UTE_ENDIAN_BIG:
+		return be32toh(hdr->slutx_sz);
+	default:
+		break;
+	}
+	return 0U;
+}
+
 static __attribute__((pure)) off_t
 get_slut_off(const_utectx_t ctx)
 {
@@ -669,6 +750,41 @@ seek_get_offs(utectx_t ctx, uint32_t pg)
 	return (struct sk_offs_s){off, len};
 }
 
+static inline void
+dirty_pgs(utectx_t ctx, size_t pg)
+{
+/* page PG (and everything behind it) needs checksumming again */
+	if (pg < ctx->pgs->nclean) {
+		ctx->pgs->nclean = pg;
+	}
+	return;
+}
+
+int
+page_crc(uint32_t *crc, utectx_t ctx, uint32_t pg)
+{
+/* checksum page PG of CTX byte by byte as it is on the disk */
+	struct sk_offs_s offs = seek_get_offs(ctx, pg);
+	void *p;
+
+	if (UNLIKELY(offs.foff >= ctx->fsz)) {
+		return -1;
+	} else if (offs.foff + offs.flen > ctx->fsz) {
+		/* the last page might be short */
+		offs.flen = ctx->fsz - offs.foff;
+	}
+	if (UNLIKELY(offs.flen == 0U)) {
+		return -1;
+	}
+	p = mmap_any(ctx->fd, PROT_READ, MAP_SHARED, offs.foff, offs.flen);
+	if (UNLIKELY(p == NULL)) {
+		return -1;
+	}
+	*crc = crc32c(0U, p, offs.flen);
+	munmap_any(p, offs.foff, offs.flen);
+	return 0;
+}
+
 int
 seek_page(uteseek_t sk, utectx_t ctx, uint32_t pg)
 {
@@ -703,6 +819,9 @@ seek_page(uteseek_t sk, utectx_t ctx, uint32_t pg)
 	p = mmap_any(ctx->fd, pflags, MAP_SHARED, offs.foff, offs.flen);
 	if (UNLIKELY(p == NULL)) {
 		return -1;
+	} else if (pflags & PROT_WRITE) {
+		/* no telling what the caller does to it */
+		dirty_pgs(ctx, pg);
 	}
 
 	/* check for compression, even if lzma isn't available */
@@ -826,6 +945,7 @@ static void
 store_slut(utectx_t ctx, size_t sluz)
 {
 	struct utehdr2_s *h;
+	uint16_t nsyms;
 
 	if (!(ctx->oflags & UO_STREAM)) {
 		h = ctx->hdrc;
@@ -834,15 +954,23 @@ store_slut(utectx_t ctx, size_t sluz)
 		h = ctx->hdrp;
 	}
 
+	if (LIKELY(ctx->slut->nsyms <= UINT16_MAX)) {
+		nsyms = (uint16_t)ctx->slut->nsyms;
+	} else {
+		/* doesn't fit, readers will have to ask the slut */
+		h->flags |= UTEHDR_FLAG_WIDEIDX;
+		nsyms = 0U;
+	}
+
 	switch (utehdr_endianness(h)) {
 	case UTE_ENDIAN_UNK:
 	case UTE_ENDIAN_LITTLE:
 		h->slut_sz = htole32(sluz);
-		h->slut_nsyms = htole16((uint16_t)ctx->slut->nsyms);
+		h->slut_nsyms = htole16(nsyms);
 		break;
 	case UTE_ENDIAN_BIG:
 		h->slut_sz = htobe32(sluz);
-		h->slut_nsyms = htobe16((uint16_t)ctx->slut->nsyms);
+		h->slut_nsyms = htobe16(nsyms);
 		break;
 	default:
 		h->slut_sz = 0U;
@@ -880,6 +1008,70 @@ store_ftrz(utectx_t ctx, size_t z)
 	return;
 }
 
+static void
+store_pgkz(utectx_t ctx, size_t z)
+{
+	struct utehdr2_s *h = ctx->hdrc;
+
+	switch (utehdr_endianness(h)) {
+	case UTE_ENDIAN_UNK:
+	case UTE_ENDIAN_LITTLE:
+		h->pgk_sz = htole32(z);
+		break;
+	case UTE_ENDIAN_BIG:
+		h->pgk_sz = htobe32(z);
+		break;
+	default:
+		h->pgk_sz = 0U;
+		break;
+	}
+	return;
+}
+
+static void
+store_pgsz(utectx_t ctx, size_t z)
+{
+	struct utehdr2_s *h = ctx->hdrc;
+
+	switch (utehdr_endianness(h)) {
+	case UTE_ENDIAN_UNK:
+	case UTE_ENDIAN_LITTLE:
+		h->pgs_sz = htole32(z);
+		break;
+	case UTE_ENDIAN_BIG:
+		h->pgs_sz = htobe32(z);
+		break;
+	default:
+		h->pgs_sz = 0U;
+		break;
+	}
+	return;
+}
+
+static void
+store_slutz(utectx_t ctx, size_t sluz, size_t slutxz)
+{
+/* like store_slut() but only the sizes, of the slut and its tables */
+	struct utehdr2_s *h = ctx->hdrc;
+
+	switch (utehdr_endianness(h)) {
+	case UTE_ENDIAN_UNK:
+	case UTE_ENDIAN_LITTLE:
+		h->slut_sz = htole32(sluz);
+		h->slutx_sz = htole32(slutxz);
+		break;
+	case UTE_ENDIAN_BIG:
+		h->slut_sz = htobe32(sluz);
+		h->slutx_sz = htobe32(slutxz);
+		break;
+	default:
+		h->slut_sz = 0U;
+		h->slutx_sz = 0U;
+		break;
+	}
+	return;
+}
+
 #define PROT_FLUSH	(PROT_READ | PROT_WRITE)
 #define MAP_FLUSH	(MAP_SHARED)
 
@@ -911,9 +1103,8 @@ free_tpc(utetpc_t tpc)
 {
 	if (tpc_active_p(tpc)) {
 		/* seek points to something -> munmap first
-		 * we should probably determine the size of the tpc using the
-		 * CAP slot and round it to the next UTE_BLKSZ multiple */
-		munmap(tpc->sk.sp, UTE_BLKSZ);
+		 * same size as in make_tpc() */
+		munmap(tpc->sk.sp, UTE_BLKSZ * sizeof(*tpc->sk.sp));
 	}
 	tpc->sk.si = -1;
 	tpc->sk.szrw = 0;
@@ -1046,6 +1237,239 @@ flush_hdr(utectx_t ctx)
 	return;
 }
 
+/* page key table handling */
+static void
+add_pgk(utectx_t ctx, uint32_t pg, struct uteftr_krng_s k)
+{
+/* auto-resizing */
+	struct uteftr_krng_s *keys;
+	size_t nkeys = ctx->pgk->z / sizeof(*keys);
+
+	/* resize? */
+	if (UNLIKELY(pg >= nkeys)) {
+		size_t nxpg = ((pg / 16U) + 1U) * 16U;
+		ctx->pgk->k = realloc(ctx->pgk->k, nxpg * sizeof(*keys));
+		memset(ctx->pgk->k + nkeys, 0, (nxpg - nkeys) * sizeof(*keys));
+		ctx->pgk->z = nxpg * sizeof(*keys);
+	}
+	/* now we're clear to go */
+	ctx->pgk->k[pg] = k;
+	return;
+}
+
+static void
+free_pgk(utectx_t ctx)
+{
+	if (ctx->pgk->k != NULL) {
+		free(ctx->pgk->k);
+		ctx->pgk->k = NULL;
+		ctx->pgk->z = 0UL;
+	}
+	return;
+}
+
+static struct uteftr_krng_s
+seek_krng(uteseek_t sk)
+{
+/* key range of the (sorted) ticks in SK */
+	struct uteftr_krng_s res = {0U, 0U};
+
+	for (sidx_t i = 0, tsz; i < sk->si; i += tsz) {
+		scom_t t = AS_SCOM(sk->sp + i);
+
+		if (UNLIKELY(!res.lo)) {
+			res.lo = t->u;
+		}
+		res.hi = t->u;
+		tsz = scom_tick_size(t);
+	}
+	return res;
+}
+
+static size_t
+flush_pgk(utectx_t ctx)
+{
+/* write the page key table behind the slut, return the number of bytes
+ * the file grew, only bother if there's more than one page and every
+ * page has keys */
+	const struct uteftr_krng_s *pgk;
+	size_t npg;
+
+	/* dont try at all in read-only mode */
+	if (UNLIKELY(!__rdwrp(ctx))) {
+		return 0U;
+	} else if (UNLIKELY((pgk = ctx->pgk->k) == NULL)) {
+		return 0U;
+	} else if ((npg = ute_npages(ctx)) <= 1U) {
+		/* nothing to plan for */
+		return 0U;
+	} else if (UNLIKELY(ctx->pgk->z < npg * sizeof(*pgk))) {
+		UDEBUG("page key table too small, not dumping %zu\n",
+		       ctx->pgk->z);
+		return 0U;
+	}
+	for (size_t i = 0; i < npg; i++) {
+		if (UNLIKELY(!pgk[i].lo)) {
+			/* incomplete, better not write anything */
+			return 0U;
+		}
+	}
+	/* otherwise write exactly NPG key ranges to the disk */
+	{
+		size_t pgkz = npg * sizeof(*pgk);
+		size_t fsz = ctx->fsz;
+		char *p;
+
+		if (ute_extend(ctx, pgkz) < 0) {
+			return 0U;
+		}
+
+		UDEBUG("writing %zu page key bytes\n", pgkz);
+		p = mmap_any(ctx->fd, PROT_FLUSH, MAP_FLUSH, fsz, pgkz);
+		if (UNLIKELY(p == NULL)) {
+			/* grown nonetheless */
+			return ctx->fsz - fsz;
+		}
+		if (LIKELY(utehdr_check_endianness(ctx->hdrc) == 0)) {
+			memcpy(p, pgk, pgkz);
+		} else {
+			struct uteftr_krng_s *fk = (void*)p;
+
+			for (size_t i = 0; i < npg; i++) {
+				fk[i].lo = htooe64(pgk[i].lo);
+				fk[i].hi = htooe64(pgk[i].hi);
+			}
+		}
+		munmap_any(p, fsz, pgkz);
+
+		/* make sure we put the info in the file header */
+		store_pgkz(ctx, pgkz);
+		return ctx->fsz - fsz;
+	}
+}
+
+/* page checksum handling */
+static void
+free_pgs(utectx_t ctx)
+{
+	if (ctx->pgs->s != NULL) {
+		free(ctx->pgs->s);
+		ctx->pgs->s = NULL;
+		ctx->pgs->z = 0UL;
+	}
+	ctx->pgs->nclean = 0UL;
+	return;
+}
+
+static void
+calc_pgs(utectx_t ctx)
+{
+/* checksum all pages that might have changed since they were loaded,
+ * must be called while the pages are the last thing in the file,
+ * i.e. before the slut and the footer go out */
+	size_t npg;
+	size_t nc;
+	uint32_t *s;
+
+	if (UNLIKELY(!__rdwrp(ctx))) {
+		goto free;
+	} else if (!(ctx->hdrc->flags & UTEHDR_FLAG_CHECKSUM)) {
+		/* not asked for */
+		goto free;
+	} else if (ctx->oflags & (UO_ANON | UO_STREAM)) {
+		/* noone's ever going to check, or no telling what's changed */
+		goto free;
+	} else if (UNLIKELY((npg = ute_npages(ctx)) == 0U)) {
+		goto free;
+	} else if ((s = realloc(ctx->pgs->s, npg * sizeof(*s))) == NULL) {
+		goto free;
+	}
+	/* checksums of clean pages can stay */
+	nc = ctx->pgs->z / sizeof(*s);
+	nc = ctx->pgs->nclean < nc ? ctx->pgs->nclean : nc;
+	nc = npg < nc ? npg : nc;
+	ctx->pgs->s = s;
+	for (size_t i = nc; i < npg; i++) {
+		if (UNLIKELY(page_crc(s + i, ctx, i) < 0)) {
+			/* rather have no checksums than wrong ones */
+			goto free;
+		}
+	}
+	UDEBUG("checksummed %zu of %zu pages\n", npg - nc, npg);
+	ctx->pgs->z = npg * sizeof(*s);
+	ctx->pgs->nclean = npg;
+	return;
+free:
+	/* old checksums are useless now */
+	free_pgs(ctx);
+	return;
+}
+
+static size_t
+flush_pgs(utectx_t ctx)
+{
+/* write the page checksums behind the page keys, return the number of
+ * bytes the file grew */
+	const size_t pgsz = ctx->pgs->z;
+	const size_t fsz = ctx->fsz;
+	uint32_t *p;
+
+	if (UNLIKELY(!__rdwrp(ctx))) {
+		return 0U;
+	} else if (ctx->pgs->s == NULL || pgsz != ute_npages(ctx) * sizeof(*p)) {
+		/* don't write anything that doesn't match the pages */
+		return 0U;
+	} else if (ute_extend(ctx, pgsz) < 0) {
+		return 0U;
+	}
+
+	UDEBUG("writing %zu page checksum bytes\n", pgsz);
+	p = mmap_any(ctx->fd, PROT_FLUSH, MAP_FLUSH, fsz, pgsz);
+	if (UNLIKELY(p == NULL)) {
+		/* grown nonetheless */
+		return ctx->fsz - fsz;
+	}
+	if (LIKELY(utehdr_check_endianness(ctx->hdrc) == 0)) {
+		memcpy(p, ctx->pgs->s, pgsz);
+	} else {
+		for (size_t i = 0; i < pgsz / sizeof(*p); i++) {
+			p[i] = htooe32(ctx->pgs->s[i]);
+		}
+	}
+	munmap_any(p, fsz, pgsz);
+
+	/* make sure we put the info in the file header */
+	store_pgsz(ctx, pgsz);
+	return ctx->fsz - fsz;
+}
+
+static void
+flush_tbls(utectx_t ctx)
+{
+/* write page keys and checksums right behind the slut and have slut_sz
+ * cover them, readers that don't know about them will skip them that
+ * way, must be called after flush_slut() and before flush_ftr() */
+	size_t sluz;
+
+	if (UNLIKELY(!__rdwrp(ctx))) {
+		return;
+	} else if (ctx->oflags & UO_STREAM) {
+		/* the slut's been flushed all along, nowhere to put them */
+		return;
+	} else if (!get_slut_size(ctx)) {
+		/* no slut to hide them in */
+		return;
+	}
+	/* start out with the aligned slut size */
+	sluz = ctx->sluz;
+	sluz += flush_pgk(ctx);
+	sluz += flush_pgs(ctx);
+	if (sluz > ctx->sluz) {
+		store_slutz(ctx, sluz, sluz);
+	}
+	return;
+}
+
 static void MAYBE_NOINLINE
 flush_tpc(utectx_t ctx)
 {
@@ -1066,7 +1490,8 @@ flush_tpc(utectx_t ctx)
 
 			assert(t->u);
 			assert(t->u != -1ULL);
-			assert((t->ttf & 0x30U) != 0x30U);
+			assert(!scom_thdr_widx_p(t) ||
+			       !scom_thdr_widx_p(scom_widx_tick(t)));
 			assert(thresh <= t->u);
 			thresh = t->u;
 			tsz = scom_tick_size(t);
@@ -1124,6 +1549,10 @@ flush_tpc(utectx_t ctx)
 			memset(p + sisz, MARKER_TICK, sz - sisz);
 		}
 		munmap_any(p, fsz, sz);
+		/* remember the key range for the sort planner */
+		add_pgk(ctx, ctx->npages, seek_krng(&ctx->tpc->sk));
+		/* and that its checksum is yet to be done */
+		dirty_pgs(ctx, ctx->npages);
 		/* up the npages counter */
 		ctx->npages++;
 	}
@@ -1552,10 +1981,22 @@ lzma_decomp(utectx_t ctx)
 	tgt->fsz = fo;
 	tgt->hdrc->flags &= ~UTEHDR_FLAG_COMPRESSED;
 
+	/* page keys don't change by decompressing */
+	for (size_t i = 0; i < npg; i++) {
+		const struct uteftr_krng_s *kr;
+
+		if ((kr = page_krng(ctx, i)) != NULL) {
+			add_pgk(tgt, i, *kr);
+		}
+	}
 	/* clone the slut */
 	ute_clone_slut(tgt, ctx);
+	/* checksummed files stay checksummed */
+	tgt->hdrc->flags |= ctx->hdrc->flags & UTEHDR_FLAG_CHECKSUM;
 	/* close the target, do the rename and everything */
 	ute_close(tgt);
+	/* CTX's inode has been unlinked, spare it the checksumming */
+	ctx->oflags |= UO_ANON;
 	return;
 }
 
@@ -1705,6 +2146,127 @@ load_slut(utectx_t ctx)
 	return;
 }
 
+static void
+load_pgs(utectx_t ctx)
+{
+/* read the page checksums off the end of the file */
+	const size_t pgsz = get_pgs_size(ctx);
+	const off_t off = get_pgs_off(ctx);
+	const int pflags = __pflags(ctx);
+	uint32_t *p;
+
+	if (UNLIKELY(ctx->fsz <= UTEHDR_MIN_SIZE)) {
+		return;
+	} else if (pgsz == 0UL) {
+		return;
+	}
+
+	p = mmap_any(ctx->fd, pflags, MAP_FLUSH, off, pgsz);
+	if (LIKELY(p != NULL)) {
+		const size_t npg = pgsz / sizeof(*p);
+
+		if (LIKELY((ctx->pgs->s = malloc(pgsz)) != NULL)) {
+			for (size_t i = 0; i < npg; i++) {
+				switch (utehdr_endianness(ctx->hdrc)) {
+				case UTE_ENDIAN_UNK:
+				case UTE_ENDIAN_LITTLE:
+					ctx->pgs->s[i] = le32toh(p[i]);
+					break;
+				case UTE_ENDIAN_BIG:
+					ctx->pgs->s[i] = be32toh(p[i]);
+					break;
+				default:
+					ctx->pgs->s[i] = 0U;
+					break;
+				}
+			}
+			ctx->pgs->z = pgsz;
+			/* until proven otherwise */
+			ctx->pgs->nclean = npg;
+		}
+		munmap_any(p, off, pgsz);
+	}
+
+	/* real shrink is too dangerous, just adapt fsz instead */
+	ute_shrink(ctx, pgsz);
+	/* act as though we don't have checksums */
+	ctx->hdrc->pgs_sz = 0U;
+	return;
+}
+
+static void
+load_pgk(utectx_t ctx)
+{
+/* read the page key table off the end of the file */
+	const size_t pgkz = get_pgk_size(ctx);
+	const off_t off = get_pgk_off(ctx);
+	const int pflags = __pflags(ctx);
+	char *pgk;
+
+	if (UNLIKELY(ctx->fsz <= UTEHDR_MIN_SIZE)) {
+		return;
+	} else if (LIKELY(pgkz == 0UL)) {
+		return;
+	}
+
+	pgk = mmap_any(ctx->fd, pflags, MAP_FLUSH, off, pgkz);
+	if (LIKELY(pgk != NULL)) {
+		const size_t npg = pgkz / sizeof(*ctx->pgk->k);
+		const struct uteftr_krng_s *fk = (void*)pgk;
+
+		for (size_t i = 0; i < npg; i++) {
+			struct uteftr_krng_s tmp;
+
+			switch (utehdr_endianness(ctx->hdrc)) {
+			case UTE_ENDIAN_UNK:
+			case UTE_ENDIAN_LITTLE:
+				tmp.lo = le64toh(fk[i].lo);
+				tmp.hi = le64toh(fk[i].hi);
+				break;
+			case UTE_ENDIAN_BIG:
+				tmp.lo = be64toh(fk[i].lo);
+				tmp.hi = be64toh(fk[i].hi);
+				break;
+			default:
+				tmp.lo = tmp.hi = 0U;
+				break;
+			}
+
+			add_pgk(ctx, i, tmp);
+		}
+		munmap_any(pgk, off, pgkz);
+	}
+
+	/* real shrink is too dangerous, just adapt fsz instead */
+	ute_shrink(ctx, pgkz);
+	/* act as though we don't have a key table */
+	ctx->hdrc->pgk_sz = 0U;
+	return;
+}
+
+static void
+load_tbls(utectx_t ctx)
+{
+/* read page checksums and keys off the end of the slut, unless a writer
+ * that doesn't know about them has rewritten the slut since */
+	const size_t sluz = get_slut_size(ctx);
+	const size_t fsz = ctx->fsz;
+
+	if (!sluz || get_slutx_size(ctx) != sluz) {
+		/* act as though we don't have any */
+		ctx->hdrc->pgs_sz = 0U;
+		ctx->hdrc->pgk_sz = 0U;
+		ctx->hdrc->slutx_sz = 0U;
+		return;
+	}
+	/* must be in this order because they shrink the file */
+	load_pgs(ctx);
+	load_pgk(ctx);
+	/* what's left is the slut proper */
+	store_slutz(ctx, sluz - (fsz - ctx->fsz), 0U);
+	return;
+}
+
 static void
 load_ftr(utectx_t ctx)
 {
@@ -1866,9 +2428,11 @@ make_utectx(const char *fn, int fd, int oflags)
 		res->lvtd = SMALLEST_LVTD;
 		make_slut(res->slut);
 	} else {
-		/* load the footer, then the slut
-		 * must be in this order because they shrink the file */
+		/* load the footer, the page checksums and keys, then
+		 * the slut, must be in this order because they shrink
+		 * the file */
 		load_ftr(res);
+		load_tbls(res);
 		load_slut(res);
 	}
 	/* load the last page as tpc */
@@ -1928,15 +2492,6 @@ ute_mktemp(int oflags)
 	return make_utectx(tmpfn, resfd, oflags);
 }
 
-static void
-ute_prep_sort(utectx_t ctx)
-{
-/* this is probably the worst we can do */
-	/* delete the file */
-	unlink(ctx->fname);
-	return;
-}
-
 void
 ute_free(utectx_t ctx)
 {
@@ -1951,6 +2506,8 @@ ute_free(utectx_t ctx)
 	fini_tpc();
 	/* finalise ftr */
 	free_ftr(ctx);
+	free_pgk(ctx);
+	free_pgs(ctx);
 
 	/* now proceed to closing and finalising */
 	close_hdr(ctx);
@@ -1983,27 +2540,35 @@ ute_close(utectx_t ctx)
 		ute_trunc(ctx, ctx->fsz);
 	}
 	if (!ute_sorted_p(ctx)) {
-		ute_prep_sort(ctx);
-		ute_sort(ctx);
-		ute_unset_unsorted(ctx);
+		/* if this fails the file stays as is, i.e. unsorted */
+		if (ute_sort(ctx) == 0) {
+			ute_unset_unsorted(ctx);
+		}
 	}
 #if defined AUTO_TILMAN_COMP
 	/* tilman compress the file, needs to happen after sorting */
+	dirty_pgs(ctx, 0U);
 	tilman_comp(ctx);
 #endif	/* AUTO_TILMAN_COMP */
 	if (ctx->hdrc->flags & UTEHDR_FLAG_COMPRESSED &&
 	    ctx->hdrc->flags & UTEHDR_FLAG_DIRTY) {
-		/* final compression */
+		/* final compression, changes every page on the disk */
+		dirty_pgs(ctx, 0U);
 		lzma_comp(ctx);
 	} else if (!(ctx->hdrc->flags & UTEHDR_FLAG_COMPRESSED) &&
 		   ctx->hdrp && (ctx->hdrp->flags & UTEHDR_FLAG_COMPRESSED) &&
 		   (ctx->hdrc->flags & UTEHDR_FLAG_DIRTY)) {
 		/* we're asked for decompression */
 		ctx->hdrc->flags |= UTEHDR_FLAG_COMPRESSED;
+		dirty_pgs(ctx, 0U);
 		lzma_decomp(ctx);
 	}
+	/* checksum the pages while they're the last thing in the file */
+	calc_pgs(ctx);
 	/* serialise the slut */
 	flush_slut(ctx);
+	/* serialise the page keys and checksums as part of the slut */
+	flush_tbls(ctx);
 	/* serialise the footer */
 	flush_ftr(ctx);
 	if (!(ctx->oflags & UO_STREAM)) {
@@ -2062,15 +2627,31 @@ ute_empty_slut(utectx_t ctx)
 
 
 /* accessor */
+static void
+flush_full_tpc(utectx_t ctx)
+{
+/* the tpc can't take the next tick, pad it and write it out */
+	uteseek_t sk = &ctx->tpc->sk;
+	/* the first page is shorter than its mapping */
+	size_t nleap = ctx->tpc->cap - sk->si;
+
+	UDEBUGvv("tpc full (has: %zut/%zut)\n", sk->si, sk->si + nleap);
+	assert(ctx->tpc->cap >= sk->si);
+	seek_rewind(sk, nleap);
+	ute_flush(ctx);
+	return;
+}
+
 void
 ute_add_tick(utectx_t ctx, scom_t t)
 {
 	size_t tsz;
 
 	/* never trust your users, inspect the tick */
-	if (UNLIKELY((t->ttf & 0x30U) == 0x30U)) {
+	if (UNLIKELY(scom_thdr_widx_p(t) &&
+		     scom_thdr_widx_p(scom_widx_tick(t)))) {
 		error("\
-this version of uterus cannot cope with tick type %x", t->ttf);
+wide index sandwich not followed by a tick");
 		return;
 	} else if (UNLIKELY(t->u == -1ULL)) {
 		error("invalid tick");
@@ -2080,14 +2661,7 @@ this version of uterus cannot cope with tick type %x", t->ttf);
 	tsz = scom_tick_size(t);
 	assert(tpc_active_p(ctx->tpc));
 	if (!tpc_can_hold_p(ctx->tpc, tsz)) {
-		/* great, compute the number of leap ticks */
-		uteseek_t sk = &ctx->tpc->sk;
-		size_t nleap = sk->szrw / sizeof(*sk->sp) - sk->si;
-
-		UDEBUGvv("tpc full (has: %zut/%zut)\n", sk->si, sk->si + nleap);
-		assert(sk->szrw / sizeof(*sk->sp) >= sk->si);
-		seek_rewind(sk, nleap);
-		ute_flush(ctx);
+		flush_full_tpc(ctx);
 	}
 	/* and now it's just passing on everything to the tpc adder */
 	tpc_add(ctx->tpc, t, tsz);
@@ -2113,20 +2687,86 @@ this version of uterus cannot cope with tick type %x", h->ttf);
 	tsz = scom_tick_size(h);
 	assert(tpc_active_p(ctx->tpc));
 	if (!tpc_can_hold_p(ctx->tpc, tsz)) {
-		/* great, compute the number of leap ticks */
-		uteseek_t sk = &ctx->tpc->sk;
-		size_t nleap = sk->szrw / sizeof(*sk->sp) - sk->si;
-
-		UDEBUGvv("tpc full (has: %zut/%zut)\n", sk->si, sk->si + nleap);
-		assert(sk->szrw / sizeof(*sk->sp) >= sk->si);
-		seek_rewind(sk, nleap);
-		ute_flush(ctx);
+		flush_full_tpc(ctx);
 	}
 	/* and now it's just passing on everything to the tpc adder */
 	tpc_add_as(ctx->tpc, t, h, tsz);
 	return;
 }
 
+void
+ute_add_ticks(utectx_t ctx, const void *t, size_t nsndwchs)
+{
+/* add NSNDWCHS sandwiches worth of sorted ticks, page-wise */
+	const struct sndwch_s *sp = t;
+	const struct sndwch_s *const ep = sp + nsndwchs;
+
+	assert(tpc_active_p(ctx->tpc));
+	while (sp < ep) {
+		const size_t room = ctx->tpc->cap - ctx->tpc->sk.si;
+		const struct sndwch_s *p = sp;
+		scom_t last = NULL;
+
+		/* find the largest run of whole ticks that fits */
+		for (size_t tsz; p < ep; p += tsz) {
+			tsz = scom_tick_size(AS_SCOM(p));
+			if ((size_t)(p - sp) + tsz > room) {
+				break;
+			}
+			last = AS_SCOM(p);
+		}
+		if (UNLIKELY(last == NULL)) {
+			if (UNLIKELY(!tpc_has_ticks_p(ctx->tpc))) {
+				/* tick won't fit in an empty page */
+				break;
+			}
+			flush_full_tpc(ctx);
+			continue;
+		}
+		tpc_add_run(ctx->tpc, AS_SCOM(sp), p - sp, last);
+		sp = p;
+	}
+	return;
+}
+
+void
+ute_add_tick_idx(utectx_t ctx, scom_t t, unsigned int idx)
+{
+/* add tick T under symbol index IDX, prepend a wide index if need be */
+	union {
+		union scom_thdr_u scom[1];
+		struct sndwch_s sp[5];
+	} tmp;
+
+	if (UNLIKELY(scom_thdr_widx_p(t))) {
+		/* we're only interested in the tick proper */
+		t = scom_widx_tick(t);
+	}
+	if (LIKELY(idx <= 0xffffU)) {
+		*tmp.scom = *AS_SCOM(t);
+		tmp.scom->idx = idx;
+		ute_add_tick_as(ctx, t, tmp.scom);
+		return;
+	}
+	/* wide index sandwich first, then the tick with the lower 16 bits */
+	scom_widx_fill(tmp.scom, t, idx);
+	memcpy(tmp.sp + 1, t, scom_byte_size(t));
+	AS_SCOM_THDR(tmp.sp + 1)->idx = idx;
+	ute_add_tick(ctx, tmp.scom);
+	return;
+}
+
+unsigned int
+ute_tblidx(utectx_t ctx, scom_t t)
+{
+	if (UNLIKELY(scom_thdr_widx_p(t))) {
+		return scom_widx(t);
+	} else if (t == ctx->iter_last) {
+		return ctx->iter_widx;
+	}
+	return scom_thdr_tblidx(t);
+}
+
 size_t
 ute_nticks(utectx_t ctx)
 {
@@ -2284,7 +2924,7 @@ ute_sym2idx(utectx_t ctx, const char *sym)
 const char*
 ute_idx2sym(utectx_t ctx, unsigned int idx)
 {
-	return slut_idx2sym(ctx->slut, (uint16_t)idx);
+	return slut_idx2sym(ctx->slut, idx);
 }
 
 unsigned int
@@ -2295,7 +2935,7 @@ ute_bang_symidx(utectx_t ctx, const char *sym, unsigned int idx)
 	if (UNLIKELY(sym == NULL)) {
 		return 0;
 	}
-	res = slut_bang(ctx->slut, sym, (uint16_t)idx);
+	res = slut_bang(ctx->slut, sym, idx);
 	if (ctx->oflags & UO_STREAM) {
 		/* banged sym in stream mode */
 		UDEBUG("banged sym in stream mode, flushing slut\n");
@@ -2360,13 +3000,91 @@ ute_stream_p(utectx_t ctx)
 }
 
 /* programmatic iterator */
+scom_t
+ute_iter_tick(utectx_t hdl, scom_t ti, size_t *tz)
+{
+#define st	(hdl->iter_st)
+#define tmp	(hdl->iter_tmp)
+	switch (st) {
+	case 3:;
+		/* we need to flip the ti */
+		size_t bz;
+
+		/* promote the old header, copy to tmp buffer BUF */
+		scom_promote_v01(tmp.scom, ti);
+		*tz = scom_tick_size(tmp.scom);
+		bz = scom_byte_size(tmp.scom) - sizeof(*ti);
+		/* copy the rest of the tick into the buffer */
+		memcpy(tmp.v, ti + 1, bz);
+		/* v0.1 files know nothing about wide indices */
+		hdl->iter_widx = scom_thdr_tblidx(tmp.scom);
+		hdl->iter_last = tmp.scom;
+		/* yield */
+		return tmp.scom;
+
+	case 2:;
+		/* properly padded for big-e and little-e */
+		size_t wz = 0U;
+
+		/* swap ti into buf */
+		tmp.scom->u = htooe64(ti->u);
+		if (UNLIKELY(scom_thdr_widx_p(tmp.scom))) {
+			/* keep the wide index, then swap its tick */
+			hdl->iter_widx = htooe32(AS_GEN(ti)->v[0]);
+			ti = scom_widx_tick(ti);
+			tmp.scom->u = htooe64(ti->u);
+			wz = 1U;
+		} else {
+			hdl->iter_widx = scom_thdr_tblidx(tmp.scom);
+		}
+		hdl->iter_last = tmp.scom;
+
+		switch ((*tz = scom_tick_size(tmp.scom))) {
+		case 2:
+			tmp.v[2] = htooe32(AS_GEN(ti)->v[2]);
+			tmp.v[3] = htooe32(AS_GEN(ti)->v[3]);
+			tmp.v[4] = htooe32(AS_GEN(ti)->v[4]);
+			tmp.v[5] = htooe32(AS_GEN(ti)->v[5]);
+		case 1:
+			tmp.v[0] = htooe32(AS_GEN(ti)->v[0]);
+			tmp.v[1] = htooe32(AS_GEN(ti)->v[1]);
+			break;
+		case 4:
+		default:
+			*tz = 1;
+			break;
+		}
+		*tz += wz;
+		/* yield */
+		return tmp.scom;
+
+	case 1:
+		*tz = scom_tick_size(ti);
+		if (UNLIKELY(scom_thdr_widx_p(ti))) {
+			/* yield the tick behind the wide index */
+			hdl->iter_widx = scom_widx(ti);
+			ti = scom_widx_tick(ti);
+		} else {
+			hdl->iter_widx = scom_thdr_tblidx(ti);
+		}
+		hdl->iter_last = ti;
+		/* yield */
+		return ti;
+
+	default:
+		abort();
+	}
+#undef tmp
+#undef st
+}
+
 scom_t
 ute_iter(utectx_t hdl)
 {
 #define st	(hdl->iter_st)
 #define si	(hdl->iter_si)
-#define tmp	(hdl->iter_tmp)
 	scom_t ti;
+	size_t tz;
 
 	if (UNLIKELY((ti = ute_seek(hdl, si)) == NULL)) {
 		st = 0;
@@ -2374,75 +3092,36 @@ ute_iter(utectx_t hdl)
 	} else if (ute_stream_p(hdl) && UNLIKELY(ti->u == 0U)) {
 		/* we're looking at the end of ticks in a growing file */
 		return NULL;
+	} else if (UNLIKELY(st == 0)) {
+		ute_iter_seek(hdl, 0);
 	}
+	ti = ute_iter_tick(hdl, ti, &tz);
+	/* inc the counter */
+	si += tz;
+	return ti;
+#undef si
+#undef st
+}
 
-	switch (st) {
-	case 0:
-		si = 0;
-		if (UNLIKELY(ute_version(hdl) == UTE_VERSION_01)) {
-			st = 3;
-		case 3:;
-			/* we need to flip the ti */
-			size_t bz;
-			size_t tz;
-
-			/* promote the old header, copy to tmp buffer BUF */
-			scom_promote_v01(tmp.scom, ti);
-			tz = scom_tick_size(tmp.scom);
-			bz = scom_byte_size(tmp.scom) - sizeof(*ti);
-			/* copy the rest of the tick into the buffer */
-			memcpy(tmp.v, ti + 1, bz);
-			/* inc the counter */
-			si += tz;
-			/* yield */
-			return tmp.scom;
-
-		} else if (UNLIKELY(ute_check_endianness(hdl) < 0)) {
-			st = 2;
-		case 2:;
-			/* properly padded for big-e and little-e */
-			size_t tz;
-
-			/* swap ti into buf */
-			tmp.scom->u = htooe64(ti->u);
-
-			switch ((tz = scom_tick_size(tmp.scom))) {
-			case 2:
-				tmp.v[2] = htooe32(AS_GEN(ti)->v[2]);
-				tmp.v[3] = htooe32(AS_GEN(ti)->v[3]);
-				tmp.v[4] = htooe32(AS_GEN(ti)->v[4]);
-				tmp.v[5] = htooe32(AS_GEN(ti)->v[5]);
-			case 1:
-				tmp.v[0] = htooe32(AS_GEN(ti)->v[0]);
-				tmp.v[1] = htooe32(AS_GEN(ti)->v[1]);
-				break;
-			case 4:
-			default:
-				tz = 1;
-				break;
-			}
-
-			/* inc the counter */
-			si += tz;
-			/* yield */
-			return tmp.scom;
-
-		} else {
-			st = 1;
-		case 1:
-			/* inc the counter */
-			si += scom_tick_size(ti);
-			/* yield */
-			return ti;
-		}
-
-	default:
-		abort();
+void
+ute_iter_seek(utectx_t hdl, sidx_t i)
+{
+/* like the initial state of ute_iter() but start at I instead of 0 */
+	if (UNLIKELY(ute_version(hdl) == UTE_VERSION_01)) {
+		hdl->iter_st = 3;
+	} else if (UNLIKELY(ute_check_endianness(hdl) < 0)) {
+		hdl->iter_st = 2;
+	} else {
+		hdl->iter_st = 1;
 	}
+	hdl->iter_si = i;
+	return;
+}
 
-#undef tmp
-#undef si
-#undef st
+sidx_t
+ute_iter_tell(utectx_t hdl)
+{
+	return hdl->iter_si;
 }
 
 
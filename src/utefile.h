@@ -159,6 +159,11 @@ extern scom_t ute_ffff2(utectx_t, sidx_t, unsigned int);
  * Add the tick T to the ute context specified by CTX. */
 extern void ute_add_tick(utectx_t ctx, scom_t t);
 
+/**
+ * Add the tick T under symbol index IDX to CTX.
+ * Indices beyond 65535 are stored in a wide index sandwich preceding T. */
+extern void ute_add_tick_idx(utectx_t ctx, scom_t t, unsigned int idx);
+
 /**
  * Return the (total) number of ticks stored in CTX. */
 extern size_t ute_nticks(utectx_t ctx);
@@ -187,13 +192,32 @@ extern size_t ute_nticks(utectx_t ctx);
  * A programmatic version of UTE_ITER. */
 extern scom_t ute_iter(utectx_t hdl);
 
+/**
+ * Reposition the iterator of HDL so that the next ute_iter() call
+ * yields the tick at index I, which must be on a tick boundary,
+ * like the beginning of a page. */
+extern void ute_iter_seek(utectx_t hdl, sidx_t i);
+
+/**
+ * Return the index of the tick the next ute_iter() call would yield. */
+extern sidx_t ute_iter_tell(utectx_t hdl);
+
+/**
+ * Return tick TI, as it is stored in the pages of HDL, the way ute_iter()
+ * would yield it, i.e. promoted, swapped or unwrapped, and set *TZ to
+ * the number of sandwiches TI occupies in the page.
+ * HDL's iterator must have been set up with ute_iter_seek(). */
+extern scom_t ute_iter_tick(utectx_t hdl, scom_t ti, size_t *tz);
+
 /**
  * Return the number of symbols tracked in CTX. */
 extern size_t ute_nsyms(utectx_t ctx);
 
 /**
- * Sort all ticks pages in the file. */
-extern void ute_sort(utectx_t ctx);
+ * Sort all ticks pages in the file.
+ * Return 0 on success, or -1 if the pages couldn't be read, in which
+ * case the file is left untouched. */
+extern int ute_sort(utectx_t ctx);
 
 /**
  * Clone the symbol look-up table (slut) from SRC to TGT. */
@@ -213,6 +237,15 @@ extern unsigned int ute_sym2idx(utectx_t ctx, const char *sym);
  * Given an index IDX return the symbol in the look-up table. */
 extern const char *ute_idx2sym(utectx_t ctx, unsigned int idx);
 
+/**
+ * Return the full symbol index of tick T as yielded by ute_iter().
+ * Unlike scom_thdr_tblidx() this honours wide index sandwiches.
+ * T must be a wide index sandwich or the very pointer the last call to
+ * ute_iter() on CTX returned, the wide index of a tick is kept in CTX
+ * until the next ute_iter() only, so for copies of a tick, or for ticks
+ * returned earlier, only the lower 16 bits of the index are returned. */
+extern unsigned int ute_tblidx(utectx_t ctx, scom_t t);
+
 /**
  * Associate SYM with index IDX in CTX's symbol look-up table.
  * Return the newly or previously associated index. */
@@ -49,6 +49,10 @@ typedef const struct utehdr2_s *utehdr2_t;
 #define UTEHDR_FLAG_COMPRESSED	8
 #define UTEHDR_FLAG_DIRTY	16
 #define UTEHDR_FLAG_STREAM	16
+/* symbol indices beyond 65535, ticks may be preceded by SCOM_FLAG_WIDX */
+#define UTEHDR_FLAG_WIDEIDX	32
+/* pages are checksummed, see pgs_sz */
+#define UTEHDR_FLAG_CHECKSUM	64
 
 struct utehdr2_s {
 	char magic[4];
@@ -73,7 +77,17 @@ struct utehdr2_s {
 	 * the footer contains page offsets and sizes
 	 * see struct uteftr2_s */
 	uint32_t ftr_sz;
-	char pad[64 - 32];
+	/* size of the page key table, placed behind the serialised slut
+	 * and counted in slut_sz, see struct uteftr_krng_s */
+	uint32_t pgk_sz;
+	/* size of the page checksum table, placed behind the page keys
+	 * and counted in slut_sz, one crc32c over the on-disk bytes per page */
+	uint32_t pgs_sz;
+	/* copy of slut_sz as written along with the tables above,
+	 * writers that don't know about the tables rewrite slut_sz but
+	 * leave this alone, a mismatch means the tables are gone */
+	uint32_t slutx_sz;
+	char pad[64 - 44];
 };
 
 #define UTEHDR_MIN_SIZE		(sizeof(struct utehdr2_s))
@@ -100,6 +114,13 @@ struct uteftr_cell_s {
 	uint32_t tlen;
 };
 
+struct uteftr_krng_s {
+	/** smallest key (scom u) on the page */
+	uint64_t lo;
+	/** largest key (scom u) on the page */
+	uint64_t hi;
+};
+
 
 /* public api */
 extern ute_ver_t utehdr_version(utehdr2_t);
@@ -128,4 +149,12 @@ utehdr_stream_p(utehdr2_t hdr)
 	return hdr->flags & UTEHDR_FLAG_STREAM;
 }
 
+/**
+ * Return true if symbol indices in the file headed by HDR exceed 16 bits. */
+static inline bool
+utehdr_wideidx_p(utehdr2_t hdr)
+{
+	return hdr->flags & UTEHDR_FLAG_WIDEIDX;
+}
+
 #endif	/* INCLUDED_utehdr_h_ */
@@ -85,8 +85,16 @@ resize_i2s(uteslut_t s, size_t at_least)
 {
 	size_t old, new;
 
-	/* alloc stepping is 128, 1024, 8192, 65536 */
-	if (at_least >= 8192) {
+	/* alloc stepping is 128, 1024, 8192, 65536,
+	 * then doubling for wide index files */
+	if (at_least >= 65536) {
+		size_t nu = 131072;
+
+		while (nu <= at_least) {
+			nu *= 2U;
+		}
+		at_least = nu;
+	} else if (at_least >= 8192) {
 		at_least = 65536;
 	} else if (at_least >= 1024) {
 		at_least = 8192;
@@ -172,24 +180,24 @@ __crea(uteslut_t s, const char *sym)
 	return res;
 }
 
-DEFUN uint16_t
+DEFUN uint32_t
 slut_sym2idx(uteslut_t s, const char *sym)
 {
 	uint32_t data[1];
-	uint16_t res;
+	uint32_t res;
 
 	/* make an alpha char array first */
 	if (slut_tg_get(s->stbl, sym, data) < 0) {
 		/* create a new entry */
-		res = (uint16_t)__crea(s, sym);
+		res = __crea(s, sym);
 	} else {
-		res = (uint16_t)(int32_t)data[0];
+		res = data[0];
 	}
 	return res;
 }
 
 DEFUN const char*
-slut_idx2sym(uteslut_t s, uint16_t idx)
+slut_idx2sym(uteslut_t s, uint32_t idx)
 {
 	slut_sym_t *itbl = s->itbl;
 	if (UNLIKELY(idx == 0 || idx > s->nsyms)) {
@@ -198,8 +206,8 @@ slut_idx2sym(uteslut_t s, uint16_t idx)
 	return itbl[idx];
 }
 
-DEFUN uint16_t
-slut_bang(uteslut_t s, const char *sym, uint16_t idx)
+DEFUN uint32_t
+slut_bang(uteslut_t s, const char *sym, uint32_t idx)
 {
 	uint32_t data;
 
@@ -222,7 +230,7 @@ slut_bang(uteslut_t s, const char *sym, uint16_t idx)
 		return idx;
 	}
 	/* otherwise just return what we've got */
-	return (uint16_t)data;
+	return data;
 }
 
 
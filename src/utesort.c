@@ -43,6 +43,7 @@
 #include <stdlib.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #if defined HAVE_SYS_TYPES_H
 /* for ssize_t */
 # include <sys/types.h>
@@ -286,7 +287,8 @@ load_runs(uteseek_t sks, utectx_t ctx, sidx_t sta, sidx_t end, size_t npg)
 			/* the seeker should not give us trailing naughts */
 			assert(t->u);
 			assert(t->u != -1ULL);
-			assert((t->ttf & 0x30U) != 0x30U);
+			assert(!scom_thdr_widx_p(t) ||
+			       !scom_thdr_widx_p(scom_widx_tick(t)));
 			assert(thresh <= t->u);
 			thresh = t->u;
 			tsz = scom_tick_size(t);
@@ -310,10 +312,7 @@ dump_runs(uteseek_t sks, utectx_t UNUSED(ctx), sidx_t s, sidx_t e, size_t npg)
 static strat_t MAYBE_NOINLINE
 sort_strat(utectx_t ctx)
 {
-/* could be configurable */
-#define NRUNS		64
 #define AS_VOID_PTR(x)	((void*)(long int)(x))
-	struct uteseek_s sks[NRUNS];
 	itree_t it = make_itree();
 	size_t npages = ute_npages(ctx);
 	strat_t s;
@@ -322,22 +321,33 @@ sort_strat(utectx_t ctx)
 	UDEBUG("generating a sort strategy for %zu (+%d) pages\n",
 	       npages, tpc_has_ticks_p(ctx->tpc));
 	npages += tpc_has_ticks_p(ctx->tpc);
-	for (size_t j = 0; j < npages; j += NRUNS) {
-		/* initialise the seeks */
-		load_runs(sks, ctx, j, j + NRUNS, npages);
-
-		/* obtain intervals */
-		for (size_t i = 0, k = j; i < NRUNS && k < npages; i++, k++) {
-			scom_t sb = seek_get_scom(sks + i);
-			scom_t se = seek_last_scom(sks + i);
-
-			assert(sb && se);
-			assert(sb->u <= se->u);
-			itree_add(it, sb->u, se->u, AS_VOID_PTR(k));
+	for (size_t k = 0; k < npages; k++) {
+		const struct uteftr_krng_s *kr;
+		struct uteseek_s sk[1];
+		scom_t sb;
+		scom_t se;
+
+		/* use the persisted key range if there is one */
+		if ((kr = page_krng(ctx, k)) != NULL) {
+			assert(kr->lo <= kr->hi);
+			itree_add(it, kr->lo, kr->hi, AS_VOID_PTR(k));
+			continue;
+		}
+		/* otherwise there's no way around loading the page */
+		if (load_runs(sk, ctx, k, k + 1U, npages) <= k) {
+			/* a strategy without page K would lose its ticks */
+			free_itree(it);
+			return NULL;
 		}
+		sb = seek_get_scom(sk);
+		se = seek_last_scom(sk);
 
-		/* finish off the seeks */
-		dump_runs(sks, ctx, j, j + NRUNS, npages);
+		assert(sb && se);
+		assert(sb->u <= se->u);
+		itree_add(it, sb->u, se->u, AS_VOID_PTR(k));
+
+		/* finish off the seek */
+		dump_runs(sk, ctx, k, k + 1U, npages);
 	}
 	/* run the strategy evaluator */
 	s = xnew(struct strat_s);
@@ -474,7 +484,8 @@ load_run(struct sks_s s[static 1], utectx_t ctx, strat_node_t nd)
 
 			/* the seeker should not give us trailing naughts */
 			assert(t->u);
-			assert((t->ttf & 0x30U) != 0x30U);
+			assert(!scom_thdr_widx_p(t) ||
+			       !scom_thdr_widx_p(scom_widx_tick(t)));
 			assert(thresh <= t->u);
 			thresh = t->u;
 			tsz = scom_tick_size(t);
@@ -551,7 +562,7 @@ step_run(struct sks_s s[static 1], utectx_t ctx, strat_t str, size_t j)
 	return 0;
 }
 
-void
+int
 ute_sort(utectx_t ctx)
 {
 	struct sks_s s[1];
@@ -570,7 +581,10 @@ ute_sort(utectx_t ctx)
 	 * we have several outcomes:
 	 * - merge k-way, where k is the number of pages
 	 * - merge k-way n-pass, where k < #pages in multiple passes */
-	str = sort_strat(ctx);
+	if (UNLIKELY((str = sort_strat(ctx)) == NULL)) {
+		/* leave CTX as is */
+		return -1;
+	}
 
 	/* get the highest CNT */
 	size_t nmaxpg = 0U;
@@ -599,8 +613,12 @@ ute_sort(utectx_t ctx)
 			 * maybe later */
 			oflags |= UO_ANON;
 		}
+		/* CTX keeps its inode, the sorted file gets a new one */
+		unlink(ctx->fname);
 		hdl = ute_open(ctx->fname, oflags);
 	}
+	/* checksummed files stay checksummed */
+	hdl->hdrc->flags |= ctx->hdrc->flags & UTEHDR_FLAG_CHECKSUM;
 
 	/* prepare the strategy */
 	if (load_run(s, ctx, str->curr = str->first) < 0) {
@@ -636,6 +654,14 @@ ute_sort(utectx_t ctx)
 	/* clone the slut */
 	ute_clone_slut(hdl, ctx);
 
+	/* CTX's page keys don't describe the sorted pages,
+	 * HDL keeps track of its own */
+	free(ctx->pgk->k);
+	ctx->pgk->k = NULL;
+	ctx->pgk->z = 0UL;
+	/* CTX's inode has been unlinked, spare it the checksumming */
+	ctx->oflags |= UO_ANON;
+
 	/* close the ute file */
 	ute_close(hdl);
 
@@ -643,7 +669,7 @@ ute_sort(utectx_t ctx)
 	free_strat(str);
 	free(s->sks);
 	free(s->pgbs);
-	return;
+	return 0;
 }
 
 /* utesort.c ends here */
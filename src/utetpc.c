@@ -120,10 +120,12 @@ tick_sortkey(scom_t t)
 static inline size_t
 __local_scom_tick_size(scom_t t)
 {
-	assert((t->ttf & 0x30U) != 0x30U);
-
 	if (!(scom_thdr_ttf(t) & (SCOM_FLAG_LM | SCOM_FLAG_L2M))) {
 		return 1UL;
+	} else if (scom_thdr_widx_p(t)) {
+		/* wide index sandwiches never come in pairs */
+		assert(!scom_thdr_widx_p(scom_widx_tick(t)));
+		return 1UL + __local_scom_tick_size(scom_widx_tick(t));
 	} else if (scom_thdr_ttf(t) & SCOM_FLAG_LM) {
 		return 2UL;
 	} else if (scom_thdr_ttf(t) & SCOM_FLAG_L2M) {
@@ -195,8 +197,8 @@ tpc_add(utetpc_t tpc, scom_t t, size_t nt)
 DEFUN void
 tpc_add_as(utetpc_t tpc, scom_t t, scom_t h, size_t nt)
 {
-/* supports variadic ticks */
-	uint64_t skey = tick_sortkey(t);
+/* supports variadic ticks, the key is what ends up on disk */
+	uint64_t skey = tick_sortkey(h);
 
 	if (UNLIKELY(tpc_full_p(tpc) || !tpc_can_hold_p(tpc, nt) || !skey)) {
 #if defined DEBUG_FLAG
@@ -239,6 +241,33 @@ tpc_add_as(utetpc_t tpc, scom_t t, scom_t h, size_t nt)
 	return;
 }
 
+DEFUN void
+tpc_add_run(utetpc_t tpc, scom_t t, size_t nt, scom_t last)
+{
+/* like tpc_add() for a whole run of sorted ticks */
+	uint64_t lkey = tick_sortkey(t);
+	uint64_t hkey = tick_sortkey(last);
+
+	if (UNLIKELY(!tpc_can_hold_p(tpc, nt) || !lkey)) {
+		UDEBUG("not adding run of %zu sandwiches\n", nt);
+		return;
+	}
+	memcpy(tpc->sk.sp + tpc->sk.si, t, nt * sizeof(*tpc->sk.sp));
+	tpc->sk.si += nt;
+
+	/* only the run's first tick can spoil the order */
+	if (UNLIKELY(lkey < tpc->last)) {
+		set_tpc_unsorted(tpc);
+	}
+	if (UNLIKELY(lkey < tpc->least)) {
+		set_tpc_needmrg(tpc);
+		tpc->least = lkey;
+	}
+	tpc->last = hkey;
+	return;
+}
+
+
 
 /* sorters */
 #include "scommon.h"
@@ -1071,7 +1100,8 @@ seek_sort(uteseek_t sk)
 
 			assert(t->u);
 			assert(t->u != -1ULL);
-			assert((t->ttf & 0x30U) != 0x30U);
+			assert(!scom_thdr_widx_p(t) ||
+			       !scom_thdr_widx_p(scom_widx_tick(t)));
 			assert(thresh <= t->u);
 			thresh = t->u;
 			tsz = scom_tick_size(t);
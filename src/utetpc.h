@@ -272,6 +272,11 @@ DECLF void tpc_add(utetpc_t tpc, scom_t t, size_t nt);
  * Like `tpc_add()' but copy the header from H. */
 DECLF void tpc_add_as(utetpc_t tpc, scom_t t, scom_t h, size_t nt);
 
+/**
+ * Add a sorted run of NT sandwiches starting at T to TPC.
+ * LAST points to the run's last tick. */
+DECLF void tpc_add_run(utetpc_t tpc, scom_t t, size_t nt, scom_t last);
+
 /* temporary */
 DECLF void seek_sort(uteseek_t);
 DECLF void tpc_sort(utetpc_t);
@@ -0,0 +1,100 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdio.h>
+#include <hdf5.h>
+
+/* print every numeric data set in an hdf5 file, one line per row
+ * of the innermost dimension, so hdf5 printer output can be diffed */
+
+static herr_t
+cat1(hid_t loc, const char *nam, const H5O_info_t *info, void *clo)
+{
+	hsize_t dims[H5S_MAX_RANK];
+	hid_t dat, spc, ty, dcpl;
+	hssize_t n;
+	int rank;
+	size_t ncol;
+	double *v;
+
+	(void)clo;
+	if (info->type != H5O_TYPE_DATASET) {
+		return 0;
+	} else if ((dat = H5Dopen(loc, nam, H5P_DEFAULT)) < 0) {
+		return -1;
+	}
+	ty = H5Dget_type(dat);
+	spc = H5Dget_space(dat);
+	rank = H5Sget_simple_extent_dims(spc, dims, NULL);
+	n = H5Sget_simple_extent_npoints(spc);
+
+	printf("%s", nam);
+	for (int i = 0; i < rank; i++) {
+		printf("%c%llu", i ? 'x' : '\t', (unsigned long long)dims[i]);
+	}
+	/* chunk layout and filters, so we know options made it through */
+	dcpl = H5Dget_create_plist(dat);
+	if (H5Pget_layout(dcpl) == H5D_CHUNKED) {
+		hsize_t chnk[H5S_MAX_RANK];
+		int nchnk = H5Pget_chunk(dcpl, H5S_MAX_RANK, chnk);
+		int nflt = H5Pget_nfilters(dcpl);
+
+		for (int i = 0; i < nchnk; i++) {
+			printf("%c%llu", i ? 'x' : '\t', (unsigned long long)chnk[i]);
+		}
+		for (int i = 0; i < nflt; i++) {
+			char fnam[64U];
+			unsigned int fl;
+			size_t ncd = 0U;
+
+			H5Pget_filter2(dcpl, i, &fl, &ncd, NULL,
+				       sizeof(fnam), fnam, NULL);
+			printf("\t%s", fnam);
+		}
+	}
+	H5Pclose(dcpl);
+	putchar('\n');
+
+	switch (H5Tget_class(ty)) {
+	case H5T_FLOAT:
+	case H5T_INTEGER:
+		break;
+	default:
+		/* only numbers */
+		goto out;
+	}
+
+	ncol = rank > 0 && dims[rank - 1] ? dims[rank - 1] : 1U;
+	if (n > 0 && (v = malloc(n * sizeof(*v))) != NULL) {
+		H5Dread(dat, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, v);
+		for (hssize_t i = 0; i < n; i++) {
+			printf("%.6f%c", v[i], (i + 1) % ncol ? '\t' : '\n');
+		}
+		free(v);
+	}
+out:
+	H5Sclose(spc);
+	H5Tclose(ty);
+	H5Dclose(dat);
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	hid_t fil;
+	int rc;
+
+	if (argc < 2) {
+		fputs("Usage: h5cat FILE\n", stderr);
+		return 1;
+	} else if ((fil = H5Fopen(argv[1], H5F_ACC_RDONLY, H5P_DEFAULT)) < 0) {
+		return 1;
+	}
+	rc = H5Ovisit(fil, H5_INDEX_NAME, H5_ITER_INC, cat1, NULL) < 0;
+	H5Fclose(fil);
+	return rc;
+}
+
+/* h5cat.c ends here */
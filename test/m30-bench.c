@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define DEFINE_GORY_STUFF
+#include "m30.h"
+#include "m62.h"
+
+/* numbers/second of the m30 and m62 readers, word-wise and digit-wise,
+ * over a column of prices as they'd appear in tick files */
+
+#define NNUM	(4000000U)
+#define NRUN	(5U)
+
+static double
+now(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return (double)tsp.tv_sec + (double)tsp.tv_nsec * 1e-9;
+}
+
+static char*
+mkcol(size_t n)
+{
+/* N tab-terminated numbers of varying shape */
+	char *col = malloc(n * 24U + 1U);
+	char *cp = col;
+
+	if (col == NULL) {
+		return NULL;
+	}
+	for (size_t i = 0; i < n; i++) {
+		switch (i % 4U) {
+		case 0:
+			cp += sprintf(cp, "1.%05zu\t", i % 100000U);
+			break;
+		case 1:
+			cp += sprintf(cp, "%zu.%02zu\t", i % 10000U, i % 100U);
+			break;
+		case 2:
+			cp += sprintf(cp, "%zu\t", i % 1000000U);
+			break;
+		case 3:
+			cp += sprintf(cp, "%zu.%08zu\t", i % 100U, i);
+			break;
+		}
+	}
+	*cp = '\0';
+	return col;
+}
+
+#define BENCH(name, type, fn)						\
+static void								\
+name(const char *col)							\
+{									\
+	double best = 1e9;						\
+	uint64_t sum = 0U;						\
+									\
+	for (size_t r = 0; r < NRUN; r++) {				\
+		const double t = now();					\
+									\
+		for (const char *p = col; *p; p++) {			\
+			type x = fn(&p);				\
+			sum += x.u;					\
+		}							\
+		if (now() - t < best) {					\
+			best = now() - t;				\
+		}							\
+	}								\
+	printf("%s\t%.3f s\t%.0f numbers/s\t(%llx)\n", #fn, best,	\
+	       NNUM / best, (unsigned long long int)sum);		\
+	return;								\
+}
+
+BENCH(b30, m30_t, ffff_m30_get_s)
+BENCH(b30sc, m30_t, __ffff_m30_get_s_sc)
+BENCH(b62, m62_t, ffff_m62_get_s)
+BENCH(b62sc, m62_t, __ffff_m62_get_s_sc)
+
+int
+main(void)
+{
+	char *col;
+
+	if ((col = mkcol(NNUM)) == NULL) {
+		perror("cannot create number column");
+		return 1;
+	}
+	b30(col);
+	b30sc(col);
+	b62(col);
+	b62sc(col);
+	free(col);
+	return 0;
+}
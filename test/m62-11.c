@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define DEFINE_GORY_STUFF
+#include "m62.h"
+
+#if !defined countof
+# define countof(x)	(sizeof(x) / sizeof(*x))
+#endif	/* !countof */
+
+/* the word-wise readers must agree with the digit-by-digit ones,
+ * strings are put at the very end of a page followed by an unmapped
+ * one so that reading past the number would crash us */
+
+static char *page;
+static size_t pgsz;
+static unsigned int nfail;
+
+static void
+check_at(char *s, const char *str)
+{
+	const char *p, *q;
+	m62_t x, y;
+
+	p = q = s;
+	x = ffff_m62_get_s(&p);
+	y = __ffff_m62_get_s_sc(&q);
+	if (x.u != y.u || p != q) {
+		fprintf(stderr, "get_s(\"%s\") %llx %zd  v  %llx %zd\n",
+			str, (unsigned long long int)x.u, p - s,
+			(unsigned long long int)y.u, q - s);
+		nfail++;
+	}
+	return;
+}
+
+static void
+check(const char *str, char term)
+{
+	const size_t len = strlen(str);
+	char *s;
+
+	/* put STR plus terminator flush against the guard page */
+	s = page + pgsz - len - 1U;
+	memcpy(s, str, len);
+	s[len] = term;
+	check_at(s, str);
+
+	/* and somewhere in the middle, followed by more digits */
+	s = page + 64U + len % 8U;
+	memcpy(s, str, len);
+	s[len] = term;
+	memset(s + len + 1U, '7', 16U);
+	check_at(s, str);
+	return;
+}
+
+static void
+fill(char *tgt, size_t n, unsigned int how)
+{
+	static const char pat[] = "0123456789";
+
+	for (size_t i = 0; i < n; i++) {
+		switch (how) {
+		case 0:
+			tgt[i] = '9';
+			break;
+		case 1:
+			tgt[i] = '0';
+			break;
+		case 2:
+			/* rounding digits */
+			tgt[i] = (i == 4U || i == 8U) ? '5' : '4';
+			break;
+		default:
+			tgt[i] = pat[random() % 10U];
+			break;
+		}
+	}
+	return;
+}
+
+int
+main(void)
+{
+	static const char *const sgn[] = {"", "-", "+"};
+	static const char term[] = "\0\t ,\n";
+	char buf[64U];
+
+	pgsz = sysconf(_SC_PAGESIZE);
+	if ((page = mmap(NULL, 2U * pgsz, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+		perror("cannot map pages");
+		return 1;
+	} else if (mprotect(page + pgsz, pgsz, PROT_NONE) < 0) {
+		perror("cannot protect guard page");
+		return 1;
+	}
+	srandom(17);
+
+	/* all shapes of integral and fractional parts, -1 is no point */
+	for (size_t s = 0; s < countof(sgn); s++) {
+		for (int ni = 0; ni <= 28; ni++) {
+			for (int nf = -1; nf <= 20; nf++) {
+				for (unsigned int how = 0; how < 16U; how++) {
+					char *bp = stpcpy(buf, sgn[s]);
+
+					fill(bp, ni, how);
+					bp += ni;
+					if (nf >= 0) {
+						*bp++ = '.';
+						fill(bp, nf, how);
+						bp += nf;
+					}
+					*bp = '\0';
+					check(buf, term[how % 5U]);
+				}
+			}
+		}
+	}
+
+	/* all the small prices */
+	for (unsigned int i = 0; i < 1000000U; i++) {
+		snprintf(buf, sizeof(buf), "%u.%04u", i / 10000U, i % 10000U);
+		check(buf, '\t');
+		snprintf(buf, sizeof(buf), "%u", i);
+		check(buf, '\0');
+	}
+
+	if (nfail) {
+		fprintf(stderr, "%u mismatches\n", nfail);
+		return 1;
+	}
+	munmap(page, 2U * pgsz);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+/* print the double matrices of a level 5 mat file in host byte order,
+ * the name and dimensions first, then one line per row */
+
+#define miINT8		(1)
+#define miINT32		(5)
+#define miDOUBLE	(9)
+#define miMATRIX	(14)
+
+static const char*
+get_elem(const char **p, const char *ep, uint32_t *dty, uint32_t *nby)
+{
+/* read the tag at *P, return the element's data or NULL
+ * and put *P behind the element */
+	const char *d;
+	uint32_t tag[2U];
+
+	if (*p + sizeof(tag) > ep) {
+		return NULL;
+	}
+	memcpy(tag, *p, sizeof(tag));
+	if (tag[0U] >> 16U) {
+		/* small data element, data in the tag itself */
+		*dty = tag[0U] & 0xffffU;
+		*nby = tag[0U] >> 16U;
+		d = *p + 4U;
+		*p += sizeof(tag);
+		return d;
+	}
+	*dty = tag[0U];
+	*nby = tag[1U];
+	if ((d = *p + sizeof(tag)) + *nby > ep) {
+		return NULL;
+	}
+	/* elements are padded to 8 bytes */
+	*p = d + ((*nby + 7U) & ~7U);
+	return d;
+}
+
+static int
+cat1(const char *p, const char *ep)
+{
+/* print matrix P ... EP */
+	uint32_t dty, nby;
+	uint32_t dim[2U] = {0U, 0U};
+	const char *d;
+
+	/* array flags */
+	if ((d = get_elem(&p, ep, &dty, &nby)) == NULL) {
+		return -1;
+	}
+	/* dimensions */
+	if ((d = get_elem(&p, ep, &dty, &nby)) == NULL ||
+	    dty != miINT32 || nby != sizeof(dim)) {
+		return -1;
+	}
+	memcpy(dim, d, sizeof(dim));
+	/* name */
+	if ((d = get_elem(&p, ep, &dty, &nby)) == NULL ||
+	    dty != miINT8) {
+		return -1;
+	}
+	printf("%.*s\t%ux%u\n", (int)nby, d, dim[0U], dim[1U]);
+	/* real part */
+	if ((d = get_elem(&p, ep, &dty, &nby)) == NULL ||
+	    dty != miDOUBLE ||
+	    nby < (size_t)dim[0U] * dim[1U] * sizeof(double)) {
+		return -1;
+	}
+	/* column major */
+	for (size_t i = 0U; i < dim[0U]; i++) {
+		for (size_t j = 0U; j < dim[1U]; j++) {
+			double v;
+
+			memcpy(&v, d + (j * dim[0U] + i) * sizeof(v), sizeof(v));
+			printf("%.6f%c", v, j + 1U < dim[1U] ? '\t' : '\n');
+		}
+	}
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *buf;
+	const char *p;
+	const char *ep;
+	size_t z;
+	FILE *f;
+	int rc = 0;
+
+	if (argc < 2) {
+		fputs("Usage: matcat FILE\n", stderr);
+		return 1;
+	} else if ((f = fopen(argv[1], "rb")) == NULL) {
+		return 1;
+	}
+	fseek(f, 0L, SEEK_END);
+	z = ftell(f);
+	rewind(f);
+	if ((buf = malloc(z)) == NULL || fread(buf, 1U, z, f) < z) {
+		fclose(f);
+		free(buf);
+		return 1;
+	}
+	fclose(f);
+
+	/* skip the 128 byte header */
+	for (p = buf + 128U, ep = buf + z; p < ep && !rc;) {
+		uint32_t dty, nby;
+		const char *d;
+
+		if ((d = get_elem(&p, ep, &dty, &nby)) == NULL) {
+			rc = 1;
+		} else if (dty == miMATRIX && cat1(d, d + nby) < 0) {
+			rc = 1;
+		}
+	}
+	free(buf);
+	return rc;
+}
+
+/* matcat.c ends here */
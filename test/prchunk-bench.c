@@ -0,0 +1,162 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "prchunk.h"
+
+/* lines/second of the prchunk reader, once for a regular file
+ * and once for the same file through a pipe, then tab-separated fields
+ * by strchr() over each line and by the structural index */
+
+static double
+now(void)
+{
+	struct timespec tsp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tsp);
+	return (double)tsp.tv_sec + (double)tsp.tv_nsec * 1e-9;
+}
+
+static int
+mkfile(const char *fn, size_t nlines)
+{
+	FILE *f;
+
+	if ((f = fopen(fn, "w")) == NULL) {
+		return -1;
+	}
+	for (size_t i = 0; i < nlines; i++) {
+		fprintf(f, "2011-03-17T%02zu:%02zu:%02zu.%03zu\t%zx\t%x\t"
+			"b\t1.%05zu\t%zu\n",
+			(i / 3600000U) % 24U, (i / 60000U) % 60U,
+			(i / 1000U) % 60U, i % 1000U, i % 7U + 1U, 0x0c,
+			i % 100000U, i % 1000U);
+	}
+	return fclose(f);
+}
+
+static size_t
+count(int fd, int how, size_t *nf)
+{
+/* HOW is 0 for lines only, 1 for fields by strchr(), 2 for indexed fields */
+	prch_ctx_t ctx;
+	size_t nl = 0U;
+
+	if ((ctx = init_prchunk(fd)) == NULL) {
+		return 0U;
+	} else if (how == 2) {
+		prchunk_set_delim(ctx, '\t');
+	}
+	*nf = 0U;
+	while (!(prchunk_fill(ctx) < 0)) {
+		char *l[1];
+		const uint32_t *fo;
+
+		while (prchunk_haslinep(ctx)) {
+			(void)prchunk_getline(ctx, l);
+			nl++;
+			switch (how) {
+			case 1:
+				for (const char *p = *l;
+				     (p = strchr(p, '\t')) != NULL; p++) {
+					++*nf;
+				}
+				break;
+			case 2:
+				*nf += prchunk_getfo(ctx, &fo);
+				break;
+			}
+		}
+	}
+	free_prchunk(ctx);
+	return nl;
+}
+
+static void
+report(const char *mode, size_t nl, double t)
+{
+	printf("%s\t%zu lines\t%.3f s\t%.0f lines/s\n", mode, nl, t, nl / t);
+	return;
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *fn = "prchunk-bench.txt";
+	size_t nl;
+	size_t nf[2];
+	double t;
+	int fd;
+	int pp[2];
+	pid_t kid;
+
+	if (argc > 1) {
+		fn = argv[1];
+	} else if (mkfile(fn, 4000000U) < 0) {
+		perror("cannot create test file");
+		return 1;
+	}
+
+	/* straight from the file */
+	if ((fd = open(fn, O_RDONLY)) < 0) {
+		perror("cannot open test file");
+		return 1;
+	}
+	t = now();
+	nl = count(fd, 0, nf);
+	report("file", nl, now() - t);
+	close(fd);
+
+	/* feed the file through a pipe */
+	if (pipe(pp) < 0) {
+		return 1;
+	}
+	switch ((kid = fork())) {
+	case -1:
+		return 1;
+	case 0:
+		close(pp[0]);
+		if ((fd = open(fn, O_RDONLY)) >= 0) {
+			char buf[65536U];
+			ssize_t nrd;
+
+			while ((nrd = read(fd, buf, sizeof(buf))) > 0 &&
+			       write(pp[1], buf, nrd) == nrd);
+		}
+		_exit(0);
+	default:
+		close(pp[1]);
+		break;
+	}
+	t = now();
+	nl = count(pp[0], 0, nf);
+	report("pipe", nl, now() - t);
+	close(pp[0]);
+	waitpid(kid, NULL, 0);
+
+	/* fields, the old-fashioned way and indexed */
+	for (int how = 1; how <= 2; how++) {
+		if ((fd = open(fn, O_RDONLY)) < 0) {
+			return 1;
+		}
+		t = now();
+		nl = count(fd, how, nf + how - 1);
+		report(how == 1 ? "strchr" : "indexed", nl, now() - t);
+		close(fd);
+	}
+	if (nf[0U] != nf[1U]) {
+		fprintf(stderr, "field counts differ: %zu vs %zu\n",
+			nf[0U], nf[1U]);
+		return 1;
+	}
+	return 0;
+}
+
+/* prchunk-bench.c ends here */
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "date.h"
+#include "utefile.h"
+#include "ute-print.h"
+
+/* the cached stamp printers must agree with a fresh
+ * gmtime()/strftime() for every stamp, no matter whether
+ * they come in order, jump days back and forth or change the separator,
+ * the hex printers must agree with printf() */
+
+static unsigned int nfail;
+/* just for its stamp cache */
+static struct pr_ctx_s pctx[1U];
+
+static void
+check_ts(uint32_t s, unsigned int ms, char sep)
+{
+	char exp[32U];
+	char got[32U];
+	struct tm tm;
+
+	ffff_gmtime(&tm, s);
+	ffff_strftime(exp, sizeof(exp), &tm, sep);
+	snprintf(exp + 19U, sizeof(exp) - 19U, ".%03u+00:00", ms);
+	got[pr_tsmstz_ctx(pctx, got, s, ms, NULL, sep)] = '\0';
+	if (strcmp(exp, got)) {
+		fprintf(stderr, "stamp %u.%03u: expected %s got %s\n",
+			s, ms, exp, got);
+		nfail++;
+	}
+	got[pr_tsmstz(got, s, ms, NULL, sep)] = '\0';
+	if (strcmp(exp, got)) {
+		fprintf(stderr, "stamp %u.%03u uncached: expected %s got %s\n",
+			s, ms, exp, got);
+		nfail++;
+	}
+	return;
+}
+
+static void
+check_hex(uint32_t v)
+{
+	char exp[16U];
+	char got[16U];
+
+	snprintf(exp, sizeof(exp), "%x", v);
+	got[prfmt_hex(got, v)] = '\0';
+	if (strcmp(exp, got)) {
+		fprintf(stderr, "%%x of %u: expected %s got %s\n", v, exp, got);
+		nfail++;
+	}
+	snprintf(exp, sizeof(exp), "%08x", v);
+	got[prfmt_hex8(got, v)] = '\0';
+	if (strcmp(exp, got)) {
+		fprintf(stderr, "%%08x of %u: expected %s got %s\n",
+			v, exp, got);
+		nfail++;
+	}
+	return;
+}
+
+int
+main(void)
+{
+	/* across a midnight and a leap day, in steps of odd seconds */
+	for (uint32_t s = 1330473000U; s < 1330560000U; s += 37U) {
+		check_ts(s, s % 1000U, 'T');
+		check_ts(s, s % 1000U, 'T');
+	}
+	/* jumping back and forth, with the separator changing */
+	for (unsigned int i = 0U; i < 100000U; i++) {
+		uint32_t s = (uint32_t)rand() % 4102444800U;
+
+		check_ts(s, i % 1000U, (char)(i % 3U ? 'T' : ' '));
+		check_ts(s + 1U, i % 1000U, 'T');
+	}
+	check_ts(0U, 0U, 'T');
+	check_ts(86399U, 999U, 'T');
+	check_ts(86400U, 0U, 'T');
+
+	for (uint32_t v = 0U; v < 0x10000U; v++) {
+		check_hex(v);
+	}
+	check_hex(0xffffffffU);
+	check_hex(0x10000000U);
+	check_hex(0x0fffffffU);
+	return nfail > 0U;
+}
+
+/* prfmt-1.c ends here */
@@ -0,0 +1,47 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "utefile.h"
+#include "scommon.h"
+
+/* replay the ticks of IN into OUT like a capture would, in stream mode,
+ * given N stop after N ticks and leave OUT growing as it is */
+int
+main(int argc, char *argv[])
+{
+	const int ofl = UO_RDWR | UO_CREAT | UO_TRUNC | UO_STREAM;
+	utectx_t in;
+	utectx_t out;
+	size_t n = 0U;
+
+	if (argc < 3) {
+		fputs("Usage: stream-03 IN OUT [N]\n", stderr);
+		return 1;
+	} else if ((in = ute_open(argv[1], UO_RDONLY)) == NULL) {
+		return 1;
+	} else if ((out = ute_open(argv[2], ofl)) == NULL) {
+		ute_close(in);
+		return 1;
+	} else if (argc > 3) {
+		n = strtoul(argv[3], NULL, 10);
+	}
+
+	for (scom_t ti; (ti = ute_iter(in)) != NULL;) {
+		const char *sym = ute_idx2sym(in, scom_thdr_tblidx(ti));
+
+		ute_add_tick_idx(out, ti, ute_sym2idx(out, sym));
+		if (n > 0U && --n == 0U) {
+			/* the capture's still running as far as readers know */
+			_exit(0);
+		}
+	}
+
+	ute_close(out);
+	ute_close(in);
+	return 0;
+}
+
+/* stream-03.c ends here */
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "tzraw.h"
+
+/* cursors and the zif's own cache must give the same answers as a
+ * fresh search of the transitions, for stamps in order, out of order,
+ * in batches and across DST switches */
+
+static unsigned int nfail;
+
+static int32_t
+local_ref(zif_t z, int32_t t)
+{
+	return t + zif_find_zrng(z, t).offs;
+}
+
+static int32_t
+utc_ref(zif_t z, int32_t t)
+{
+/* the fixed point iteration of zif_utc_time() without any caching */
+	int32_t xi = 0;
+	int32_t xj;
+	int32_t old = -1;
+
+	while ((xj = zif_find_zrng(z, t - xi).offs) != xi && xi != old) {
+		old = xi = xj;
+	}
+	return t - xj;
+}
+
+static void
+check(const char *what, int32_t t, int32_t exp, int32_t got)
+{
+	if (exp != got) {
+		fprintf(stderr, "%s of %d: expected %d got %d\n",
+			what, t, exp, got);
+		nfail++;
+	}
+	return;
+}
+
+static int
+check_zone(const char *zn)
+{
+	/* 1990 to 2030 */
+	static const int32_t from = 631152000, till = 1893456000;
+	static int32_t src[65536U], tgt[65536U];
+	struct zcur_s c[1U];
+	zif_t z;
+	size_t n = 0U;
+
+	if ((z = zif_open(zn)) == NULL) {
+		return 0;
+	}
+
+	/* in order, in minute steps during the small hours (UTC) */
+	zif_cur_init(c, z);
+	for (int32_t t = from; t < till; t += 3593) {
+		for (int32_t u = t; u < t + 3593;
+		     u += t % 86400 < 7200 ? 61 : 3593) {
+			check("cur local", u, local_ref(z, u), zif_cur_local_time(c, u));
+			check("local", u, local_ref(z, u), zif_local_time(z, u));
+			check("cur utc", u, utc_ref(z, u), zif_cur_utc_time(c, u));
+			check("utc", u, utc_ref(z, u), zif_utc_time(z, u));
+			if (n < sizeof(src) / sizeof(*src)) {
+				src[n++] = u;
+			}
+		}
+	}
+
+	/* batches, sorted and in place */
+	zif_cur_init(c, z);
+	zif_cur_local_times(c, tgt, src, n);
+	for (size_t i = 0U; i < n; i++) {
+		check("batch local", src[i], local_ref(z, src[i]), tgt[i]);
+	}
+
+	/* all over the place */
+	for (unsigned int i = 0U; i < 100000U; i++) {
+		int32_t t = from + rand() % (till - from);
+
+		check("jumpy local", t, local_ref(z, t), zif_cur_local_time(c, t));
+		check("jumpy utc", t, utc_ref(z, t), zif_cur_utc_time(c, t));
+		check("jumpy utc", t, utc_ref(z, t), zif_utc_time(z, t));
+	}
+	zif_cur_local_times(c, tgt, src, 1000U);
+	for (size_t i = 0U; i < 1000U; i++) {
+		check("batch local", src[i], local_ref(z, src[i]), tgt[i]);
+	}
+	zif_close(z);
+	return 1;
+}
+
+int
+main(void)
+{
+	int nz = 0;
+
+	nz += check_zone("Europe/Berlin");
+	nz += check_zone("America/New_York");
+	nz += check_zone("Australia/Sydney");
+	if (!nz) {
+		/* no zoneinfo files, skip */
+		return 77;
+	}
+	return nfail > 0U;
+}
+
+/* tzraw-1.c ends here */